@@ -6,7 +6,26 @@
 #include "hardware/adc.h"
 #include "hardware/i2c.h"
 #include "hardware/pwm.h"
-#include "inc/ssd1306_i2c.h"
+#include "hardware/structs/systick.h"
+#include "inc/alarme.h"
+#include "inc/aquisicao.h"
+#include "inc/bandas.h"
+#include "inc/botoes.h"
+#include "inc/buzzer.h"
+#include "inc/calibracao.h"
+#include "inc/configuracoes.h"
+#include "inc/fft.h"
+#include "inc/goertzel.h"
+#include "inc/medicoes.h"
+#include "inc/regras.h"
+#include "inc/relogio.h"
+#include "inc/ssd1306.h"
+#include "inc/servidor_http.h"
+#include "inc/ssd1306_governor.h"
+#include "inc/telemetria.h"
+#include "inc/usb_audio.h"
+#include "inc/usb_fluxo.h"
+#include "pico/multicore.h"
 #include "pico/stdlib.h"
 
 // ==========================================================================
@@ -60,90 +79,306 @@
 #define I2C_SDA 14
 #define I2C_SCL 15
 
+// Índices dos botões no módulo de botões
+#define ID_BOTAO_A 0
+#define ID_BOTAO_B 1
+
 // Parâmetros do Sistema
 #define LIMITE_DB 100.0
-#define CALIBRACAO 0.00002f
-#define AMOSTRAS 64
+#define CALIBRACAO 0.00002f  // Referência de 0 dB SPL (20 uPa)
+#define DC_SHIFT 10  // Filtro do offset DC: corte em taxa / (2 * pi * 2^10)
+#define CALIBRADOR_DB 94.0f    // Nível do calibrador de referência (1 kHz)
+#define CALIBRACAO_JANELAS 24  // Janelas integradas na calibração
+#define CALIBRACAO_EXIBIR_MS 3000  // Tempo exibindo o resultado
 #define TAMANHO_HISTORICO 128
 #define UPDATE_INTERVAL_MS 30
+// Janela de integração de cada leitura de dB (ms); pode ser definida na
+// compilação, assim como AQ_TAXA_PADRAO_HZ
+#ifndef JANELA_MS
+#define JANELA_MS 125
+#endif
+// Conversões do ADC somadas em cada amostra de áudio (1, 2, 4, 8 ou 16): o
+// ADC roda SOBREAMOSTRAGEM vezes mais rápido e a soma ganha resolução abaixo
+// de 1 LSB, o que importa nos níveis baixos (30 a 45 dB)
+#ifndef SOBREAMOSTRAGEM
+#define SOBREAMOSTRAGEM 4
+#endif
+// Pontos da FFT do modo espectro: 2^FFT_LOG2 (256 a 1024)
+#define FFT_LOG2 10
+#define FFT_PONTOS (1 << FFT_LOG2)
+#define ESPECTRO_FAIXA_DB 80.0f  // Faixa dinâmica das barras do espectro
+// Frequências (Hz) dos bipes de equipamentos vigiadas pelos detectores de tom
+#define FREQUENCIAS_TONS {500.0f, 1000.0f, 2000.0f, 2500.0f, 3000.0f}
 
 // Variáveis Globais
 volatile float limite_atual_db =
     LIMITE_DB;  // Limite de ruído para disparo do alerta (dB)
-enum Modo { MONITORAMENTO, ALERTA, ESTATISTICAS } modo_atual = MONITORAMENTO;
+enum Modo {
+  MONITORAMENTO,
+  ALERTA,
+  ESTATISTICAS,
+  ESPECTRO,
+  CALIBRACAO_MIC,
+  CARACTERIZACAO_RUIDO
+} modo_atual = MONITORAMENTO;
 float historico[TAMANHO_HISTORICO];  // Histórico de níveis (dB)
 uint8_t indice_historico = 0;        // Índice do histórico
 
 // Variável para contar quantas vezes o alerta máximo foi acionado
 unsigned int contador_alertas = 0;
 
+// Regras de alerta em ordem de prioridade (inc/regras.h): o aviso na tela e o
+// padrão do buzzer são os da primeira regra em alerta. "Nivel maximo" segue o
+// limite ajustado nos botões; as regras com horário (hora local, em minutos)
+// só valem depois que o relógio é acertado pelo Wi-Fi (SNTP)
+static const regra_definicao_t regras_alerta[] = {
+    // nome, métrica, janela (s), limite (dB), início e fim, histerese (dB),
+    // duração mínima e retenção (ms), buzzer
+    {"Nivel maximo", REGRA_INSTANTANEO, 0, REGRA_LIMITE_AJUSTAVEL, 0, 0, 3.0f,
+     1000, 3000, REGRA_BUZZER_URGENCIA},
+    {"Pico", REGRA_INSTANTANEO, 0, 85.0f, 0, 0, 3.0f, 0, 2000,
+     REGRA_BUZZER_SIRENE},
+    {"Leq noite 1m", REGRA_LEQ, 60, 35.0f, 22 * 60, 7 * 60, 1.0f, 0, 10000,
+     REGRA_BUZZER_LENTO},
+    {"Leq dia 1m", REGRA_LEQ, 60, 45.0f, 7 * 60, 22 * 60, 1.0f, 0, 10000,
+     REGRA_BUZZER_LENTO},
+};
+regras_t regras;
+
+// Sequências do buzzer de cada padrão (regra_buzzer_t), tocadas pelo
+// sequenciador por interrupção (inc/buzzer.h). Passos: frequência inicial e
+// final (Hz, 0 = silêncio) e duração (ms)
+static const buzzer_passo_t passos_continuo[] = {{2500, 2500, 1000}};
+static const buzzer_passo_t passos_lento[] = {{2500, 2500, 500},
+                                              {0, 0, 500}};
+static const buzzer_passo_t passos_rapido[] = {{3000, 3000, 120},
+                                               {0, 0, 180}};
+static const buzzer_passo_t passos_sirene[] = {{1500, 3000, 400},
+                                               {3000, 1500, 400}};
+// Três bipes espaçados, quatro mais próximos e então bipes rápidos sem fim
+static const buzzer_passo_t passos_urgencia[] = {
+    {2500, 2500, 200}, {0, 0, 800}, {2500, 2500, 200}, {0, 0, 800},
+    {2500, 2500, 200}, {0, 0, 800}, {2800, 2800, 150}, {0, 0, 350},
+    {2800, 2800, 150}, {0, 0, 350}, {2800, 2800, 150}, {0, 0, 350},
+    {2800, 2800, 150}, {0, 0, 350}, {3200, 3200, 100}, {0, 0, 100},
+};
+#define SEQUENCIA(passos, repetir_de) {passos, count_of(passos), repetir_de}
+static const buzzer_sequencia_t sequencias_buzzer[] = {
+    [REGRA_BUZZER_CONTINUO] = SEQUENCIA(passos_continuo, 0),
+    [REGRA_BUZZER_LENTO] = SEQUENCIA(passos_lento, 0),
+    [REGRA_BUZZER_RAPIDO] = SEQUENCIA(passos_rapido, 0),
+    [REGRA_BUZZER_SIRENE] = SEQUENCIA(passos_sirene, 0),
+    [REGRA_BUZZER_URGENCIA] = SEQUENCIA(passos_urgencia, 14),
+};
+
+// Resumo do minuto corrente para o log de medições na flash
+uint32_t minuto_atual = 0;        // Minutos desde o boot
+double energia_minuto = 0.0;      // Soma de 10^(dB/10) das janelas
+uint32_t janelas_minuto = 0;
+float lmax_minuto = 0.0f;
+unsigned int alertas_inicio_minuto = 0;
+
+// Janela de integração em amostras (JANELA_MS na taxa atual)
+uint32_t amostras_janela = 0;
+// log2 do fator de sobreamostragem aplicado pelo motor de aquisição
+int bits_sobreamostragem = 0;
+// Offset DC da entrada em contagens << 16 (negativo até a primeira amostra)
+int32_t offset_dc_q16 = -1;
+
+// Banco de filtros de terço de oitava e Leq de cada banda na última janela
+bandas_t bandas;
+float leq_bandas[BANDAS_MAX];
+
+// Calibração: o ganho gravado na flash e as constantes de conversão do ADC
+// (3,3 V / 4096, ganho de 10x, referência de 20 uPa) são dobrados num único
+// termo somado ao nível em dB uma vez por janela, de modo que o laço por
+// amostra só trabalha com inteiros. O piso de ruído do ADC, medido em
+// repouso, é subtraído em energia da média dos quadrados de cada janela
+calibracao_registro_t calibracao_mic;  // Registro gravado na flash
+float escala_base_db;  // Unidade interna (contagens << 2) -> dB SPL
+float escala_db;       // escala_base_db + ganho de calibração
+float ruido_quadratico = 0.0f;  // Piso na sobreamostragem atual (0 = nenhum)
+float nivel_minimo_db = 30.0f;  // Menor nível exibido
+float media_quadrados_janela = 0.0f;  // Última janela, em unidade interna
+
+// Estado do modo de calibração
+enum Modo modo_antes_calibracao = MONITORAMENTO;
+int janelas_calibracao = 0;
+double soma_calibracao = 0.0;
+bool calibracao_concluida = false;
+uint32_t fim_calibracao_ms = 0;
+char texto_calibracao[20];
+
+// Modo espectro: blocos acumulados para a FFT e resultado para o display
+int16_t fft_re[FFT_PONTOS], fft_im[FFT_PONTOS];
+uint32_t fft_potencia_raias[FFT_PONTOS / 2];
+int fft_preenchidas = 0;
+uint8_t espectro_barras[ssd1306_width];  // Altura de cada coluna (pixels)
+float espectro_pico_hz = 0.0f;
+uint32_t ciclos_fft = 0;  // Ciclos de CPU da última FFT (SysTick)
+
+// Detectores de Goertzel para alarmes tonais (contados à parte do ruído)
+goertzel_banco_t tons;
+
+ssd1306_t display;  // Display OLED principal (i2c1, endereço 0x3C)
+bool display_presente = false;  // O painel respondeu na inicialização
+ssd1306_governor_t governador;  // Controle da taxa de atualização do display
+ssd1306_i2c_calibration_t calibracao_i2c;  // Clock escolhido para o display
+
 // Protótipos de Funções
 void inicializar_hardware();
-float ler_decibeis();
-void atualizar_display(float db, uint8_t *display_buffer);
+void nucleo1_principal();
+void configurar_medicao(uint32_t taxa_hz, uint32_t janela_ms);
+void atualizar_escala();
+void iniciar_calibracao(enum Modo modo);
+void processar_calibracao();
+void processar_caracterizacao();
+bool ler_decibeis(float *db);
+float banda_dominante();
+void alimentar_espectro(const int16_t *amostras, int n);
+void desenhar_espectro(ssd1306_t *ssd);
+void atualizar_display(float db, ssd1306_t *ssd);
 void verificar_botoes();
-void acionar_buzzer(bool estado);
+void avaliar_alarme(float db);
+void enviar_estado_usb();
+void acionar_buzzer(const regra_t *regra);
 void atualizar_historico(float db);
-void desenhar_grafico(uint8_t *buffer);
+void registrar_minuto(float db);
+void carregar_configuracoes();
+void salvar_configuracoes();
+void desenhar_grafico(ssd1306_t *ssd);
 void verificar_joystick();
-void exibir_texto(uint8_t *buffer, struct render_area *area, char *lines[],
-                  int num_lines);
+void exibir_texto(ssd1306_t *ssd, char *lines[], int num_lines);
 float obter_valor_maximo(float *array, int size);
 
 int main() {
   stdio_init_all();
   inicializar_hardware();
 
-  struct render_area area_total = {.start_column = 0,
-                                   .end_column = ssd1306_width - 1,
-                                   .start_page = 0,
-                                   .end_page = ssd1306_n_pages - 1};
-  calculate_render_area_buffer_length(&area_total);
+  // Calibra o clock do i2c e informa o resultado na mensagem inicial (e no
+  // pacote de estado da USB, que também avisa se o display não respondeu)
+  if (display_presente) {
+    ssd1306_calibrate_i2c(&display, ssd1306_i2c_clock, ssd1306_i2c_clock_max,
+                          ssd1306_i2c_clock_step, &calibracao_i2c);
 
-  uint8_t display_buffer[ssd1306_buffer_length];
-  memset(display_buffer, 0, ssd1306_buffer_length);
+    // Mensagem inicial
+    char texto_i2c[20], texto_fps[20];
+    snprintf(texto_i2c, sizeof(texto_i2c), "I2C %lu kHz",
+             (unsigned long)(calibracao_i2c.baudrate / 1000));
+    snprintf(texto_fps, sizeof(texto_fps), "%.0f FPS", calibracao_i2c.fps);
+    char *inicio[] = {"Sistema Ativo", "v5.0", texto_i2c, texto_fps};
+    exibir_texto(&display, inicio, 4);
+    ssd1306_send_data(&display);
+    sleep_ms(500);
+  }
 
-  // Mensagem inicial
-  char *inicio[] = {"Sistema Ativo", "v5.0"};
-  exibir_texto(display_buffer, &area_total, inicio, 2);
-  render_on_display(display_buffer, &area_total);
-  sleep_ms(500);
+  ssd1306_governor_init(&governador, ssd1306_governor_min_ms,
+                        ssd1306_governor_max_ms, ssd1306_governor_busy_max);
 
   // Loop principal: leitura dos sensores e atualização do display
+  float db = 30.0f;
   while (true) {
-    float db = ler_decibeis();  // Lê o nível de ruído (dB)
-    atualizar_historico(db);    // Atualiza histórico de leituras
+    // Lê o nível de ruído (dB) quando uma janela de medição é concluída
+    if (ler_decibeis(&db)) {
+      atualizar_historico(db);  // Atualiza histórico de leituras
+      avaliar_alarme(db);       // Regras de alerta
+      registrar_minuto(db);     // Resume o minuto para o log na flash
+      if (modo_atual != CALIBRACAO_MIC && modo_atual != CARACTERIZACAO_RUIDO) {
+        telemetria_janela(db, contador_alertas);  // Resumo por segundo (Wi-Fi)
+        servidor_http_janela(db, contador_alertas);  // Dados do HTTP
+      }
+      if (modo_atual == CALIBRACAO_MIC) processar_calibracao();
+      if (modo_atual == CARACTERIZACAO_RUIDO) processar_caracterizacao();
+    }
 
     verificar_botoes();    // Verifica botões para ajuste de sensibilidade
     verificar_joystick();  // Verifica joystick para mudança de modo
 
-    memset(display_buffer, 0, ssd1306_buffer_length);
+    ssd1306_clear(&display);
 
-    // Verifica se o nível de ruído excede o limite e se não está no modo
-    // ESTATISTICAS
-    bool alerta_cond = (db > limite_atual_db) && (modo_atual != ESTATISTICAS);
-    acionar_buzzer(alerta_cond);  // Aciona/desativa o buzzer conforme condição
+    // Alerta em curso (do disparo ao fim da retenção), fora dos modos de
+    // análise (ESTATISTICAS, ESPECTRO) e da calibração
+    const regra_t *alerta = regras_ativa(&regras);
+    bool alerta_cond = alerta != NULL &&
+                       (modo_atual == MONITORAMENTO || modo_atual == ALERTA);
+    acionar_buzzer(alerta_cond ? alerta : NULL);  // Padrão da regra em alerta
 
     if (modo_atual == ESTATISTICAS) {
-      // No modo Estatísticas, exibe o número de alertas emitidos
-      char texto_estatisticas[30];
+      // No modo Estatísticas, exibe o número de alertas emitidos e a taxa de
+      // amostragem efetiva medida pelo motor de aquisição
+      char texto_estatisticas[30], texto_tons[30], texto_por_tom[30],
+          texto_taxa[30], texto_banda[30], texto_perdidos[30], texto_fft[30];
       snprintf(texto_estatisticas, sizeof(texto_estatisticas), "Alertas: %u",
                contador_alertas);
+      // Bipes sustentados: total e contagem de cada frequência, na ordem de
+      // FREQUENCIAS_TONS
+      snprintf(texto_tons, sizeof(texto_tons), "Tons: %lu",
+               (unsigned long)goertzel_total(&tons));
+      int pos = 0;
+      for (int i = 0; i < tons.num && pos < (int)sizeof(texto_por_tom); i++) {
+        pos += snprintf(texto_por_tom + pos, sizeof(texto_por_tom) - pos,
+                        "%s%lu", i ? " " : "",
+                        (unsigned long)tons.detector[i].ocorrencias);
+      }
+      snprintf(texto_taxa, sizeof(texto_taxa), "Taxa: %.0f Hz",
+               aquisicao_taxa_medida());
+      snprintf(texto_banda, sizeof(texto_banda), "Banda: %.0f Hz",
+               banda_dominante());
+      snprintf(texto_perdidos, sizeof(texto_perdidos), "Perdidos: %lu",
+               (unsigned long)aquisicao_blocos_perdidos());
+      snprintf(texto_fft, sizeof(texto_fft), "FFT %lu cic",
+               (unsigned long)ciclos_fft);
       // Exibe a mensagem no display
-      char *estatisticas[] = {"Modo Estatisticas", texto_estatisticas};
-      exibir_texto(display_buffer, &area_total, estatisticas, 2);
+      char *estatisticas[] = {
+          "Modo Estatisticas", texto_estatisticas, texto_tons, texto_por_tom,
+          texto_taxa,          texto_banda,        texto_perdidos, texto_fft};
+      exibir_texto(&display, estatisticas, 8);
+    } else if (modo_atual == ESPECTRO) {
+      desenhar_espectro(&display);
+    } else if (modo_atual == CALIBRACAO_MIC ||
+               modo_atual == CARACTERIZACAO_RUIDO) {
+      char *calibracao[] = {"Calibracao", "94 dB 1 kHz", texto_calibracao};
+      char *caracterizacao[] = {"Piso de ruido", "Silencio", texto_calibracao};
+      exibir_texto(&display,
+                   modo_atual == CALIBRACAO_MIC ? calibracao : caracterizacao,
+                   3);
+      if (calibracao_concluida &&
+          (int32_t)(to_ms_since_boot(get_absolute_time()) -
+                    fim_calibracao_ms) >= 0) {
+        modo_atual = modo_antes_calibracao;
+      }
     } else {
       // Em outros modos, exibe normalmente o nível de ruído e gráfico
       if (alerta_cond) {
-        char *alerta[] = {"  ALERTA!  ", "Nivel maximo", " excedido!  "};
-        exibir_texto(display_buffer, &area_total, alerta, 3);
+        // Regra que disparou e o valor da métrica contra o limite
+        char texto_valor[24];
+        snprintf(texto_valor, sizeof(texto_valor), "%.1f > %.0f dB",
+                 alerta->valor_db, alerta->limite_db);
+        char *aviso[] = {"  ALERTA!  ", (char *)alerta->definicao->nome,
+                         texto_valor};
+        exibir_texto(&display, aviso, 3);
       } else {
-        atualizar_display(db, display_buffer);
+        atualizar_display(db, &display);
       }
     }
 
-    render_on_display(display_buffer, &area_total);
-    sleep_ms(UPDATE_INTERVAL_MS);
+    // Envia só se o quadro mudou, no ritmo definido pelo governador
+    if (display_presente) {
+      ssd1306_governor_update(&governador, &display, alerta_cond);
+    }
+    usb_fluxo_pausar();  // O disco USB lê o log por interrupção
+    medicoes_processar();  // Grava no log uma página pronta, se houver
+    usb_fluxo_retomar();
+    salvar_configuracoes();  // Grava limite e modo após um tempo sem ajustes
+
+    // Espera o próximo quadro atendendo os comandos USB e o rádio (a pilha
+    // USB em si roda por interrupção, ver usb_fluxo.c)
+    absolute_time_t proximo_quadro = make_timeout_time_ms(UPDATE_INTERVAL_MS);
+    while (absolute_time_diff_us(get_absolute_time(), proximo_quadro) > 0) {
+      usb_fluxo_processar();
+      if (usb_fluxo_estado_pedido()) enviar_estado_usb();
+      telemetria_processar();
+    }
   }
 
   return 0;
@@ -157,35 +392,281 @@ float obter_valor_maximo(float *array, int size) {
   return max;
 }
 
+// --------------------------------------------------------------------------
+// Função: configurar_medicao
+// Descrição: Define a taxa de amostragem (divisor de clock do ADC) e a janela
+//          de integração das leituras de dB. Pode ser chamada em execução.
+// --------------------------------------------------------------------------
+void configurar_medicao(uint32_t taxa_hz, uint32_t janela_ms) {
+  aquisicao_definir_taxa(taxa_hz);
+  uint8_t fator = aquisicao_definir_sobreamostragem(SOBREAMOSTRAGEM);
+  for (bits_sobreamostragem = 0; (1 << bits_sobreamostragem) < fator;)
+    bits_sobreamostragem++;
+  float taxa = aquisicao_taxa_nominal();
+  amostras_janela = (uint32_t)(taxa * janela_ms / 1000.0f + 0.5f);
+  if (amostras_janela == 0) amostras_janela = 1;
+
+  // As bandas recebem a mesma unidade interna da medição de dB
+  bandas_iniciar(&bandas, taxa, true);
+
+  static const float frequencias_tons[] = FREQUENCIAS_TONS;
+  goertzel_iniciar(&tons, frequencias_tons, count_of(frequencias_tons), taxa);
+
+  regras_compilar(&regras, regras_alerta, count_of(regras_alerta), janela_ms);
+}
+
+// --------------------------------------------------------------------------
+// Função: atualizar_escala
+// Descrição: Recalcula o termo que converte a média dos quadrados da unidade
+//          interna (contagens do ADC sem DC, deslocadas de 2 bits) em dB SPL,
+//          incluindo o ganho de calibração, e o piso de ruído do ADC. O piso
+//          é branco, então a média de N conversões tem 1/N da sua energia.
+// --------------------------------------------------------------------------
+void atualizar_escala() {
+  escala_base_db =
+      20.0f * log10f(3.3f * 10.0f / (4096.0f * 4.0f) / CALIBRACAO);
+  escala_db = escala_base_db + calibracao_mic.ganho_mdb / 1000.0f;
+
+  ruido_quadratico = 0.0f;
+  nivel_minimo_db = 30.0f;
+  if (calibracao_mic.ruido_quadratico > 0.0f &&
+      calibracao_mic.ruido_sobreamostragem > 0) {
+    ruido_quadratico = calibracao_mic.ruido_quadratico *
+                       calibracao_mic.ruido_sobreamostragem /
+                       (1 << bits_sobreamostragem);
+    // Abaixo de 10 dB sob o piso a subtração já não é confiável
+    nivel_minimo_db = 10.0f * log10f(0.1f * ruido_quadratico) + escala_db;
+  }
+}
+
+// --------------------------------------------------------------------------
+// Função: iniciar_calibracao
+// Descrição: Entra no modo de calibração (combinação A + B mantidos). Em
+//          CALIBRACAO_MIC o calibrador de 94 dB / 1 kHz deve estar acoplado
+//          ao microfone; em CARACTERIZACAO_RUIDO o microfone deve estar em
+//          silêncio (ou com a entrada em curto para medir só o ADC).
+// --------------------------------------------------------------------------
+void iniciar_calibracao(enum Modo modo) {
+  if (modo_atual == CALIBRACAO_MIC || modo_atual == CARACTERIZACAO_RUIDO)
+    return;
+  modo_antes_calibracao = modo_atual;
+  modo_atual = modo;
+  janelas_calibracao = 0;
+  soma_calibracao = 0.0;
+  calibracao_concluida = false;
+  snprintf(texto_calibracao, sizeof(texto_calibracao), "Aguarde");
+}
+
+// --------------------------------------------------------------------------
+// Função: processar_calibracao
+// Descrição: Integra CALIBRACAO_JANELAS janelas, confere que a banda
+//          dominante é a de 1 kHz e grava na flash o ganho que leva a
+//          leitura a CALIBRADOR_DB.
+// --------------------------------------------------------------------------
+void processar_calibracao() {
+  if (calibracao_concluida) return;
+
+  soma_calibracao += media_quadrados_janela;
+  if (++janelas_calibracao < CALIBRACAO_JANELAS) return;
+
+  float medido_db = 10.0f * log10f(soma_calibracao / janelas_calibracao +
+                                   1e-12f) +
+                    escala_base_db;
+  float banda = banda_dominante();
+
+  if (banda < 800.0f || banda > 1250.0f) {
+    snprintf(texto_calibracao, sizeof(texto_calibracao), "Sem 1 kHz");
+  } else {
+    calibracao_registro_t registro = calibracao_mic;
+    registro.ganho_mdb =
+        (int32_t)lroundf((CALIBRADOR_DB - medido_db) * 1000.0f);
+    if (calibracao_salvar(&registro)) {
+      calibracao_mic = registro;
+      atualizar_escala();
+      snprintf(texto_calibracao, sizeof(texto_calibracao), "Ganho %+.1f dB",
+               calibracao_mic.ganho_mdb / 1000.0f);
+    } else {
+      snprintf(texto_calibracao, sizeof(texto_calibracao), "Erro flash");
+    }
+  }
+
+  calibracao_concluida = true;
+  fim_calibracao_ms =
+      to_ms_since_boot(get_absolute_time()) + CALIBRACAO_EXIBIR_MS;
+}
+
+// --------------------------------------------------------------------------
+// Função: processar_caracterizacao
+// Descrição: Integra CALIBRACAO_JANELAS janelas em repouso e grava na flash a
+//          energia do piso de ruído (na sobreamostragem atual) e o offset DC
+//          da entrada, que passa a ser o ponto de partida do filtro de DC.
+// --------------------------------------------------------------------------
+void processar_caracterizacao() {
+  if (calibracao_concluida) return;
+
+  soma_calibracao += media_quadrados_janela;
+  if (++janelas_calibracao < CALIBRACAO_JANELAS) return;
+
+  calibracao_registro_t registro = calibracao_mic;
+  registro.ruido_quadratico = soma_calibracao / janelas_calibracao;
+  registro.ruido_sobreamostragem = 1u << bits_sobreamostragem;
+  registro.dc_q16 = offset_dc_q16;
+  if (calibracao_salvar(&registro)) {
+    calibracao_mic = registro;
+    atualizar_escala();
+    snprintf(texto_calibracao, sizeof(texto_calibracao), "Piso %.1f dB",
+             10.0f * log10f(ruido_quadratico + 1e-12f) + escala_db);
+  } else {
+    snprintf(texto_calibracao, sizeof(texto_calibracao), "Erro flash");
+  }
+
+  calibracao_concluida = true;
+  fim_calibracao_ms =
+      to_ms_since_boot(get_absolute_time()) + CALIBRACAO_EXIBIR_MS;
+}
+
 // --------------------------------------------------------------------------
 // Função: ler_decibeis
-// Descrição: Lê o sinal do microfone via ADC e converte para dB SPL.
-// --------------------------------------------------------------------------
-float ler_decibeis() {
-  static float offset_dc = 0.0f;
-  float soma_quadrados = 0.0f;
-
-  for (int i = 0; i < AMOSTRAS; i++) {
-    adc_select_input(2);
-    uint16_t leitura_adc = adc_read();
-    float tensao = (leitura_adc * 3.3f) / 4096.0f;
-
-    // Remove o offset DC usando um filtro passa-baixa
-    offset_dc = 0.95f * offset_dc + 0.05f * tensao;
-    float tensao_ac = (tensao - offset_dc) * 10.0f;  // Aplica ganho de 10x
-    soma_quadrados += tensao_ac * tensao_ac;
-    sleep_us(10);
+// Descrição: Consome os blocos de áudio capturados pelo DMA e integra a
+//          janela de medição. Não bloqueia: retorna true e o nível em dB SPL
+//          quando ao menos uma janela foi concluída (a mais recente). O
+//          banco de filtros recebe os mesmos blocos e o Leq das bandas é
+//          fechado no fim do bloco em que a janela termina.
+// --------------------------------------------------------------------------
+bool ler_decibeis(float *db) {
+  static uint64_t soma_quadrados = 0;
+  static uint32_t amostras = 0;
+  static int16_t amostras_bandas[AQ_AMOSTRAS_BLOCO];
+  bool concluida = false;
+  const aq_bloco_t *bloco;
+
+  while ((bloco = aquisicao_proximo_bloco()) != NULL) {
+    bool fim_janela = false;
+
+    // Cada amostra é a soma de 2^bits_sobreamostragem conversões: o
+    // deslocamento leva todas à mesma escala (média em contagens << 16)
+    int deslocamento = 16 - bits_sobreamostragem;
+    if (offset_dc_q16 < 0) offset_dc_q16 = bloco->amostras[0] << deslocamento;
+
+    for (int i = 0; i < AQ_AMOSTRAS_BLOCO; i++) {
+      int32_t leitura_q16 = bloco->amostras[i] << deslocamento;
+
+      // Remove o offset DC usando um filtro passa-baixa
+      offset_dc_q16 += (leitura_q16 - offset_dc_q16) >> DC_SHIFT;
+      int32_t x = (leitura_q16 - offset_dc_q16) >> 14;  // Contagens << 2
+      amostras_bandas[i] = (int16_t)x;
+      soma_quadrados += (uint32_t)(x * x);
+
+      if (++amostras >= amostras_janela) {
+        media_quadrados_janela = (float)soma_quadrados / amostras;
+        float sinal = fmaxf(media_quadrados_janela - ruido_quadratico,
+                            0.1f * ruido_quadratico);
+        *db = fmaxf(nivel_minimo_db,
+                    10.0f * log10f(sinal + 1e-12f) + escala_db);
+        soma_quadrados = 0;
+        amostras = 0;
+        fim_janela = true;
+      }
+    }
+    // O bloco vai para a USB direto do anel, antes de ser liberado
+    usb_fluxo_audio(bloco);
+    if (fim_janela) usb_fluxo_nivel(*db, bloco->instante_us);
+    aquisicao_liberar_bloco();
+
+    // Microfone USB: as mesmas amostras do medidor, já sem o offset DC
+    usb_audio_enviar(amostras_bandas, AQ_AMOSTRAS_BLOCO);
+    bandas_processar(&bandas, amostras_bandas, AQ_AMOSTRAS_BLOCO);
+    goertzel_processar(&tons, amostras_bandas, AQ_AMOSTRAS_BLOCO);
+    if (modo_atual == ESPECTRO) {
+      alimentar_espectro(amostras_bandas, AQ_AMOSTRAS_BLOCO);
+    }
+    if (fim_janela) {
+      bandas_leq(&bandas, escala_db, leq_bandas);
+      concluida = true;
+    }
   }
 
-  float rms = sqrtf(soma_quadrados / AMOSTRAS);
-  return fmaxf(30.0f, 20.0f * log10f(rms / CALIBRACAO + 1e-12f));
+  return concluida;
+}
+
+// --------------------------------------------------------------------------
+// Função: alimentar_espectro
+// Descrição: Acumula amostras sem DC até completar FFT_PONTOS e então aplica
+//          a janela de Hann, calcula a FFT e converte as raias em barras de
+//          128 colunas (em dB). Os ciclos gastos são medidos pelo SysTick.
+// --------------------------------------------------------------------------
+void alimentar_espectro(const int16_t *amostras, int n) {
+  for (int i = 0; i < n && fft_preenchidas < FFT_PONTOS; i++) {
+    fft_re[fft_preenchidas] = amostras[i];
+    fft_im[fft_preenchidas] = 0;
+    fft_preenchidas++;
+  }
+  if (fft_preenchidas < FFT_PONTOS) return;
+  fft_preenchidas = 0;
+
+  uint32_t inicio = systick_hw->cvr;
+  fft_janela_hann(fft_re, FFT_LOG2);
+  fft_complexa(fft_re, fft_im, FFT_LOG2);
+  fft_potencia(fft_re, fft_im, FFT_LOG2, fft_potencia_raias);
+  ciclos_fft = (inicio - systick_hw->cvr) & 0x00FFFFFF;  // Conta para baixo
+
+  // Cada coluna mostra a maior raia do seu grupo (a raia DC é ignorada)
+  int raias = FFT_PONTOS / 2;
+  int colunas = raias < ssd1306_width ? raias : ssd1306_width;
+  int por_coluna = raias / colunas;
+  int pico = 1;
+  for (int c = 0; c < colunas; c++) {
+    uint32_t maior = 0;
+    for (int r = c * por_coluna; r < (c + 1) * por_coluna; r++) {
+      if (r == 0) continue;
+      if (fft_potencia_raias[r] > maior) maior = fft_potencia_raias[r];
+      if (fft_potencia_raias[r] > fft_potencia_raias[pico]) pico = r;
+    }
+    float nivel = 10.0f * log10f((float)maior + 1.0f);
+    int altura = (int)(nivel * (ssd1306_height - 9) / ESPECTRO_FAIXA_DB);
+    espectro_barras[c] = altura < 0 ? 0
+                         : altura > ssd1306_height - 9 ? ssd1306_height - 9
+                                                       : altura;
+  }
+  espectro_pico_hz = pico * aquisicao_taxa_nominal() / FFT_PONTOS;
+}
+
+// --------------------------------------------------------------------------
+// Função: desenhar_espectro
+// Descrição: Desenha o espectro em barras (uma por coluna) abaixo de uma
+//          linha com a frequência de pico.
+// --------------------------------------------------------------------------
+void desenhar_espectro(ssd1306_t *ssd) {
+  char texto_pico[20];
+  snprintf(texto_pico, sizeof(texto_pico), "Pico %.0f Hz", espectro_pico_hz);
+
+  ssd1306_clear(ssd);
+  ssd1306_draw_string(ssd, 5, 0, texto_pico);
+  for (int c = 0; c < ssd->width; c++) {
+    if (espectro_barras[c] == 0) continue;
+    ssd1306_draw_line(ssd, c, ssd->height - 1, c,
+                      ssd->height - espectro_barras[c], true);
+  }
+}
+
+// --------------------------------------------------------------------------
+// Função: banda_dominante
+// Descrição: Retorna a frequência central da banda com maior Leq na última
+//          janela (alarmes em 1-3 kHz, carrinhos e ar-condicionado nos graves).
+// --------------------------------------------------------------------------
+float banda_dominante() {
+  int maior = 0;
+  for (int i = 1; i < bandas.num_bandas; i++) {
+    if (leq_bandas[i] > leq_bandas[maior]) maior = i;
+  }
+  return bandas.frequencia[maior];
 }
 
 // --------------------------------------------------------------------------
 // Função: atualizar_display
 // Descrição: Atualiza o conteúdo do display OLED com o nível de ruído.
 // --------------------------------------------------------------------------
-void atualizar_display(float db, uint8_t *display_buffer) {
+void atualizar_display(float db, ssd1306_t *ssd) {
   char texto_db[20], texto_limite[25];
   snprintf(texto_db, sizeof(texto_db), "%.1f dB", db);
   snprintf(texto_limite, sizeof(texto_limite), "Limite: %.1f dB",
@@ -195,12 +676,11 @@ void atualizar_display(float db, uint8_t *display_buffer) {
                            : (modo_atual == ALERTA)      ? "Modo Alerta"
                                                          : "Estatisticas";
 
-  uint8_t buffer[ssd1306_buffer_length];
-  memset(buffer, 0, ssd1306_buffer_length);
+  ssd1306_clear(ssd);
 
-  ssd1306_draw_string(buffer, 5, 0, texto_db);
-  ssd1306_draw_string(buffer, 5, 45, texto_modo);
-  ssd1306_draw_string(buffer, 5, 55, texto_limite);
+  ssd1306_draw_string(ssd, 5, 0, texto_db);
+  ssd1306_draw_string(ssd, 5, 45, texto_modo);
+  ssd1306_draw_string(ssd, 5, 55, texto_limite);
 
   if (modo_atual == MONITORAMENTO) {
     float nivel_maximo_db = obter_valor_maximo(historico, TAMANHO_HISTORICO);
@@ -208,13 +688,37 @@ void atualizar_display(float db, uint8_t *display_buffer) {
     for (int i = 0; i < TAMANHO_HISTORICO; i++) {
       int y = 40 - (int)(historico[(indice_historico + i) % TAMANHO_HISTORICO] *
                          escala);
-      ssd1306_set_pixel(buffer, i, y, true);
+      ssd1306_set_pixel(ssd, i, y, true);
     }
-    ssd1306_draw_line(buffer, 0, 15, ssd1306_width - 1, 15, true);
-    ssd1306_draw_line(buffer, 0, 43, ssd1306_width - 1, 43, true);
+    ssd1306_draw_line(ssd, 0, 15, ssd->width - 1, 15, true);
+    ssd1306_draw_line(ssd, 0, 43, ssd->width - 1, 43, true);
   }
+}
 
-  memcpy(display_buffer, buffer, ssd1306_buffer_length);
+// --------------------------------------------------------------------------
+// Função: nucleo1_ocioso
+// Descrição: Laço do núcleo 1 após iniciar a aquisição. Fica na RAM, assim
+//          como a interrupção de DMA, para que apagar ou gravar a flash no
+//          núcleo 0 não interrompa a amostragem.
+// --------------------------------------------------------------------------
+static void __not_in_flash_func(nucleo1_ocioso)() {
+  while (true) {
+    __wfi();
+  }
+}
+
+// --------------------------------------------------------------------------
+// Função: nucleo1_principal
+// Descrição: Ponto de entrada do núcleo 1: inicia a aquisição do microfone e
+//          do joystick (intercalados pelo round-robin do ADC), para que a
+//          interrupção de DMA seja atendida por este núcleo, e avisa o
+//          núcleo 0.
+// --------------------------------------------------------------------------
+void nucleo1_principal() {
+  aquisicao_adicionar_canal_lento(JOYSTICK_VRX);
+  aquisicao_iniciar(MICROFONE_ADC_PIN, AQ_TAXA_PADRAO_HZ);
+  multicore_fifo_push_blocking(1);
+  nucleo1_ocioso();
 }
 
 // --------------------------------------------------------------------------
@@ -222,109 +726,291 @@ void atualizar_display(float db, uint8_t *display_buffer) {
 // Descrição: Configura I2C, ADC, PWM e GPIO para os componentes.
 // --------------------------------------------------------------------------
 void inicializar_hardware() {
-  i2c_init(i2c1, 400 * 1000);
+  i2c_init(i2c1, ssd1306_i2c_clock * 1000);
   gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
   gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
   gpio_pull_up(I2C_SDA);
   gpio_pull_up(I2C_SCL);
 
-  uint8_t init_commands[] = {0xAE, 0xD5, 0x80, 0xA8, 0x3F, 0xD3, 0x00,
-                             0x40, 0x8D, 0x14, 0x20, 0x00, 0xA1, 0xC8,
-                             0xDA, 0x12, 0x81, 0xCF, 0xD9, 0xF1, 0xDB,
-                             0x40, 0xA4, 0xA6, 0xAF};
-  ssd1306_send_command_list(init_commands, sizeof(init_commands));
-
-  adc_init();
-  adc_gpio_init(MICROFONE_ADC_PIN);
-  adc_select_input(2);
-
-  gpio_set_function(BUZZER_PIN, GPIO_FUNC_PWM);
-  uint slice_num = pwm_gpio_to_slice_num(BUZZER_PIN);
-  pwm_config config = pwm_get_default_config();
-  pwm_init(slice_num, &config, true);
-
-  gpio_init(BOTAO_A);
-  gpio_set_dir(BOTAO_A, GPIO_IN);
-  gpio_pull_up(BOTAO_A);
-  gpio_init(BOTAO_B);
-  gpio_set_dir(BOTAO_B, GPIO_IN);
-  gpio_pull_up(BOTAO_B);
+  // Sem o painel (desconectado, outro endereço) o medidor segue funcionando:
+  // os quadros continuam sendo desenhados na RAM, mas não são enviados
+  display_presente = ssd1306_init(&display, ssd1306_width, ssd1306_height,
+                                  false, ssd1306_i2c_address, i2c1);
+  if (display.ram_buffer == NULL) panic("Sem memoria para o display");
+
+  // A aquisição roda no núcleo 1 (ver nucleo1_principal); espera ela
+  // começar antes de configurar a medição
+  multicore_launch_core1(nucleo1_principal);
+  multicore_fifo_pop_blocking();
+  configurar_medicao(AQ_TAXA_PADRAO_HZ, JANELA_MS);
+
+  // Ganho e piso de ruído gravados na flash (zero se o dispositivo nunca foi
+  // calibrado); o offset DC caracterizado evita esperar o filtro de DC
+  // convergir a partir da primeira amostra
+  calibracao_carregar(&calibracao_mic);
+  if (calibracao_mic.dc_q16 != 0) offset_dc_q16 = calibracao_mic.dc_q16;
+  atualizar_escala();
+
+  // Fluxo binário de medições pela USB (CDC)
+  usb_fluxo_iniciar();
+
+  // Log de medições: continua após o último registro gravado
+  medicoes_iniciar();
+
+  // Telemetria Wi-Fi e servidor HTTP: a conexão segue em segundo plano no
+  // laço principal
+  telemetria_iniciar(medicoes_sessao());
+  servidor_http_iniciar(medicoes_sessao(), historico, TAMANHO_HISTORICO,
+                        &indice_historico, JANELA_MS);
+
+  // Limite e modo escolhidos antes da última reinicialização
+  carregar_configuracoes();
+
+  // SysTick livre no clock do processador, para contar ciclos da FFT
+  systick_hw->rvr = 0x00FFFFFF;
+  systick_hw->cvr = 0;
+  systick_hw->csr =
+      M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+
+  buzzer_iniciar(BUZZER_PIN);  // PWM e alarme do timer do sequenciador
+
+  botoes_iniciar();
+  botoes_registrar(ID_BOTAO_A, BOTAO_A);
+  botoes_registrar(ID_BOTAO_B, BOTAO_B);
+}
+
+// --------------------------------------------------------------------------
+// Função: carregar_configuracoes
+// Descrição: Restaura da flash o limite de alerta e o modo de exibição. Sem
+//          cópia válida, mantém LIMITE_DB e o modo Monitoramento.
+// --------------------------------------------------------------------------
+void carregar_configuracoes() {
+  // Sem cópia na flash valem os valores de fábrica, que não são gravados
+  // enquanto o usuário não os alterar
+  configuracoes_t configuracoes = {
+      .limite_ddb = (int16_t)lroundf(limite_atual_db * 10.0f),
+      .modo = (uint8_t)modo_atual};
+  if (!configuracoes_carregar(&configuracoes)) return;
+
+  float limite = configuracoes.limite_ddb / 10.0f;
+  if (limite >= 30.0f && limite <= 120.0f) limite_atual_db = limite;
+  if (configuracoes.modo == MONITORAMENTO ||
+      configuracoes.modo == ESTATISTICAS || configuracoes.modo == ESPECTRO) {
+    modo_atual = configuracoes.modo;
+  }
+}
+
+// --------------------------------------------------------------------------
+// Função: salvar_configuracoes
+// Descrição: Entrega o limite e o modo atuais ao armazenamento de
+//          configurações, que só grava a flash depois de
+//          CONFIGURACOES_ESPERA_MS sem alterações. Durante a calibração vale
+//          o modo que estava ativo antes dela.
+// --------------------------------------------------------------------------
+void salvar_configuracoes() {
+  enum Modo modo = modo_atual;
+  if (modo == CALIBRACAO_MIC || modo == CARACTERIZACAO_RUIDO)
+    modo = modo_antes_calibracao;
+
+  configuracoes_t configuracoes = {
+      .limite_ddb = (int16_t)lroundf(limite_atual_db * 10.0f),
+      .modo = (uint8_t)modo};
+  configuracoes_processar(&configuracoes);
 }
 
 // --------------------------------------------------------------------------
 // Função: verificar_botoes
-// Descrição: Verifica os botões para ajustar o limite de ruído.
+// Descrição: Consome os eventos dos botões para ajustar o limite de ruído.
+//          Cada toque altera 1 dB ao soltar o botão; mantendo-o pressionado,
+//          o evento longo e a repetição automática continuam ajustando. A e B
+//          mantidos juntos iniciam a calibração: o estado dos botões é o dos
+//          próprios eventos (não o do momento do consumo) e, desde que os
+//          dois estiveram pressionados até os dois serem soltos, nenhum
+//          evento ajusta o limite.
 // --------------------------------------------------------------------------
 void verificar_botoes() {
-  static uint32_t last_press = 0;
-  const uint32_t debounce_delay = 200000;  // 200 ms
+  static bool pressionado[2] = {false, false};
+  static bool ajustou[2] = {false, false};  // Longo/repetição já ajustaram
+  static bool combinacao = false;  // A e B juntos, até os dois serem soltos
+  static bool calibrou = false;    // A combinação já iniciou a calibração
+  evento_botao_t evento;
 
-  if (time_us_32() - last_press < debounce_delay) return;
+  while (botoes_obter_evento(&evento)) {
+    if (evento.botao != ID_BOTAO_A && evento.botao != ID_BOTAO_B) continue;
+    int b = evento.botao;
+    float passo = b == ID_BOTAO_A ? 1.0f : -1.0f;
+    bool ajustar = false;
 
-  if (!gpio_get(BOTAO_A))
-    limite_atual_db = fminf(120.0f, limite_atual_db + 1.0f);
-  if (!gpio_get(BOTAO_B))
-    limite_atual_db = fmaxf(30.0f, limite_atual_db - 1.0f);
+    switch (evento.tipo) {
+      case BOTAO_PRESSIONADO:
+        pressionado[b] = true;
+        ajustou[b] = false;
+        if (pressionado[ID_BOTAO_A] && pressionado[ID_BOTAO_B] &&
+            !combinacao) {
+          combinacao = true;
+          calibrou = false;
+        }
+        break;
+      case BOTAO_LONGO:
+        // A e B juntos: calibração (no modo estatísticas, medição do piso
+        // de ruído)
+        if (combinacao && !calibrou && pressionado[ID_BOTAO_A] &&
+            pressionado[ID_BOTAO_B]) {
+          calibrou = true;
+          iniciar_calibracao(modo_atual == ESTATISTICAS ? CARACTERIZACAO_RUIDO
+                                                        : CALIBRACAO_MIC);
+        }
+        ajustar = true;
+        break;
+      case BOTAO_REPETICAO:
+        ajustar = true;
+        break;
+      case BOTAO_SOLTO:
+        pressionado[b] = false;
+        ajustar = !ajustou[b];  // Toque curto
+        if (!pressionado[ID_BOTAO_A] && !pressionado[ID_BOTAO_B] &&
+            combinacao) {
+          combinacao = false;
+          ajustar = false;
+        }
+        break;
+    }
+
+    if (!ajustar || combinacao) continue;
+    ajustou[b] = true;
+    if (modo_atual == CALIBRACAO_MIC || modo_atual == CARACTERIZACAO_RUIDO)
+      continue;
+    limite_atual_db = fminf(120.0f, fmaxf(30.0f, limite_atual_db + passo));
+  }
 
-  last_press = time_us_32();
+  // Um evento SOLTO perdido (fila cheia) não pode deixar a combinação presa
+  if (combinacao && !botoes_pressionado(ID_BOTAO_A) &&
+      !botoes_pressionado(ID_BOTAO_B)) {
+    combinacao = false;
+    pressionado[ID_BOTAO_A] = pressionado[ID_BOTAO_B] = false;
+  }
 }
 
 // --------------------------------------------------------------------------
 // Função: verificar_joystick
-// Descrição: Lê o joystick e define o modo de operação.
+// Descrição: Lê o joystick (canal decimado do motor de aquisição) e define o
+//          modo de operação. Cada toque para a direita avança um modo
+//          (Monitoramento -> Estatisticas -> Espectro) e para a esquerda
+//          volta um; o joystick precisa voltar ao centro entre os toques.
 // --------------------------------------------------------------------------
 void verificar_joystick() {
-  adc_gpio_init(JOYSTICK_VRX);
-  adc_select_input(1);
-  float posicao_x = adc_read() / 4096.0f;
+  static const enum Modo sequencia[] = {MONITORAMENTO, ESTATISTICAS, ESPECTRO};
+  static bool centralizado = true;
+  float posicao_x = aquisicao_canal_lento(JOYSTICK_VRX) / 4096.0f;
 
-  if (posicao_x < 0.3f)
-    modo_atual = MONITORAMENTO;
-  else if (posicao_x > 0.7f)
-    modo_atual = ESTATISTICAS;
+  if (modo_atual == CALIBRACAO_MIC || modo_atual == CARACTERIZACAO_RUIDO)
+    return;
 
-  adc_select_input(2);
-  adc_read();
+  if (posicao_x > 0.4f && posicao_x < 0.6f) {
+    centralizado = true;
+    return;
+  }
+  if (!centralizado || (posicao_x >= 0.3f && posicao_x <= 0.7f)) return;
+  centralizado = false;
+
+  int atual = 0;
+  for (int i = 0; i < (int)count_of(sequencia); i++) {
+    if (sequencia[i] == modo_atual) atual = i;
+  }
+  if (posicao_x < 0.3f && atual > 0)
+    atual--;
+  else if (posicao_x > 0.7f && atual < (int)count_of(sequencia) - 1)
+    atual++;
+
+  modo_atual = sequencia[atual];
+  fft_preenchidas = 0;
 }
 
 // --------------------------------------------------------------------------
-// Função: acionar_buzzer
-// Descrição: Aciona ou desativa o buzzer com base na condição de alerta.
-//          Se o alerta for acionado (transição de desligado para ligado),
-//          incrementa o contador de alertas.
-// --------------------------------------------------------------------------
-void acionar_buzzer(bool estado) {
-  static bool estado_anterior = false;
-  if (estado == estado_anterior) return;
-
-  uint slice_num = pwm_gpio_to_slice_num(BUZZER_PIN);
-  uint canal = pwm_gpio_to_channel(BUZZER_PIN);
-  if (estado) {
-    uint32_t wrap_val = 125000000 / 2500 / 16;  // ~3125 para ~2.5 kHz
-    pwm_set_wrap(slice_num, wrap_val);
-    pwm_set_chan_level(slice_num, canal, wrap_val / 2);  // 50% duty cycle
-    pwm_set_enabled(slice_num, true);
-    // Incrementa o contador somente na transição para alerta (de desligado para
-    // ligado)
-    if (!estado_anterior) {
-      contador_alertas++;
+// Função: avaliar_alarme
+// Descrição: Passa a leitura pelas regras de alerta (cada uma com sua máquina
+//          de estados). Só os modos de monitoramento alarmam; nos demais os
+//          eventos em andamento são encerrados. Cada evento disparado conta
+//          um alerta, por mais que o nível oscile em torno do limite; cada
+//          evento encerrado é publicado no fluxo USB.
+// --------------------------------------------------------------------------
+void avaliar_alarme(float db) {
+  uint32_t disparadas = 0, encerradas;
+  if (modo_atual == MONITORAMENTO || modo_atual == ALERTA) {
+    disparadas = regras_avaliar(&regras, db, limite_atual_db,
+                                relogio_minuto_do_dia(),
+                                to_ms_since_boot(get_absolute_time()),
+                                &encerradas);
+  } else {
+    encerradas = regras_cancelar(&regras);
+  }
+
+  for (int i = 0; i < regras.num_regras; i++) {
+    const regra_t *r = &regras.regra[i];
+    if (disparadas & (1u << i)) contador_alertas++;
+    if (encerradas & (1u << i)) {
+      const alarme_evento_t *e = &r->alarme.ultimo;
+      usb_evento_t evento = {.inicio_ms = e->inicio_ms,
+                             .duracao_ms = alarme_duracao_ms(e),
+                             .pico_db = e->pico_db,
+                             .exposicao_db = alarme_exposicao_db(e)};
+      const char *nome = r->definicao->nome;
+      memcpy(evento.regra, nome, strnlen(nome, sizeof(evento.regra)));
+      usb_fluxo_evento(&evento, time_us_64());
     }
+  }
+}
+
+// --------------------------------------------------------------------------
+// Função: enviar_estado_usb
+// Descrição: Publica no fluxo USB o estado do medidor (taxa do ADC, piso de
+//          ruído, log e presença e clock do display), enviado a cada conexão do host e
+//          a pedido (USB_COMANDO_ESTADO).
+// --------------------------------------------------------------------------
+void enviar_estado_usb() {
+  usb_estado_t estado = {
+      .taxa_nominal_hz = aquisicao_taxa_nominal(),
+      .taxa_medida_hz = aquisicao_taxa_medida(),
+      .amostras_janela = amostras_janela,
+      .sobreamostragem = 1u << bits_sobreamostragem,
+      .display_presente = display_presente,
+      .sessao_log = medicoes_sessao(),
+      .registros_log = medicoes_total(),
+      .piso_ruido_db = ruido_quadratico > 0.0f ? nivel_minimo_db + 10.0f : NAN,
+      .offset_dc = calibracao_mic.dc_q16 / 65536.0f,
+      .i2c_khz = calibracao_i2c.baudrate / 1000,
+      .i2c_max_khz = calibracao_i2c.max_stable_khz,
+      .display_fps = calibracao_i2c.fps};
+  usb_fluxo_estado(&estado);
+}
+
+// --------------------------------------------------------------------------
+// Função: acionar_buzzer
+// Descrição: Entrega ao sequenciador do buzzer a sequência da regra em alerta
+//          (NULL desliga). Só age quando a regra muda: o padrão é tocado
+//          por interrupção, sem depender do ritmo do laço principal.
+// --------------------------------------------------------------------------
+void acionar_buzzer(const regra_t *regra) {
+  static const regra_t *anterior = NULL;
+  if (regra == anterior) return;
+
+  if (regra != NULL) {
+    buzzer_tocar(&sequencias_buzzer[regra->definicao->buzzer]);
   } else {
-    pwm_set_enabled(slice_num, false);
+    buzzer_parar();
   }
-  estado_anterior = estado;
+  anterior = regra;
 }
 
 // --------------------------------------------------------------------------
 // Função: exibir_texto
 // Descrição: Exibe múltiplas linhas de texto no display OLED.
 // --------------------------------------------------------------------------
-void exibir_texto(uint8_t *buffer, struct render_area *area, char *lines[],
-                  int num_lines) {
-  memset(buffer, 0, ssd1306_buffer_length);
+void exibir_texto(ssd1306_t *ssd, char *lines[], int num_lines) {
+  ssd1306_clear(ssd);
   int y_pos = 0;
   for (int i = 0; i < num_lines; i++) {
-    ssd1306_draw_string(buffer, 5, y_pos, lines[i]);
+    ssd1306_draw_string(ssd, 5, y_pos, lines[i]);
     y_pos += 8;
   }
 }
@@ -338,14 +1024,50 @@ void atualizar_historico(float db) {
   indice_historico = (indice_historico + 1) % TAMANHO_HISTORICO;
 }
 
+// --------------------------------------------------------------------------
+// Função: registrar_minuto
+// Descrição: Acumula as leituras do minuto corrente (Leq, máximo e alertas) e,
+//          na virada do minuto, entrega o resumo ao log de medições. As
+//          janelas medidas durante a calibração não entram no log.
+// --------------------------------------------------------------------------
+void registrar_minuto(float db) {
+  uint32_t minuto = to_ms_since_boot(get_absolute_time()) / 60000;
+
+  if (minuto != minuto_atual && janelas_minuto > 0) {
+    medicao_t medicao = {
+        .minuto = minuto_atual,
+        .sessao = medicoes_sessao(),
+        .leq_ddb = (uint16_t)lroundf(
+            100.0f * log10f(energia_minuto / janelas_minuto)),
+        .lmax_ddb = (uint16_t)lroundf(lmax_minuto * 10.0f),
+        .alertas = (uint16_t)(contador_alertas - alertas_inicio_minuto)};
+    usb_fluxo_pausar();  // O disco USB lê o log por interrupção
+    medicoes_adicionar(&medicao);
+    usb_fluxo_retomar();
+    energia_minuto = 0.0;
+    janelas_minuto = 0;
+    lmax_minuto = 0.0f;
+  }
+  if (minuto != minuto_atual) {
+    minuto_atual = minuto;
+    alertas_inicio_minuto = contador_alertas;
+  }
+
+  if (modo_atual == CALIBRACAO_MIC || modo_atual == CARACTERIZACAO_RUIDO)
+    return;
+  energia_minuto += powf(10.0f, db / 10.0f);
+  janelas_minuto++;
+  lmax_minuto = fmaxf(lmax_minuto, db);
+}
+
 // --------------------------------------------------------------------------
 // Função: desenhar_grafico
 // Descrição: Desenha um gráfico simples dos valores do histórico.
 // --------------------------------------------------------------------------
-void desenhar_grafico(uint8_t *buffer) {
+void desenhar_grafico(ssd1306_t *ssd) {
   for (int i = 0; i < TAMANHO_HISTORICO; i++) {
     int index = (indice_historico + i) % TAMANHO_HISTORICO;
     int y = 40 - (int)(historico[index] * 0.8f);
-    ssd1306_set_pixel(buffer, i, y, true);
+    ssd1306_set_pixel(ssd, i, y, true);
   }
 }
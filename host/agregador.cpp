@@ -0,0 +1,177 @@
+// ==========================================================================
+// Agregador da telemetria UDP de uma frota de medidores (host/agregador.h).
+// Uso: agregador [porta] [trabalhadores] [salas.csv]
+//
+// Recebe os datagramas de telemetria na porta (padrão
+// TELEMETRIA_PORTA_PADRAO) e mantém, por sala, Leq, Lmax e taxa de alertas
+// dos últimos 5 minutos. salas.csv associa medidores a salas, uma linha por
+// medidor: "numero_de_serie_hex,nome da sala".
+//
+// Consultas: um datagrama UDP com o nome da sala (ou o número de série) na
+// porta seguinte (porta + 1) recebe uma linha JSON com as estatísticas; "*"
+// lista todas as salas. A cada 5 s o resumo da frota vai para a saída.
+// ==========================================================================
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "agregador.h"
+
+namespace {
+
+using Relogio = std::chrono::steady_clock;
+using agregador::Agregador;
+using agregador::Estatisticas;
+
+constexpr int kLote = 64;          // Datagramas por recvmmsg
+constexpr size_t kCapacidade = 4096;  // Medidores
+
+int abrir_udp(int porta) {
+  int s = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in endereco{};
+  endereco.sin_family = AF_INET;
+  endereco.sin_port = htons(porta);
+  endereco.sin_addr.s_addr = htonl(INADDR_ANY);
+  int buffer = 8 << 20;  // Absorve rajadas de centenas de medidores
+  setsockopt(s, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+  if (s < 0 ||
+      bind(s, reinterpret_cast<sockaddr *>(&endereco), sizeof(endereco)) < 0) {
+    std::perror("bind");
+    std::exit(1);
+  }
+  return s;
+}
+
+std::string json(const std::string &sala, const Estatisticas &e) {
+  char linha[256];
+  std::snprintf(linha, sizeof(linha),
+                "{\"sala\":\"%s\",\"leq_db\":%.1f,\"lmax_db\":%.1f,"
+                "\"alertas_hora\":%.1f,\"segundos\":%u,\"registros\":%llu}",
+                sala.c_str(), e.leq_db, e.lmax_db, e.alertas_hora, e.segundos,
+                (unsigned long long)e.registros);
+  return linha;
+}
+
+// Responde às consultas dos painéis (porta + 1)
+void atender_consultas(const Agregador &agregador, int porta) {
+  int s = abrir_udp(porta);
+  char pedido[128];
+  for (;;) {
+    sockaddr_in origem{};
+    socklen_t tamanho = sizeof(origem);
+    ssize_t n = recvfrom(s, pedido, sizeof(pedido) - 1, 0,
+                         reinterpret_cast<sockaddr *>(&origem), &tamanho);
+    if (n <= 0) continue;
+    while (n > 0 && (pedido[n - 1] == '\n' || pedido[n - 1] == '\r')) n--;
+    std::string sala(pedido, n);
+
+    std::string resposta;
+    Estatisticas e;
+    if (sala == "*") {
+      for (size_t i = 0; i < agregador.dispositivos(); i++) {
+        const auto &d = agregador.dispositivo(i);
+        std::string linha = json(d.sala, d.ler()) + "\n";
+        if (resposta.size() + linha.size() > 60000) break;
+        resposta += linha;
+      }
+    } else if (agregador.consultar_sala(sala, &e)) {
+      resposta = json(sala, e) + "\n";
+    } else {
+      resposta = "{\"erro\":\"sala desconhecida\"}\n";
+    }
+    sendto(s, resposta.data(), resposta.size(), 0,
+           reinterpret_cast<sockaddr *>(&origem), tamanho);
+  }
+}
+
+// Resumo periódico: vazão e as salas mais ruidosas
+void relatar(const Agregador &agregador) {
+  auto anterior = agregador.contadores();
+  auto inicio = Relogio::now();
+  for (;;) {
+    std::this_thread::sleep_for(std::chrono::seconds(5));
+    auto agora = Relogio::now();
+    double segundos = std::chrono::duration<double>(agora - inicio).count();
+    auto c = agregador.contadores();
+    std::printf(
+        "%zu medidores | %.0f datagramas/s, %.0f registros/s | invalidos "
+        "%llu, roubos %.1f%%\n",
+        agregador.dispositivos(), (c.datagramas - anterior.datagramas) / segundos,
+        (c.registros - anterior.registros) / segundos,
+        (unsigned long long)c.invalidos,
+        c.processados ? 100.0 * c.roubados / c.processados : 0.0);
+
+    std::vector<std::pair<double, size_t>> ordem;
+    for (size_t i = 0; i < agregador.dispositivos(); i++) {
+      ordem.emplace_back(agregador.dispositivo(i).ler().leq_db, i);
+    }
+    std::sort(ordem.rbegin(), ordem.rend());
+    for (size_t k = 0; k < ordem.size() && k < 10; k++) {
+      const auto &d = agregador.dispositivo(ordem[k].second);
+      Estatisticas e = d.ler();
+      std::printf("  %-24s Leq %5.1f  Lmax %5.1f  %6.1f alertas/h  perdidos %llu\n",
+                  d.sala.c_str(), e.leq_db, e.lmax_db, e.alertas_hora,
+                  (unsigned long long)d.datagramas_perdidos.load());
+    }
+    std::fflush(stdout);
+    anterior = c;
+    inicio = agora;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int porta = argc > 1 ? std::atoi(argv[1]) : TELEMETRIA_PORTA_PADRAO;
+  int trabalhadores =
+      argc > 2 ? std::atoi(argv[2])
+               : std::max(1, (int)std::thread::hardware_concurrency() - 2);
+
+  Agregador agregador(trabalhadores, kCapacidade);
+  if (argc > 3) {
+    std::ifstream arquivo(argv[3]);
+    std::string linha;
+    while (std::getline(arquivo, linha)) {
+      size_t virgula = linha.find(',');
+      if (virgula == std::string::npos) continue;
+      agregador.definir_sala(std::strtoull(linha.c_str(), nullptr, 16),
+                             linha.substr(virgula + 1));
+    }
+  }
+
+  std::thread(atender_consultas, std::cref(agregador), porta + 1).detach();
+  std::thread(relatar, std::cref(agregador)).detach();
+  std::fprintf(stderr, "telemetria na porta %d, consultas na %d, %d "
+               "trabalhadores\n", porta, porta + 1, trabalhadores);
+
+  // Receptor: lotes de datagramas por chamada de sistema
+  int s = abrir_udp(porta);
+  static uint8_t buffers[kLote][2048];
+  iovec vetores[kLote];
+  mmsghdr mensagens[kLote];
+  for (int i = 0; i < kLote; i++) {
+    vetores[i] = {buffers[i], sizeof(buffers[i])};
+    mensagens[i] = {};
+    mensagens[i].msg_hdr.msg_iov = &vetores[i];
+    mensagens[i].msg_hdr.msg_iovlen = 1;
+  }
+  for (;;) {
+    int n = recvmmsg(s, mensagens, kLote, MSG_WAITFORONE, nullptr);
+    if (n < 0) {
+      std::perror("recvmmsg");
+      return 1;
+    }
+    for (int i = 0; i < n; i++) {
+      agregador.ingerir(buffers[i], mensagens[i].msg_len);
+    }
+  }
+}
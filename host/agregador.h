@@ -0,0 +1,550 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include "telemetria_protocolo.h"
+}
+
+#ifndef agregador_inc_h
+#define agregador_inc_h
+
+// Agregador da telemetria de uma frota de medidores (um por sala). Uma única
+// thread receptora valida os datagramas (inc/telemetria_protocolo.h) e põe os
+// registros na fila do dispositivo; trabalhadores calculam as estatísticas
+// deslizantes de cada dispositivo e as publicam para consulta.
+//
+//  - Cada dispositivo tem uma fila de um produtor (o receptor) e um
+//    consumidor (o trabalhador que o estiver processando), sem travas.
+//  - Um dispositivo com registros novos é agendado uma única vez (flag
+//    atômica) na caixa de entrada de um trabalhador, escolhida pelo índice.
+//    Trabalhador sem serviço rouba dispositivos das caixas dos outros: as
+//    caixas são filas limitadas de vários produtores e consumidores.
+//  - O resultado é publicado com um seqlock: a consulta nunca espera o
+//    trabalhador e custa algumas dezenas de nanossegundos.
+//  - A tabela de dispositivos tem capacidade fixa e só o receptor insere;
+//    a busca por número de série é lock-free (endereçamento aberto).
+
+namespace agregador {
+
+constexpr size_t kLinhaCache = 64;
+constexpr uint32_t kJanelaSegundos = 300;  // Janela deslizante (5 min)
+constexpr size_t kFilaRegistros = 1024;    // Por dispositivo (potência de 2)
+
+// Fila circular de um produtor e um consumidor
+template <typename T, size_t N>
+class FilaSpsc {
+  static_assert((N & (N - 1)) == 0, "N precisa ser potência de 2");
+
+ public:
+  bool inserir(const T &item) {
+    size_t escrita = escrita_.load(std::memory_order_relaxed);
+    if (escrita - leitura_.load(std::memory_order_acquire) >= N) return false;
+    itens_[escrita & (N - 1)] = item;
+    escrita_.store(escrita + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool retirar(T *item) {
+    size_t leitura = leitura_.load(std::memory_order_relaxed);
+    if (leitura == escrita_.load(std::memory_order_acquire)) return false;
+    *item = itens_[leitura & (N - 1)];
+    leitura_.store(leitura + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool vazia() const {
+    return leitura_.load(std::memory_order_acquire) ==
+           escrita_.load(std::memory_order_acquire);
+  }
+
+ private:
+  std::array<T, N> itens_;
+  alignas(kLinhaCache) std::atomic<size_t> escrita_{0};
+  alignas(kLinhaCache) std::atomic<size_t> leitura_{0};
+};
+
+// Fila circular limitada de vários produtores e consumidores (algoritmo de
+// Vyukov: cada célula tem um número de sequência que diz de quem é a vez)
+template <typename T>
+class FilaMpmc {
+ public:
+  explicit FilaMpmc(size_t capacidade) {
+    size_t n = 1;
+    while (n < capacidade) n <<= 1;
+    mascara_ = n - 1;
+    celulas_.reset(new Celula[n]);
+    for (size_t i = 0; i < n; i++) {
+      celulas_[i].sequencia.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  bool inserir(const T &item) {
+    size_t pos = escrita_.load(std::memory_order_relaxed);
+    for (;;) {
+      Celula &c = celulas_[pos & mascara_];
+      size_t seq = c.sequencia.load(std::memory_order_acquire);
+      intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+      if (dif == 0) {
+        if (escrita_.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+          c.item = item;
+          c.sequencia.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (dif < 0) {
+        return false;  // Cheia
+      } else {
+        pos = escrita_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool retirar(T *item) {
+    size_t pos = leitura_.load(std::memory_order_relaxed);
+    for (;;) {
+      Celula &c = celulas_[pos & mascara_];
+      size_t seq = c.sequencia.load(std::memory_order_acquire);
+      intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (dif == 0) {
+        if (leitura_.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+          *item = c.item;
+          c.sequencia.store(pos + mascara_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (dif < 0) {
+        return false;  // Vazia
+      } else {
+        pos = leitura_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+  struct Celula {
+    std::atomic<size_t> sequencia;
+    T item;
+  };
+  std::unique_ptr<Celula[]> celulas_;
+  size_t mascara_ = 0;
+  alignas(kLinhaCache) std::atomic<size_t> escrita_{0};
+  alignas(kLinhaCache) std::atomic<size_t> leitura_{0};
+};
+
+// Registro na fila de um dispositivo, com a sessão (boot) de origem
+struct Entrada {
+  telemetria_registro_t registro;
+  uint16_t sessao;
+};
+
+// Estatísticas publicadas de um dispositivo, na janela deslizante que
+// termina no segundo mais recente recebido
+struct Estatisticas {
+  double leq_db = 0.0;
+  double lmax_db = 0.0;
+  double alertas_hora = 0.0;   // Taxa de alertas extrapolada para 1 h
+  uint32_t ultimo_segundo = 0; // Segundos desde o boot do medidor
+  uint32_t segundos = 0;       // Segundos com registro dentro da janela
+  uint64_t registros = 0;      // Desde o início do agregador
+};
+
+class Dispositivo {
+ public:
+  uint64_t id = 0;
+  uint32_t indice = 0;
+  std::string sala;
+
+  // Receptor: registros novos e continuidade dos datagramas
+  FilaSpsc<Entrada, kFilaRegistros> fila;
+  uint16_t sessao = 0;
+  uint32_t proxima_sequencia = 0;
+  std::atomic<uint64_t> datagramas_perdidos{0};
+  std::atomic<uint64_t> registros_descartados{0};  // Fila cheia
+
+  // Dono do processamento: só quem trocou false por true
+  std::atomic<bool> agendado{false};
+
+  // Trabalhador (com `agendado`): consome a fila e publica o resultado
+  void processar() {
+    Entrada e;
+    bool novos = false;
+    while (fila.retirar(&e)) {
+      acumular(e);
+      novos = true;
+    }
+    if (novos) publicar();
+  }
+
+  // Qualquer thread: cópia consistente da última publicação
+  Estatisticas ler() const {
+    Estatisticas e;
+    uint32_t v1, v2;
+    do {
+      v1 = versao_.load(std::memory_order_acquire);
+      e.leq_db = carregar(0);
+      e.lmax_db = carregar(1);
+      e.alertas_hora = carregar(2);
+      uint64_t segundos = publicado_[3].load(std::memory_order_relaxed);
+      e.ultimo_segundo = (uint32_t)segundos;
+      e.segundos = (uint32_t)(segundos >> 32);
+      e.registros = publicado_[4].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      v2 = versao_.load(std::memory_order_relaxed);
+    } while ((v1 & 1) || v1 != v2);
+    return e;
+  }
+
+ private:
+  struct Segundo {
+    uint32_t segundo = 0;
+    bool valido = false;
+    uint16_t lmax_ddb = 0;
+    uint16_t alertas = 0;
+    double energia = 0.0;  // 10^(Leq/10)
+  };
+
+  void acumular(const Entrada &e) {
+    const telemetria_registro_t &r = e.registro;
+    registros_++;
+
+    // Um novo boot recomeça a contagem de segundos: a janela é esvaziada
+    if (registros_ == 1 || e.sessao != sessao_) {
+      for (Segundo &s : janela_) s.valido = false;
+      sessao_ = e.sessao;
+      ultimo_ = r.segundo;
+    }
+    if (r.segundo + kJanelaSegundos <= ultimo_) return;  // Atrasado demais
+    if (r.segundo > ultimo_) ultimo_ = r.segundo;
+    Segundo &s = janela_[r.segundo % kJanelaSegundos];
+    s.segundo = r.segundo;
+    s.valido = true;
+    s.lmax_ddb = r.lmax_ddb;
+    s.alertas = r.alertas;
+    s.energia = std::pow(10.0, r.leq_ddb / 100.0);
+  }
+
+  void publicar() {
+    double energia = 0.0;
+    uint16_t lmax = 0;
+    uint32_t alertas = 0, segundos = 0;
+    for (const Segundo &s : janela_) {
+      if (!s.valido || s.segundo > ultimo_ ||
+          s.segundo + kJanelaSegundos <= ultimo_) {
+        continue;
+      }
+      energia += s.energia;
+      if (s.lmax_ddb > lmax) lmax = s.lmax_ddb;
+      alertas += s.alertas;
+      segundos++;
+    }
+
+    uint32_t v = versao_.load(std::memory_order_relaxed);
+    versao_.store(v + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    guardar(0, segundos ? 10.0 * std::log10(energia / segundos) : 0.0);
+    guardar(1, lmax / 10.0);
+    guardar(2, segundos ? alertas * 3600.0 / segundos : 0.0);
+    publicado_[3].store((uint64_t)segundos << 32 | ultimo_,
+                        std::memory_order_relaxed);
+    publicado_[4].store(registros_, std::memory_order_relaxed);
+    versao_.store(v + 2, std::memory_order_release);
+  }
+
+  void guardar(int i, double valor) {
+    uint64_t bits;
+    std::memcpy(&bits, &valor, sizeof(bits));
+    publicado_[i].store(bits, std::memory_order_relaxed);
+  }
+
+  double carregar(int i) const {
+    uint64_t bits = publicado_[i].load(std::memory_order_relaxed);
+    double valor;
+    std::memcpy(&valor, &bits, sizeof(valor));
+    return valor;
+  }
+
+  std::array<Segundo, kJanelaSegundos> janela_;
+  uint32_t ultimo_ = 0;
+  uint16_t sessao_ = 0;
+  uint64_t registros_ = 0;
+
+  alignas(kLinhaCache) std::atomic<uint32_t> versao_{0};
+  std::array<std::atomic<uint64_t>, 5> publicado_{};
+};
+
+struct Contadores {
+  uint64_t datagramas = 0;
+  uint64_t invalidos = 0;
+  uint64_t registros = 0;
+  uint64_t processados = 0;  // Dispositivos processados pelos trabalhadores
+  uint64_t roubados = 0;     // ... dos quais vindos da caixa de outro
+  uint64_t sem_espaco = 0;   // Dispositivos novos além da capacidade
+};
+
+class Agregador {
+ public:
+  Agregador(int trabalhadores, size_t capacidade)
+      : capacidade_(capacidade),
+        mascara_tabela_(tamanho_tabela(capacidade) - 1),
+        chaves_(new std::atomic<uint64_t>[mascara_tabela_ + 1]),
+        posicoes_(new uint32_t[mascara_tabela_ + 1]),
+        dispositivos_(new Dispositivo[capacidade]) {
+    for (size_t i = 0; i <= mascara_tabela_; i++) chaves_[i].store(0);
+    for (int i = 0; i < trabalhadores; i++) {
+      caixas_.emplace_back(new Caixa(capacidade));
+    }
+    for (int i = 0; i < trabalhadores; i++) {
+      threads_.emplace_back(&Agregador::trabalhar, this, i);
+    }
+  }
+
+  ~Agregador() {
+    parar_.store(true);
+    for (auto &t : threads_) t.join();
+  }
+
+  // Nome da sala de um dispositivo (antes da chegada dos dados; sem nome, a
+  // sala é o número de série em hexadecimal)
+  void definir_sala(uint64_t id, const std::string &sala) {
+    salas_[id] = sala;
+    por_sala_[sala] = id;
+  }
+
+  // Receptor (uma única thread): valida o datagrama, confere a sequência e
+  // enfileira os registros no dispositivo, agendando-o se estava ocioso
+  bool ingerir(const uint8_t *dados, size_t n) {
+    telemetria_cabecalho_t cabecalho;
+    if (n < sizeof(cabecalho)) return invalido();
+    std::memcpy(&cabecalho, dados, sizeof(cabecalho));
+    if (cabecalho.magica != TELEMETRIA_MAGICA ||
+        cabecalho.versao != TELEMETRIA_VERSAO ||
+        n != sizeof(cabecalho) +
+                 cabecalho.quantidade * sizeof(telemetria_registro_t)) {
+      return invalido();
+    }
+
+    Dispositivo *d = buscar_ou_criar(cabecalho.dispositivo);
+    if (d == nullptr) return false;
+    datagramas_.fetch_add(1, std::memory_order_relaxed);
+
+    if (cabecalho.sessao != d->sessao) {
+      d->sessao = cabecalho.sessao;  // Novo boot: a sequência recomeça
+    } else if (cabecalho.sequencia > d->proxima_sequencia) {
+      d->datagramas_perdidos.fetch_add(
+          cabecalho.sequencia - d->proxima_sequencia,
+          std::memory_order_relaxed);
+    }
+    d->proxima_sequencia = cabecalho.sequencia + 1;
+
+    const uint8_t *p = dados + sizeof(cabecalho);
+    Entrada e;
+    e.sessao = cabecalho.sessao;
+    for (int i = 0; i < cabecalho.quantidade; i++) {
+      std::memcpy(&e.registro, p + i * sizeof(e.registro),
+                  sizeof(e.registro));
+      if (!d->fila.inserir(e)) {
+        d->registros_descartados.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    registros_.fetch_add(cabecalho.quantidade, std::memory_order_relaxed);
+    agendar(d);
+    return true;
+  }
+
+  // Consulta por número de série (qualquer thread, sem travas)
+  bool consultar(uint64_t id, Estatisticas *estatisticas) const {
+    const Dispositivo *d = buscar(id);
+    if (d == nullptr) return false;
+    *estatisticas = d->ler();
+    return true;
+  }
+
+  // Consulta por sala: nome definido em definir_sala ou o número de série
+  bool consultar_sala(const std::string &sala,
+                      Estatisticas *estatisticas) const {
+    auto it = por_sala_.find(sala);
+    if (it != por_sala_.end()) return consultar(it->second, estatisticas);
+    char *fim = nullptr;
+    uint64_t id = std::strtoull(sala.c_str(), &fim, 16);
+    return fim != sala.c_str() && *fim == '\0' && consultar(id, estatisticas);
+  }
+
+  size_t dispositivos() const {
+    return total_.load(std::memory_order_acquire);
+  }
+
+  // Dispositivo por ordem de chegada (0 <= i < dispositivos())
+  const Dispositivo &dispositivo(size_t i) const { return dispositivos_[i]; }
+
+  Contadores contadores() const {
+    Contadores c;
+    c.datagramas = datagramas_.load(std::memory_order_relaxed);
+    c.invalidos = invalidos_.load(std::memory_order_relaxed);
+    c.registros = registros_.load(std::memory_order_relaxed);
+    c.sem_espaco = sem_espaco_.load(std::memory_order_relaxed);
+    for (const auto &caixa : caixas_) {
+      c.processados += caixa->processados.load(std::memory_order_relaxed);
+      c.roubados += caixa->roubados.load(std::memory_order_relaxed);
+    }
+    return c;
+  }
+
+  // Nenhum dispositivo agendado e todas as filas vazias
+  bool ocioso() const {
+    for (size_t i = 0; i < dispositivos(); i++) {
+      const Dispositivo &d = dispositivos_[i];
+      if (d.agendado.load(std::memory_order_acquire) || !d.fila.vazia()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  struct alignas(kLinhaCache) Caixa {
+    explicit Caixa(size_t capacidade) : fila(capacidade) {}
+    FilaMpmc<uint32_t> fila;
+    std::atomic<uint64_t> processados{0};
+    std::atomic<uint64_t> roubados{0};
+  };
+
+  static size_t tamanho_tabela(size_t capacidade) {
+    size_t n = 1;
+    while (n < 2 * capacidade) n <<= 1;  // Ocupação máxima de 50%
+    return n;
+  }
+
+  static size_t espalhar(uint64_t id) {
+    id ^= id >> 33;
+    id *= 0xff51afd7ed558ccdULL;
+    id ^= id >> 33;
+    return (size_t)id;
+  }
+
+  bool invalido() {
+    invalidos_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  const Dispositivo *buscar(uint64_t id) const {
+    if (id == 0) return nullptr;
+    for (size_t i = espalhar(id) & mascara_tabela_;;
+         i = (i + 1) & mascara_tabela_) {
+      uint64_t chave = chaves_[i].load(std::memory_order_acquire);
+      if (chave == id) return &dispositivos_[posicoes_[i]];
+      if (chave == 0) return nullptr;
+    }
+  }
+
+  // Só o receptor insere: a chave é publicada depois do dispositivo pronto
+  Dispositivo *buscar_ou_criar(uint64_t id) {
+    if (id == 0) return nullptr;
+    size_t i = espalhar(id) & mascara_tabela_;
+    for (;; i = (i + 1) & mascara_tabela_) {
+      uint64_t chave = chaves_[i].load(std::memory_order_relaxed);
+      if (chave == id) return &dispositivos_[posicoes_[i]];
+      if (chave == 0) break;
+    }
+    size_t n = total_.load(std::memory_order_relaxed);
+    if (n >= capacidade_) {
+      sem_espaco_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    Dispositivo &d = dispositivos_[n];
+    d.id = id;
+    d.indice = (uint32_t)n;
+    auto sala = salas_.find(id);
+    if (sala != salas_.end()) {
+      d.sala = sala->second;
+    } else {
+      char hex[17];
+      std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)id);
+      d.sala = hex;
+    }
+    posicoes_[i] = (uint32_t)n;
+    chaves_[i].store(id, std::memory_order_release);
+    total_.store(n + 1, std::memory_order_release);
+    return &d;
+  }
+
+  // A troca seq_cst pareia com a cerca do trabalhador ao liberar: ou ela vê
+  // agendado = false, ou o trabalhador vê os registros recém-enfileirados
+  void agendar(Dispositivo *d) {
+    if (d->agendado.exchange(true, std::memory_order_seq_cst)) return;
+    // Cada dispositivo está no máximo uma vez nas caixas: nunca enchem
+    caixas_[d->indice % caixas_.size()]->fila.inserir(d->indice);
+  }
+
+  void trabalhar(int eu) {
+    Caixa &minha = *caixas_[eu];
+    int ociosidade = 0;
+    while (!parar_.load(std::memory_order_relaxed)) {
+      uint32_t indice;
+      bool roubado = false;
+      bool achou = minha.fila.retirar(&indice);
+      for (size_t k = 1; !achou && k < caixas_.size(); k++) {
+        achou = caixas_[(eu + k) % caixas_.size()]->fila.retirar(&indice);
+        roubado = achou;
+      }
+      if (!achou) {
+        // Sem serviço: gira um pouco e depois dorme em passos curtos
+        if (++ociosidade < 64) {
+          std::this_thread::yield();
+        } else {
+          std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        continue;
+      }
+      ociosidade = 0;
+
+      Dispositivo &d = dispositivos_[indice];
+      d.processar();
+      minha.processados.fetch_add(1, std::memory_order_relaxed);
+      if (roubado) minha.roubados.fetch_add(1, std::memory_order_relaxed);
+
+      // Libera o dispositivo; se chegou registro entre o fim do consumo e a
+      // liberação, reagenda (o receptor pode ter visto agendado = true)
+      d.agendado.store(false, std::memory_order_release);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!d.fila.vazia() &&
+          !d.agendado.exchange(true, std::memory_order_acq_rel)) {
+        minha.fila.inserir(indice);
+      }
+    }
+  }
+
+  const size_t capacidade_;
+  const size_t mascara_tabela_;
+  std::unique_ptr<std::atomic<uint64_t>[]> chaves_;
+  std::unique_ptr<uint32_t[]> posicoes_;
+  std::unique_ptr<Dispositivo[]> dispositivos_;
+  std::atomic<size_t> total_{0};
+
+  // Preenchidos antes da chegada dos dados e só lidos depois
+  std::unordered_map<uint64_t, std::string> salas_;
+  std::unordered_map<std::string, uint64_t> por_sala_;
+
+  std::vector<std::unique_ptr<Caixa>> caixas_;
+  std::vector<std::thread> threads_;
+  std::atomic<bool> parar_{false};
+
+  std::atomic<uint64_t> datagramas_{0};
+  std::atomic<uint64_t> invalidos_{0};
+  std::atomic<uint64_t> registros_{0};
+  std::atomic<uint64_t> sem_espaco_{0};
+};
+
+}  // namespace agregador
+
+#endif
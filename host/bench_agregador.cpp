@@ -0,0 +1,203 @@
+// ==========================================================================
+// Frota sintética de medidores para o agregador (host/agregador.h).
+// Uso: bench_agregador [medidores] [horas] [trabalhadores]
+//      bench_agregador --udp <ip> [porta] [medidores] [aceleracao]
+//
+// Cada medidor sintético tem um nível próprio e constante e manda um
+// datagrama com 10 registros de um segundo, como o firmware.
+//
+// Sem --udp: gera `horas` de telemetria de todos os medidores, entrega os
+// datagramas a um Agregador na mesma ordem em que chegariam pela rede e mede
+// a vazão de ingestão (uma thread receptora, como no serviço) até os
+// trabalhadores esvaziarem as filas. Ao mesmo tempo, outra thread consulta
+// salas aleatórias e mede a latência de cada consulta. No fim confere o Leq
+// publicado de cada medidor contra o nível sintético.
+//
+// Com --udp: envia a frota em tempo real acelerado para um agregador em
+// execução (padrão: 100 vezes, ou seja, 10 datagramas/s por medidor).
+// ==========================================================================
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "agregador.h"
+
+namespace {
+
+using Relogio = std::chrono::steady_clock;
+
+constexpr int kRegistrosPorDatagrama = 10;
+
+uint64_t id_medidor(int i) { return 0xE661000000000000ULL + i + 1; }
+
+// Nível sintético de cada medidor (décimos de dB): entre 40 e 80 dB
+uint16_t nivel_medidor(int i) { return 400 + (i * 37) % 400; }
+
+// Datagrama do medidor i com os registros a partir de `segundo`
+std::vector<uint8_t> datagrama(int i, uint32_t sequencia, uint32_t segundo) {
+  std::vector<uint8_t> dados(sizeof(telemetria_cabecalho_t) +
+                             kRegistrosPorDatagrama *
+                                 sizeof(telemetria_registro_t));
+  telemetria_cabecalho_t cabecalho = {TELEMETRIA_MAGICA,
+                                      TELEMETRIA_VERSAO,
+                                      kRegistrosPorDatagrama,
+                                      1,
+                                      id_medidor(i),
+                                      sequencia,
+                                      0};
+  std::memcpy(dados.data(), &cabecalho, sizeof(cabecalho));
+  for (int k = 0; k < kRegistrosPorDatagrama; k++) {
+    telemetria_registro_t r = {segundo + k, nivel_medidor(i),
+                               (uint16_t)(nivel_medidor(i) + 100),
+                               (uint16_t)((segundo + k) % 600 == 0)};
+    std::memcpy(dados.data() + sizeof(cabecalho) + k * sizeof(r), &r,
+                sizeof(r));
+  }
+  return dados;
+}
+
+int simular(int medidores, double horas, int trabalhadores) {
+  uint32_t rodadas = (uint32_t)(horas * 3600 / kRegistrosPorDatagrama);
+  std::vector<std::vector<uint8_t>> datagramas;
+  datagramas.reserve((size_t)rodadas * medidores);
+  for (uint32_t r = 0; r < rodadas; r++) {
+    for (int i = 0; i < medidores; i++) {
+      datagramas.push_back(datagrama(i, r, r * kRegistrosPorDatagrama));
+    }
+  }
+
+  agregador::Agregador agregador(trabalhadores, medidores);
+  std::atomic<bool> fim{false};
+  std::vector<uint32_t> latencias;
+  uint64_t consultas = 0, encontradas = 0;
+
+  // Consultas concorrentes durante toda a ingestão
+  std::thread consultor([&] {
+    std::mt19937 aleatorio(42);
+    std::vector<std::string> salas;
+    char hex[17];
+    for (int i = 0; i < medidores; i++) {
+      std::snprintf(hex, sizeof(hex), "%016llx",
+                    (unsigned long long)id_medidor(i));
+      salas.push_back(hex);
+    }
+    agregador::Estatisticas e;
+    while (!fim.load(std::memory_order_relaxed)) {
+      const std::string &sala = salas[aleatorio() % salas.size()];
+      auto inicio = Relogio::now();
+      bool ok = agregador.consultar_sala(sala, &e);
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Relogio::now() - inicio)
+                    .count();
+      consultas++;
+      encontradas += ok;
+      if (latencias.size() < 1000000) latencias.push_back((uint32_t)ns);
+    }
+  });
+
+  auto inicio = Relogio::now();
+  for (const auto &d : datagramas) agregador.ingerir(d.data(), d.size());
+  auto ingerido = Relogio::now();
+  while (!agregador.ocioso()) std::this_thread::yield();
+  auto processado = Relogio::now();
+  fim.store(true);
+  consultor.join();
+
+  double t_ingestao = std::chrono::duration<double>(ingerido - inicio).count();
+  double t_total = std::chrono::duration<double>(processado - inicio).count();
+  auto c = agregador.contadores();
+  std::printf("%d medidores, %.1f h cada, %d trabalhadores\n", medidores,
+              horas, trabalhadores);
+  std::printf("  %llu datagramas, %llu registros em %.3f s (ingestao %.3f s)\n",
+              (unsigned long long)c.datagramas,
+              (unsigned long long)c.registros, t_total, t_ingestao);
+  std::printf("  %.2f M datagramas/s, %.2f M registros/s\n",
+              c.datagramas / t_total / 1e6, c.registros / t_total / 1e6);
+  std::printf("  processamentos %llu, roubados %.1f%%\n",
+              (unsigned long long)c.processados,
+              c.processados ? 100.0 * c.roubados / c.processados : 0.0);
+
+  std::sort(latencias.begin(), latencias.end());
+  if (!latencias.empty()) {
+    std::printf("  consultas: %llu (%llu com dados), mediana %u ns, p99 %u ns, "
+                "max %u ns\n",
+                (unsigned long long)consultas,
+                (unsigned long long)encontradas,
+                latencias[latencias.size() / 2],
+                latencias[latencias.size() * 99 / 100], latencias.back());
+  }
+
+  // Nível constante: o Leq e o Lmax publicados têm de ser o sintético
+  int conferidos = 0;
+  for (int i = 0; i < medidores; i++) {
+    agregador::Estatisticas e;
+    if (agregador.consultar(id_medidor(i), &e) &&
+        std::fabs(e.leq_db - nivel_medidor(i) / 10.0) < 0.05 &&
+        std::fabs(e.lmax_db - nivel_medidor(i) / 10.0 - 10.0) < 0.05) {
+      conferidos++;
+    }
+  }
+  std::printf("  conferidos: %d/%d medidores\n", conferidos, medidores);
+  return conferidos == medidores ? 0 : 1;
+}
+
+int enviar(const char *ip, int porta, int medidores, double aceleracao) {
+  int s = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in destino{};
+  destino.sin_family = AF_INET;
+  destino.sin_port = htons(porta);
+  if (s < 0 || inet_pton(AF_INET, ip, &destino.sin_addr) != 1) {
+    std::fprintf(stderr, "destino invalido: %s\n", ip);
+    return 1;
+  }
+
+  // Uma rodada = 10 s simulados: cada medidor manda um datagrama
+  auto periodo = std::chrono::duration<double>(kRegistrosPorDatagrama /
+                                               aceleracao);
+  auto proxima = Relogio::now();
+  uint64_t enviados = 0;
+  for (uint32_t r = 0;; r++) {
+    for (int i = 0; i < medidores; i++) {
+      auto d = datagrama(i, r, r * kRegistrosPorDatagrama);
+      if (sendto(s, d.data(), d.size(), 0,
+                 reinterpret_cast<sockaddr *>(&destino), sizeof(destino)) > 0) {
+        enviados++;
+      }
+    }
+    proxima += std::chrono::duration_cast<Relogio::duration>(periodo);
+    std::this_thread::sleep_until(proxima);
+    if (r % 10 == 9) {
+      std::printf("%llu datagramas enviados (%.0f/s)\n",
+                  (unsigned long long)enviados,
+                  medidores * aceleracao / kRegistrosPorDatagrama);
+      std::fflush(stdout);
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc > 2 && std::string(argv[1]) == "--udp") {
+    int porta = argc > 3 ? std::atoi(argv[3]) : TELEMETRIA_PORTA_PADRAO;
+    int medidores = argc > 4 ? std::atoi(argv[4]) : 500;
+    double aceleracao = argc > 5 ? std::atof(argv[5]) : 100.0;
+    return enviar(argv[2], porta, medidores, aceleracao);
+  }
+  int medidores = argc > 1 ? std::atoi(argv[1]) : 500;
+  double horas = argc > 2 ? std::atof(argv[2]) : 2.0;
+  int trabalhadores =
+      argc > 3 ? std::atoi(argv[3])
+               : std::max(1, (int)std::thread::hardware_concurrency() - 2);
+  return simular(medidores, horas, trabalhadores);
+}
@@ -0,0 +1,66 @@
+// ==========================================================================
+// Benchmark do banco de filtros (inc/bandas.c) no host.
+// Uso: bench_bandas [taxa_hz] [terco|oitava] [segundos]
+//
+// Processa um sinal sintético (ruído branco + tom de 1 kHz + zumbido de
+// 63 Hz) na taxa escolhida, em blocos do tamanho usado pela aquisição, e
+// informa o custo por amostra e o Leq de cada banda (em dB relativos à
+// unidade interna), o que também serve para conferir onde os tons caem.
+// ==========================================================================
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bandas.h"
+#include "bench_cronometro.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BLOCO 256             // Igual a AQ_AMOSTRAS_BLOCO
+#define CLOCK_RP2040 125e6    // Clock padrão do RP2040 (orçamento de ciclos)
+
+int main(int argc, char **argv) {
+  float taxa = argc > 1 ? atof(argv[1]) : 16000.0f;
+  bool terco = !(argc > 2 && strcmp(argv[2], "oitava") == 0);
+  float segundos = argc > 3 ? atof(argv[3]) : 10.0f;
+
+  static bandas_t bandas;
+  bandas_iniciar(&bandas, taxa, terco);
+
+  size_t total = (size_t)(taxa * segundos) / BLOCO * BLOCO;
+  int16_t *sinal = malloc(total * sizeof(int16_t));
+  uint32_t lcg = 12345;
+  for (size_t i = 0; i < total; i++) {
+    lcg = lcg * 1664525u + 1013904223u;
+    float ruido = ((int32_t)(lcg >> 16) - 32768) / 32768.0f * 400.0f;
+    float tom = 3000.0f * sinf(2.0f * M_PI * 1000.0f * i / taxa);
+    float zumbido = 2000.0f * sinf(2.0f * M_PI * 63.0f * i / taxa);
+    sinal[i] = (int16_t)(ruido + tom + zumbido);
+  }
+
+  uint64_t ns0 = bench_ns(), c0 = bench_ciclos();
+  for (size_t i = 0; i < total; i += BLOCO) {
+    bandas_processar(&bandas, &sinal[i], BLOCO);
+  }
+  uint64_t ns = bench_ns() - ns0, ciclos = bench_ciclos() - c0;
+
+  float leq[BANDAS_MAX];
+  int n = bandas_leq(&bandas, 0.0f, leq);
+
+  printf("Taxa %.0f Hz, %s, %d bandas em %d niveis, %zu amostras\n", taxa,
+         terco ? "terco de oitava" : "oitava", n, bandas.niveis, total);
+  for (int i = 0; i < n; i++) {
+    printf("  %8.1f Hz  %6.1f dB\n", bandas.frequencia[i], leq[i]);
+  }
+  printf("Host: %.1f ns/amostra", (double)ns / total);
+  if (ciclos) printf(", %.1f ciclos/amostra", (double)ciclos / total);
+  printf(", %.4f%% do tempo real\n", 100.0 * ns / 1e9 / segundos);
+  printf("Orcamento no RP2040 a %.0f MHz: %.0f ciclos/amostra\n",
+         CLOCK_RP2040 / 1e6, CLOCK_RP2040 / taxa);
+
+  free(sinal);
+  return 0;
+}
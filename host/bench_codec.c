@@ -0,0 +1,158 @@
+// ==========================================================================
+// Benchmark do formato comprimido do log de medições (inc/codec_medicoes.c).
+// Uso: bench_codec [arquivo.csv] [repeticoes]
+//
+// Lê registros gravados no formato de saída do ler_log
+// (sessao,minuto,leq_db,lmax_db,alertas) ou, sem arquivo (ou com "-"), gera
+// uma semana sintética de uma enfermaria (noites em torno de 40 dB, dias em
+// torno de 55 dB, picos e alertas esporádicos). Codifica tudo em blocos de
+// 256 bytes, confere a decodificação e mostra a razão de compressão e o custo
+// por registro para codificar e decodificar.
+// ==========================================================================
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_cronometro.h"
+#include "codec_medicoes.h"
+
+#define BYTES_BRUTO sizeof(medicao_t)  // Registro sem compressão
+#define BYTES_FLOAT 16  // Instante (uint32) + Leq, Lmax e alertas em float
+
+static uint32_t semente = 12345;
+static float aleatorio(void) {  // Uniforme em [-1, 1)
+  semente = semente * 1664525u + 1013904223u;
+  return (semente >> 8) / 8388608.0f - 1.0f;
+}
+
+static int gerar_semana(medicao_t *registros, int max) {
+  int n = 0;
+  float deriva = 0.0f;
+  for (uint32_t minuto = 0; minuto < 7 * 24 * 60 && n < max; minuto++) {
+    float hora = (minuto % (24 * 60)) / 60.0f;
+    float base = (hora >= 7.0f && hora < 22.0f) ? 55.0f : 40.0f;
+    deriva = 0.9f * deriva + 0.8f * aleatorio();
+    float leq = base + deriva;
+    float lmax = leq + 6.0f + 4.0f * fabsf(aleatorio());
+    if (aleatorio() > 0.97f) lmax += 15.0f;  // Carrinho, porta, bipe
+    registros[n++] = (medicao_t){
+        .minuto = minuto,
+        .sessao = 0,
+        .leq_ddb = (uint16_t)lroundf(leq * 10.0f),
+        .lmax_ddb = (uint16_t)lroundf(lmax * 10.0f),
+        .alertas = lmax > 80.0f};
+  }
+  return n;
+}
+
+static int ler_csv(const char *caminho, medicao_t *registros, int max) {
+  FILE *f = fopen(caminho, "r");
+  if (!f) {
+    perror(caminho);
+    exit(1);
+  }
+  char linha[128];
+  int n = 0;
+  while (n < max && fgets(linha, sizeof(linha), f)) {
+    unsigned sessao, minuto, alertas;
+    float leq, lmax;
+    if (sscanf(linha, "%u,%u,%f,%f,%u", &sessao, &minuto, &leq, &lmax,
+               &alertas) != 5) {
+      continue;  // Cabeçalho ou linha inválida
+    }
+    registros[n++] = (medicao_t){.minuto = minuto,
+                                 .sessao = (uint16_t)sessao,
+                                 .leq_ddb = (uint16_t)lroundf(leq * 10.0f),
+                                 .lmax_ddb = (uint16_t)lroundf(lmax * 10.0f),
+                                 .alertas = (uint16_t)alertas};
+  }
+  fclose(f);
+  return n;
+}
+
+// Codifica todos os registros em blocos consecutivos de `saida`. Retorna o
+// número de blocos
+static int codificar(const medicao_t *registros, int n, uint8_t *saida) {
+  codec_escritor_t escritor;
+  int blocos = 0;
+  codec_iniciar(&escritor, saida);
+  for (int i = 0; i < n; i++) {
+    if (!codec_adicionar(&escritor, &registros[i])) {
+      codec_fechar(&escritor, blocos++);
+      codec_iniciar(&escritor, saida + blocos * CODEC_BLOCO_TAMANHO);
+      codec_adicionar(&escritor, &registros[i]);
+    }
+  }
+  codec_fechar(&escritor, blocos++);
+  return blocos;
+}
+
+int main(int argc, char **argv) {
+  const char *arquivo = argc > 1 ? argv[1] : "-";
+  int repeticoes = argc > 2 ? atoi(argv[2]) : 50;
+  int max = 1 << 20;
+
+  medicao_t *registros = malloc(max * sizeof(medicao_t));
+  medicao_t *decodificados = malloc(max * sizeof(medicao_t));
+  uint8_t *blocos = malloc((size_t)max * CODEC_BLOCO_TAMANHO / 4 + 1024);
+  int n = strcmp(arquivo, "-") ? ler_csv(arquivo, registros, max)
+                               : gerar_semana(registros, max);
+  if (n == 0) {
+    fprintf(stderr, "nenhum registro\n");
+    return 1;
+  }
+
+  int num_blocos = 0;
+  uint64_t ns0 = bench_ns(), c0 = bench_ciclos();
+  for (int r = 0; r < repeticoes; r++) {
+    num_blocos = codificar(registros, n, blocos);
+  }
+  double ns_codificar = (double)(bench_ns() - ns0) / repeticoes / n;
+  double ciclos_codificar = (double)(bench_ciclos() - c0) / repeticoes / n;
+
+  int lidos = 0;
+  ns0 = bench_ns();
+  c0 = bench_ciclos();
+  for (int r = 0; r < repeticoes; r++) {
+    lidos = 0;
+    for (int b = 0; b < num_blocos; b++) {
+      int k = codec_decodificar(blocos + b * CODEC_BLOCO_TAMANHO,
+                                decodificados + lidos, max - lidos);
+      if (k < 0) {
+        fprintf(stderr, "bloco %d invalido\n", b);
+        return 1;
+      }
+      lidos += k;
+    }
+  }
+  double ns_decodificar = (double)(bench_ns() - ns0) / repeticoes / n;
+  double ciclos_decodificar = (double)(bench_ciclos() - c0) / repeticoes / n;
+
+  int diferencas = lidos != n;
+  for (int i = 0; i < n && i < lidos; i++) {
+    diferencas += memcmp(&registros[i], &decodificados[i],
+                         sizeof(medicao_t)) != 0;
+  }
+
+  double bytes = (double)num_blocos * CODEC_BLOCO_TAMANHO;
+  printf("Registros: %d (%.1f dias), blocos de %d bytes: %d\n", n,
+         n / 1440.0, CODEC_BLOCO_TAMANHO, num_blocos);
+  printf("Bytes por registro: %.2f (%.1f registros por bloco)\n", bytes / n,
+         (double)n / num_blocos);
+  printf("Compressao: %.1fx sobre a struct (%zu B), %.1fx sobre floats (%d B)\n",
+         BYTES_BRUTO * n / bytes, BYTES_BRUTO, BYTES_FLOAT * n / bytes,
+         BYTES_FLOAT);
+  printf("Log de 512 KiB: %.0f dias\n",
+         512.0 * 1024 / (bytes / n) / 1440.0);
+  printf("Codificar: %.1f ns/registro (%.0f ciclos do host)\n", ns_codificar,
+         ciclos_codificar);
+  printf("Decodificar: %.1f ns/registro (%.0f ciclos do host)\n",
+         ns_decodificar, ciclos_decodificar);
+  printf("Ida e volta: %s\n", diferencas ? "DIVERGE" : "ok");
+
+  free(registros);
+  free(decodificados);
+  free(blocos);
+  return diferencas != 0;
+}
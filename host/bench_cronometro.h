@@ -0,0 +1,27 @@
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef bench_cronometro_inc_h
+#define bench_cronometro_inc_h
+
+// Relógio monotônico em nanossegundos
+static inline uint64_t bench_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Contador de ciclos da CPU do host (0 onde não houver)
+static inline uint64_t bench_ciclos(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+#endif
@@ -0,0 +1,77 @@
+// ==========================================================================
+// Benchmark da FFT em ponto fixo (inc/fft.c) no host.
+// Uso: bench_fft [taxa_hz] [repeticoes]
+//
+// Para 256, 512 e 1024 pontos: mede o custo de janela + FFT + potência,
+// compara a raia de pico e o erro com uma DFT em ponto flutuante e verifica
+// se o custo cabe no tempo de um bloco (N / taxa_hz) sem perder blocos da
+// aquisição.
+// ==========================================================================
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_cronometro.h"
+#include "fft.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define CLOCK_RP2040 125e6  // Clock padrão do RP2040 (orçamento de ciclos)
+
+int main(int argc, char **argv) {
+  float taxa = argc > 1 ? atof(argv[1]) : 16000.0f;
+  int repeticoes = argc > 2 ? atoi(argv[2]) : 2000;
+
+  static int16_t sinal[FFT_MAX_PONTOS], re[FFT_MAX_PONTOS], im[FFT_MAX_PONTOS];
+  static uint32_t potencia[FFT_MAX_PONTOS / 2];
+
+  for (int log2n = FFT_LOG2_MIN; log2n <= FFT_LOG2_MAX; log2n++) {
+    int n = 1 << log2n;
+    float f_tom = taxa * 37 / n;  // Tom exatamente na raia 37
+    for (int i = 0; i < n; i++) {
+      sinal[i] = (int16_t)(8000.0f * sinf(2.0f * M_PI * f_tom * i / taxa) +
+                           (rand() % 200 - 100));
+    }
+
+    uint64_t ns0 = bench_ns(), c0 = bench_ciclos();
+    for (int r = 0; r < repeticoes; r++) {
+      for (int i = 0; i < n; i++) {
+        re[i] = sinal[i];
+        im[i] = 0;
+      }
+      fft_janela_hann(re, log2n);
+      fft_complexa(re, im, log2n);
+      fft_potencia(re, im, log2n, potencia);
+    }
+    double ns = (double)(bench_ns() - ns0) / repeticoes;
+    double ciclos = (double)(bench_ciclos() - c0) / repeticoes;
+
+    // Referência: DFT em ponto flutuante com a mesma janela e escala 1/N
+    int pico = 0;
+    double erro_max = 0.0, pico_ref = 0.0;
+    for (int k = 0; k < n / 2; k++) {
+      double sr = 0.0, si = 0.0;
+      for (int i = 0; i < n; i++) {
+        double w = 0.5 - 0.5 * cos(2.0 * M_PI * i / n);
+        sr += sinal[i] * w * cos(2.0 * M_PI * k * i / n);
+        si -= sinal[i] * w * sin(2.0 * M_PI * k * i / n);
+      }
+      double mag = sqrt(sr * sr + si * si) / n;
+      double erro = fabs(sqrt((double)potencia[k]) - mag);
+      if (erro > erro_max) erro_max = erro;
+      if (mag > pico_ref) pico_ref = mag;
+      if (potencia[k] > potencia[pico]) pico = k;
+    }
+
+    double bloco_us = 1e6 * n / taxa;
+    printf("N=%4d: %.2f us/FFT", n, ns / 1000.0);
+    if (ciclos > 0) printf(", %.0f ciclos", ciclos);
+    printf(", pico na raia %d (esperada 37), erro max %.2f LSB de %.0f\n",
+           pico, erro_max, pico_ref);
+    printf("        bloco de %.0f us a %.0f Hz = %.0f ciclos no RP2040\n",
+           bloco_us, taxa, bloco_us * CLOCK_RP2040 / 1e6);
+  }
+  return 0;
+}
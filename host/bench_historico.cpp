@@ -0,0 +1,203 @@
+// ==========================================================================
+// Benchmark do histórico colunar (host/historico.h).
+// Uso: bench_historico [base] [salas] [dias]
+//
+// Grava na base (padrão /tmp/bench_historico, recriada) `dias` de níveis por
+// segundo de `salas` medidores sintéticos a partir de 1º de março, na ordem
+// em que chegariam (todas as salas a cada segundo), e mede a vazão de
+// gravação e o tamanho por linha. Depois mede consultas típicas de
+// relatório, mostrando quantos blocos cada uma respondeu pelo índice, leu
+// ou pulou, e confere algumas contra o cálculo direto sobre o gerador.
+// 400 salas por 31 dias são 1,07 bilhão de linhas (uns 3 GB em disco).
+// ==========================================================================
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+
+#include "historico.h"
+
+namespace {
+
+using Relogio = std::chrono::steady_clock;
+
+constexpr int32_t kFuso = -3 * 3600;
+constexpr int64_t kHora = 3600;
+
+uint64_t misturar(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+// Segundo sintético de uma sala: nível de fundo próprio, +10 dB de dia,
+// ruído de ±2 dB, eventos raros de +25 dB e alguns segundos perdidos na
+// rede. Devolve false para os perdidos
+bool gerar(uint32_t sala, int64_t instante, historico::Linha *l) {
+  uint64_t h = misturar(((uint64_t)sala << 40) ^ (uint64_t)instante);
+  if (h % 20000 == 0) return false;
+  int64_t hora = ((instante + kFuso) % historico::kDia) / kHora;
+  int leq = 350 + (sala * 53) % 150 + (hora >= 7 && hora < 22 ? 100 : 0) +
+            (int)((h >> 16) % 41) - 20 + ((h >> 32) % 3000 == 0 ? 250 : 0);
+  l->instante = instante;
+  l->sala = sala;
+  l->leq_ddb = leq;
+  l->lmax_ddb = leq + 20 + (h >> 48) % 30;
+  l->alertas = leq >= 700;
+  return true;
+}
+
+// Mesma consulta calculada linha a linha sobre o gerador
+historico::Resultado direto(uint32_t sala, const historico::Consulta &c) {
+  historico::Resultado r;
+  historico::Linha l;
+  for (int64_t t = c.inicio; t < c.fim; t++) {
+    if (c.janela) {
+      int64_t s = ((t + c.fuso_s - c.janela_inicio) % historico::kDia +
+                   historico::kDia) %
+                  historico::kDia;
+      if (s >= (c.janela_fim + historico::kDia - c.janela_inicio) %
+                   historico::kDia) {
+        continue;
+      }
+    }
+    if (!gerar(sala, t, &l)) continue;
+    r.segundos++;
+    r.energia += historico::energia(l.leq_ddb);
+    r.lmax_ddb = std::max(r.lmax_ddb, l.lmax_ddb);
+    r.alertas += l.alertas;
+    r.acima += l.leq_ddb >= c.limiar_ddb;
+  }
+  return r;
+}
+
+bool iguais(const historico::Resultado &a, const historico::Resultado &b) {
+  return a.segundos == b.segundos &&
+         std::fabs(a.energia - b.energia) <= 1e-9 * b.energia &&
+         a.lmax_ddb == b.lmax_ddb && a.alertas == b.alertas &&
+         a.acima == b.acima;
+}
+
+void medir(const historico::Leitor &leitor, const char *nome,
+           const historico::Consulta &c) {
+  historico::Custo custo;
+  auto inicio = Relogio::now();
+  auto resultados = leitor.consultar(c, &custo);
+  double ms = std::chrono::duration<double, std::milli>(Relogio::now() -
+                                                        inicio)
+                  .count();
+  uint64_t segundos = 0;
+  double leq_max = 0;
+  for (const auto &r : resultados) {
+    segundos += r.segundos;
+    if (r.segundos) leq_max = std::max(leq_max, r.leq_db());
+  }
+  std::printf("%-34s %9.2f ms  %10.0f M linhas/s | indice %7llu, lidos "
+              "%6llu (%7.1f MB), ignorados %7llu | maior Leq %.1f dB\n",
+              nome, ms, segundos / ms / 1e3,
+              (unsigned long long)custo.blocos_indice,
+              (unsigned long long)custo.blocos_lidos, custo.bytes_lidos / 1e6,
+              (unsigned long long)custo.blocos_ignorados, leq_max);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::string base = argc > 1 ? argv[1] : "/tmp/bench_historico";
+  uint32_t salas = argc > 2 ? std::atoi(argv[2]) : 100;
+  int dias = argc > 3 ? std::atoi(argv[3]) : 31;
+
+  for (const char *arquivo : historico::kArquivos) {
+    unlink((base + "/" + arquivo).c_str());
+  }
+  unlink((base + "/blocos.idx").c_str());
+  unlink((base + "/salas.txt").c_str());
+
+  std::tm tm = {};
+  tm.tm_year = 2026 - 1900;
+  tm.tm_mon = 2;
+  tm.tm_mday = 1;
+  int64_t marco = (int64_t)timegm(&tm) - kFuso;
+  int64_t fim = marco + dias * historico::kDia;
+
+  // Gravação
+  {
+    historico::Escritor escritor;
+    if (!escritor.abrir(base)) return 1;
+    char nome[32];
+    for (uint32_t s = 0; s < salas; s++) {
+      std::snprintf(nome, sizeof(nome), "sala%03u", s);
+      escritor.sala(nome);
+    }
+    auto inicio = Relogio::now();
+    historico::Linha l;
+    for (int64_t t = marco; t < fim; t++) {
+      for (uint32_t s = 0; s < salas; s++) {
+        if (gerar(s, t, &l)) escritor.adicionar(l);
+      }
+    }
+    escritor.fechar();
+    double segundos =
+        std::chrono::duration<double>(Relogio::now() - inicio).count();
+    std::printf("%u salas x %d dias: %llu linhas em %.1f s (%.1f M linhas/s, "
+                "com o gerador)\n",
+                salas, dias, (unsigned long long)escritor.linhas(), segundos,
+                escritor.linhas() / segundos / 1e6);
+    std::printf("  %.1f MB em disco, %.2f bytes/linha (%zu sem comprimir), "
+                "%llu blocos\n",
+                escritor.bytes() / 1e6,
+                (double)escritor.bytes() / escritor.linhas(),
+                sizeof(historico::Linha),
+                (unsigned long long)escritor.blocos());
+  }
+
+  historico::Leitor leitor;
+  if (!leitor.abrir(base)) return 1;
+
+  historico::Consulta noite;
+  noite.inicio = marco;
+  noite.fim = fim;
+  noite.janela = true;
+  noite.janela_inicio = 22 * kHora;
+  noite.janela_fim = 7 * kHora;
+  noite.fuso_s = kFuso;
+  medir(leitor, "Leq noturno por sala, periodo todo", noite);
+
+  historico::Consulta dia = noite;
+  dia.janela_inicio = 7 * kHora;
+  dia.janela_fim = 22 * kHora;
+  dia.limiar_ddb = 550;
+  medir(leitor, "Leq diurno e tempo acima de 55 dB", dia);
+
+  historico::Consulta tudo;
+  tudo.inicio = marco;
+  tudo.fim = fim;
+  medir(leitor, "Leq por sala, periodo todo", tudo);
+
+  historico::Consulta tarde;
+  tarde.sala = salas / 2;
+  tarde.inicio = marco + (dias / 2) * historico::kDia + 10 * kHora + 30 * 60;
+  tarde.fim = tarde.inicio + 4 * kHora + 15 * 60;
+  medir(leitor, "Uma sala, 10:30 a 14:45 de um dia", tarde);
+
+  // Conferência contra o gerador em intervalos que cortam blocos
+  int conferidas = 0, total = 0;
+  historico::Consulta casos[3] = {tarde, noite, dia};
+  casos[1].inicio = casos[2].inicio = marco + 2 * historico::kDia + 1234;
+  casos[1].fim = casos[2].fim = casos[1].inicio + 2 * historico::kDia;
+  for (const auto &caso : casos) {
+    for (uint32_t s = 0; s < salas && s < 4; s++) {
+      historico::Consulta c = caso;
+      c.sala = caso.sala == historico::kTodas ? s : caso.sala;
+      auto r = leitor.consultar(c);
+      conferidas += iguais(r[c.sala], direto(c.sala, c));
+      total++;
+    }
+  }
+  std::printf("conferidas contra o gerador: %d/%d\n", conferidas, total);
+  return conferidas == total ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+// ==========================================================================
+// Benchmark e conferência do motor de regras de alerta (inc/regras.c).
+// Uso: bench_regras [leituras] [janela_ms]
+//
+// Compila uma tabela com Leq e Lmax de janelas curtas, de 60 s e da maior
+// janela suportada (REGRAS_LEITURAS_MAX leituras, mais as que são encurtadas
+// para ela), avalia um nível sintético (ruído de fundo, rajadas e picos
+// isolados) e confere cada métrica, a cada leitura, contra o cálculo direto
+// sobre o histórico. Mostra o custo por leitura de regras_avaliar e termina
+// com erro se alguma métrica divergir.
+// ==========================================================================
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_cronometro.h"
+#include "regras.h"
+
+#define TOLERANCIA_DB 0.01f
+
+static const regra_definicao_t definicoes[] = {
+    {"Pico", REGRA_INSTANTANEO, 0, 85.0f, 0, 0, 3.0f, 0, 2000,
+     REGRA_BUZZER_RAPIDO},
+    {"Leq 1s", REGRA_LEQ, 1, 70.0f, 0, 0, 1.0f, 0, 0, REGRA_BUZZER_LENTO},
+    {"Leq 1m", REGRA_LEQ, 60, 55.0f, 0, 0, 1.0f, 0, 10000, REGRA_BUZZER_LENTO},
+    {"Leq max", REGRA_LEQ, 128, 50.0f, 0, 0, 1.0f, 0, 0, REGRA_BUZZER_LENTO},
+    {"Lmax max", REGRA_LMAX, 128, 90.0f, 0, 0, 1.0f, 0, 0, REGRA_BUZZER_SIRENE},
+    // Maior que a janela suportada: compartilha a métrica encurtada
+    {"Lmax 10m", REGRA_LMAX, 600, 95.0f, 0, 0, 1.0f, 0, 0, REGRA_BUZZER_SIRENE},
+};
+#define NUM_DEFINICOES (int)(sizeof(definicoes) / sizeof(definicoes[0]))
+
+static uint32_t semente = 12345;
+static float aleatorio(void) {  // Uniforme em [-1, 1)
+  semente = semente * 1664525u + 1013904223u;
+  return (semente >> 8) / 8388608.0f - 1.0f;
+}
+
+// Nível sintético: fundo com deriva lenta, rajadas de alguns segundos e picos
+// isolados, para que o máximo da janela saia e entre o tempo todo
+static float gerar_nivel(uint32_t n) {
+  static float deriva = 0.0f;
+  deriva = 0.995f * deriva + 0.3f * aleatorio();
+  float db = 45.0f + deriva + 2.0f * aleatorio();
+  if ((n / 200) % 7 == 3) db += 20.0f;
+  if (aleatorio() > 0.998f) db += 40.0f;
+  return db;
+}
+
+// Métrica de janela de leituras calculada diretamente sobre o histórico
+static float metrica_direta(const float *historico, uint32_t n,
+                            regra_metrica_t tipo, uint32_t leituras) {
+  uint32_t presentes = n + 1 < leituras ? n + 1 : leituras;
+  double energia = 0.0;
+  float maior = -INFINITY;
+  for (uint32_t k = 0; k < presentes; k++) {
+    float db = historico[n - k];
+    energia += pow(10.0, db / 10.0);
+    if (db > maior) maior = db;
+  }
+  return tipo == REGRA_LEQ ? (float)(10.0 * log10(energia / presentes))
+                           : maior;
+}
+
+int main(int argc, char **argv) {
+  uint32_t total = argc > 1 ? (uint32_t)atoi(argv[1]) : 20000;
+  uint32_t janela_ms = argc > 2 ? (uint32_t)atoi(argv[2]) : 125;
+
+  static regras_t regras;
+  int compiladas =
+      regras_compilar(&regras, definicoes, NUM_DEFINICOES, janela_ms);
+  printf("%d regras, %d metricas com leituras de %u ms:", compiladas,
+         regras.num_metricas, janela_ms);
+  for (int i = 0; i < regras.num_metricas; i++) {
+    printf(" %s %u", regras.metrica[i].tipo == REGRA_LEQ ? "Leq" : "Lmax",
+           regras.metrica[i].leituras);
+  }
+  printf("\n");
+
+  float *historico = malloc(total * sizeof(float));
+  if (historico == NULL) return 1;
+  for (uint32_t n = 0; n < total; n++) historico[n] = gerar_nivel(n);
+
+  // Conferência: cada métrica a cada leitura
+  uint32_t divergencias = 0, conferidas = 0, encerradas = 0, eventos = 0;
+  for (uint32_t n = 0; n < total; n++) {
+    regras_avaliar(&regras, historico[n], 80.0f, -1, n * janela_ms,
+                   &encerradas);
+    for (int i = 0; i < regras.num_metricas; i++) {
+      const regras_metrica_t *m = &regras.metrica[i];
+      float esperado = metrica_direta(historico, n, m->tipo, m->leituras);
+      conferidas++;
+      if (fabsf(m->valor_db - esperado) > TOLERANCIA_DB) {
+        if (divergencias++ < 5) {
+          printf("  leitura %u, %s %u: %.3f dB, direto %.3f dB\n", n,
+                 m->tipo == REGRA_LEQ ? "Leq" : "Lmax", m->leituras,
+                 m->valor_db, esperado);
+        }
+      }
+    }
+  }
+  for (int i = 0; i < regras.num_regras; i++) {
+    eventos += regras.regra[i].alarme.eventos;
+  }
+
+  // Custo por leitura, numa tabela recompilada
+  regras_compilar(&regras, definicoes, NUM_DEFINICOES, janela_ms);
+  uint64_t t0 = bench_ns();
+  for (uint32_t n = 0; n < total; n++) {
+    regras_avaliar(&regras, historico[n], 80.0f, -1, n * janela_ms,
+                   &encerradas);
+  }
+  uint64_t t1 = bench_ns();
+
+  printf("%u leituras, %u eventos: %.1f ns por leitura\n", total, eventos,
+         (double)(t1 - t0) / total);
+  printf("conferidas contra o calculo direto: %u/%u\n",
+         conferidas - divergencias, conferidas);
+  free(historico);
+  return divergencias ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+// ==========================================================================
+// Gerador de carga para o servidor HTTP do medidor (inc/servidor_http.c).
+// Uso: carga_http <ip> [conexoes] [segundos] [caminho] [porta]
+//
+// Abre `conexoes` clientes simultâneos (padrão 4), cada um repetindo pedidos
+// GET ao caminho (padrão /level) durante `segundos` (padrão 10). Como o
+// servidor fecha a conexão após cada resposta, cada pedido abre uma conexão
+// nova. Mostra pedidos por segundo sustentados, erros e a latência (mediana,
+// p99 e máxima) do pedido completo, da conexão ao fechamento.
+// ==========================================================================
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Relogio = std::chrono::steady_clock;
+
+struct Resultado {
+  uint64_t sucessos = 0;
+  uint64_t erros = 0;      // Conexão recusada, tempo esgotado ou status != 200
+  uint64_t bytes = 0;
+  std::vector<uint32_t> latencias_us;
+};
+
+// Um pedido completo numa conexão nova. Retorna false em qualquer falha
+bool pedir(const sockaddr_in &destino, const std::string &pedido,
+           uint64_t *bytes) {
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  if (s < 0) return false;
+  timeval limite = {2, 0};
+  setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &limite, sizeof(limite));
+  setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &limite, sizeof(limite));
+
+  bool ok = false;
+  if (connect(s, reinterpret_cast<const sockaddr *>(&destino),
+              sizeof(destino)) == 0 &&
+      send(s, pedido.data(), pedido.size(), 0) ==
+          static_cast<ssize_t>(pedido.size())) {
+    char buffer[2048];
+    std::string inicio;
+    ssize_t n;
+    uint64_t total = 0;
+    while ((n = recv(s, buffer, sizeof(buffer), 0)) > 0) {
+      if (inicio.size() < 12) inicio.append(buffer, n);
+      total += n;
+    }
+    ok = n == 0 && inicio.size() >= 12 &&
+         inicio.compare(8, 4, " 200") == 0;  // "HTTP/1.x 200"
+    *bytes += total;
+  }
+  close(s);
+  return ok;
+}
+
+void trabalhador(const sockaddr_in &destino, const std::string &pedido,
+                 Relogio::time_point fim, Resultado *resultado) {
+  while (Relogio::now() < fim) {
+    auto inicio = Relogio::now();
+    bool ok = pedir(destino, pedido, &resultado->bytes);
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                  Relogio::now() - inicio)
+                  .count();
+    if (ok) {
+      resultado->sucessos++;
+      resultado->latencias_us.push_back(static_cast<uint32_t>(us));
+    } else {
+      resultado->erros++;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "uso: %s <ip> [conexoes] [segundos] [caminho] "
+                 "[porta]\n", argv[0]);
+    return 1;
+  }
+  int conexoes = argc > 2 ? std::atoi(argv[2]) : 4;
+  int segundos = argc > 3 ? std::atoi(argv[3]) : 10;
+  std::string caminho = argc > 4 ? argv[4] : "/level";
+  int porta = argc > 5 ? std::atoi(argv[5]) : 80;
+
+  sockaddr_in destino{};
+  destino.sin_family = AF_INET;
+  destino.sin_port = htons(porta);
+  if (inet_pton(AF_INET, argv[1], &destino.sin_addr) != 1) {
+    std::fprintf(stderr, "ip invalido: %s\n", argv[1]);
+    return 1;
+  }
+  std::string pedido = "GET " + caminho + " HTTP/1.1\r\nHost: " +
+                       argv[1] + "\r\nConnection: close\r\n\r\n";
+
+  std::vector<Resultado> resultados(conexoes);
+  std::vector<std::thread> threads;
+  auto inicio = Relogio::now();
+  auto fim = inicio + std::chrono::seconds(segundos);
+  for (int i = 0; i < conexoes; i++) {
+    threads.emplace_back(trabalhador, std::cref(destino), std::cref(pedido),
+                         fim, &resultados[i]);
+  }
+  for (auto &t : threads) t.join();
+  double decorrido =
+      std::chrono::duration<double>(Relogio::now() - inicio).count();
+
+  Resultado total;
+  for (auto &r : resultados) {
+    total.sucessos += r.sucessos;
+    total.erros += r.erros;
+    total.bytes += r.bytes;
+    total.latencias_us.insert(total.latencias_us.end(),
+                              r.latencias_us.begin(), r.latencias_us.end());
+  }
+  std::sort(total.latencias_us.begin(), total.latencias_us.end());
+  auto percentil = [&](double p) -> double {
+    if (total.latencias_us.empty()) return 0.0;
+    size_t i = static_cast<size_t>(p * (total.latencias_us.size() - 1));
+    return total.latencias_us[i] / 1000.0;
+  };
+
+  std::printf("%s%s, %d conexoes, %.1f s\n", argv[1], caminho.c_str(),
+              conexoes, decorrido);
+  std::printf("  %.1f pedidos/s (%llu ok, %llu erros), %.1f kB/s\n",
+              total.sucessos / decorrido,
+              static_cast<unsigned long long>(total.sucessos),
+              static_cast<unsigned long long>(total.erros),
+              total.bytes / decorrido / 1000.0);
+  std::printf("  latencia: mediana %.2f ms, p99 %.2f ms, max %.2f ms\n",
+              percentil(0.5), percentil(0.99), percentil(1.0));
+  return total.erros > 0 && total.sucessos == 0;
+}
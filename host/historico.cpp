@@ -0,0 +1,154 @@
+// ==========================================================================
+// Histórico colunar dos níveis por segundo (host/historico.h).
+// Uso: historico importar <base> [arquivo.csv]
+//      historico consultar <base> <inicio> <fim> [--sala nome]
+//                [--janela 22-7] [--fuso -3] [--limiar 55]
+//
+// importar: anexa à base o CSV do `receptor_telemetria --csv` (entrada
+// padrão sem arquivo); cada medidor vira uma sala com o número de série.
+//
+// consultar: Leq, Lmax, alertas e, com --limiar, a fração do tempo acima do
+// limiar de cada sala entre <inicio> e <fim> (AAAA-MM-DD[THH:MM], hora
+// local). --janela restringe a uma faixa do dia, que pode cruzar a
+// meia-noite; --fuso é o deslocamento da hora local para UTC, em horas.
+// Exemplo, Leq noturno de março por sala:
+//   historico consultar base 2026-03-01 2026-04-01 --janela 22-7 --fuso -3
+// ==========================================================================
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include "historico.h"
+
+namespace {
+
+using Relogio = std::chrono::steady_clock;
+
+int importar(const std::string &base, FILE *entrada) {
+  historico::Escritor escritor;
+  if (!escritor.abrir(base)) return 1;
+  char linha[256], dispositivo[32];
+  unsigned sessao, alertas;
+  unsigned long segundo;
+  long long instante;
+  double leq, lmax;
+  uint64_t ignoradas = 0;
+  while (std::fgets(linha, sizeof(linha), entrada)) {
+    if (std::sscanf(linha, "%31[^,],%u,%lu,%lf,%lf,%u,%lld", dispositivo,
+                    &sessao, &segundo, &leq, &lmax, &alertas,
+                    &instante) != 7) {
+      ignoradas++;  // Cabeçalho, ou CSV sem a coluna instante
+      continue;
+    }
+    historico::Linha l = {instante, escritor.sala(dispositivo),
+                          (uint16_t)std::lround(leq * 10),
+                          (uint16_t)std::lround(lmax * 10),
+                          (uint16_t)alertas};
+    escritor.adicionar(l);
+  }
+  escritor.fechar();
+  std::printf("%llu linhas em %llu blocos, %llu ignoradas\n",
+              (unsigned long long)escritor.linhas(),
+              (unsigned long long)escritor.blocos(),
+              (unsigned long long)ignoradas);
+  return 0;
+}
+
+// AAAA-MM-DD[THH:MM[:SS]] na hora local para segundos UNIX
+bool ler_data(const char *texto, int32_t fuso_s, int64_t *instante) {
+  std::tm tm = {};
+  int n = std::sscanf(texto, "%d-%d-%d%*1[T ]%d:%d:%d", &tm.tm_year,
+                      &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min,
+                      &tm.tm_sec);
+  if (n < 3) return false;
+  tm.tm_year -= 1900;
+  tm.tm_mon -= 1;
+  *instante = (int64_t)timegm(&tm) - fuso_s;
+  return true;
+}
+
+int consultar(const std::string &base, int argc, char **argv) {
+  historico::Consulta c;
+  std::string sala;
+  for (int i = 2; i + 1 < argc; i += 2) {
+    std::string opcao = argv[i];
+    if (opcao == "--sala") {
+      sala = argv[i + 1];
+    } else if (opcao == "--janela") {
+      int inicio, fim;
+      if (std::sscanf(argv[i + 1], "%d-%d", &inicio, &fim) != 2) return 2;
+      c.janela = inicio != fim;
+      c.janela_inicio = (inicio % 24) * 3600;
+      c.janela_fim = (fim % 24) * 3600;
+    } else if (opcao == "--fuso") {
+      c.fuso_s = (int32_t)std::lround(std::atof(argv[i + 1]) * 3600);
+    } else if (opcao == "--limiar") {
+      c.limiar_ddb = (uint16_t)std::lround(std::atof(argv[i + 1]) * 10);
+    }
+  }
+  if (!ler_data(argv[0], c.fuso_s, &c.inicio) ||
+      !ler_data(argv[1], c.fuso_s, &c.fim)) {
+    std::fprintf(stderr, "datas no formato AAAA-MM-DD[THH:MM]\n");
+    return 2;
+  }
+
+  historico::Leitor leitor;
+  if (!leitor.abrir(base)) return 1;
+  if (!sala.empty() && !leitor.buscar_sala(sala, &c.sala)) {
+    std::fprintf(stderr, "sala desconhecida: %s\n", sala.c_str());
+    return 1;
+  }
+
+  historico::Custo custo;
+  auto inicio = Relogio::now();
+  auto resultados = leitor.consultar(c, &custo);
+  double ms = std::chrono::duration<double, std::milli>(Relogio::now() -
+                                                        inicio)
+                  .count();
+
+  std::printf("sala,horas,leq_db,lmax_db,alertas%s\n",
+              c.limiar_ddb != UINT16_MAX ? ",acima_pct" : "");
+  for (uint32_t s = 0; s < resultados.size(); s++) {
+    const auto &r = resultados[s];
+    if (r.segundos == 0) continue;
+    std::printf("%s,%.1f,%.1f,%.1f,%llu", leitor.nome(s).c_str(),
+                r.segundos / 3600.0, r.leq_db(), r.lmax_ddb / 10.0,
+                (unsigned long long)r.alertas);
+    if (c.limiar_ddb != UINT16_MAX) {
+      std::printf(",%.2f", 100.0 * r.acima / r.segundos);
+    }
+    std::printf("\n");
+  }
+  std::fprintf(stderr,
+               "%.2f ms: %llu blocos pelo indice, %llu lidos (%.1f MB), %llu "
+               "ignorados de %zu\n",
+               ms, (unsigned long long)custo.blocos_indice,
+               (unsigned long long)custo.blocos_lidos, custo.bytes_lidos / 1e6,
+               (unsigned long long)custo.blocos_ignorados, leitor.blocos());
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::string comando = argc > 2 ? argv[1] : "";
+  if (comando == "importar") {
+    FILE *entrada = argc > 3 ? std::fopen(argv[3], "r") : stdin;
+    if (entrada == nullptr) {
+      std::perror(argv[3]);
+      return 1;
+    }
+    return importar(argv[2], entrada);
+  }
+  if (comando == "consultar" && argc > 4) {
+    return consultar(argv[2], argc - 3, argv + 3);
+  }
+  std::fprintf(stderr,
+               "uso: historico importar <base> [arquivo.csv]\n"
+               "     historico consultar <base> <inicio> <fim> [--sala nome] "
+               "[--janela 22-7] [--fuso -3] [--limiar 55]\n");
+  return 2;
+}
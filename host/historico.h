@@ -0,0 +1,652 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef historico_inc_h
+#define historico_inc_h
+
+// Histórico de longo prazo dos níveis por segundo de muitas salas, em colunas
+// só de acréscimo. Uma base é um diretório com:
+//   instante.col, leq.col, lmax.col, alertas.col  colunas comprimidas
+//   blocos.idx                                    cabeçalho + um Bloco por
+//                                                 bloco gravado
+//   salas.txt                                     nome de cada sala, uma por
+//                                                 linha (a linha é o número)
+//
+// O escritor acumula as linhas de cada sala e grava um bloco por sala a cada
+// kLinhasBloco linhas (uma hora a 1 Hz): cada coluna do bloco é comprimida
+// sozinha e anexada ao seu arquivo. As entradas do índice esperam na memória
+// e só são anexadas depois de fflush + fsync das colunas e de salas.txt, a
+// cada kBlocosPublicacao blocos e ao fechar, então um índice íntegro nunca
+// aponta para dados incompletos; uma entrada cortada no fim do índice é
+// descartada ao reabrir a base.
+// Formatos das colunas (varints como no log da flash, inc/codec_medicoes.c):
+//   instante  zigzag(primeiro - instante_min), depois pares
+//             (zigzag(delta), repetições): 1 Hz contínuo vira poucos bytes
+//   leq/lmax  primeiro valor, depois zigzag(delta do anterior)
+//   alertas   pares (valor, repetições)
+//
+// O leitor mapeia os arquivos na memória e usa o índice (sala, intervalo,
+// mínimo/máximo de Leq, máximo de Lmax, energia e alertas de cada bloco)
+// para não tocar nos blocos fora da consulta; os blocos inteiramente dentro
+// dela são respondidos só pelo índice, sem descomprimir nada.
+
+namespace historico {
+
+constexpr uint32_t kMagica = 0x5A534948;  // "HISZ"
+constexpr uint32_t kVersao = 1;
+constexpr uint32_t kLinhasBloco = 3600;
+constexpr uint32_t kBlocosPublicacao = 4096;  // Entradas por fsync do índice
+constexpr uint32_t kTodas = UINT32_MAX;
+constexpr int64_t kDia = 86400;
+
+enum Coluna { kInstante, kLeq, kLmax, kAlertas, kColunas };
+constexpr const char *kArquivos[kColunas] = {"instante.col", "leq.col",
+                                             "lmax.col", "alertas.col"};
+
+// Um segundo de medição de uma sala
+struct Linha {
+  int64_t instante;   // Segundos UNIX (UTC)
+  uint32_t sala;
+  uint16_t leq_ddb;   // Décimos de dB
+  uint16_t lmax_ddb;
+  uint16_t alertas;   // Alertas disparados no segundo
+};
+
+// Entrada do índice
+struct Bloco {
+  int64_t instante_min;
+  int64_t instante_max;
+  double energia;             // Soma de 10^(Leq/10) das linhas
+  uint64_t inicio[kColunas];  // Deslocamento do bloco em cada coluna
+  uint32_t tamanho[kColunas];
+  uint32_t sala;
+  uint32_t linhas;
+  uint32_t alertas;
+  uint16_t leq_min;
+  uint16_t leq_max;
+  uint16_t lmax_max;
+  uint16_t reservado[3];
+};
+static_assert(sizeof(Bloco) == 96, "formato do indice");
+
+struct Cabecalho {
+  uint32_t magica;
+  uint32_t versao;
+  uint32_t tamanho_bloco;  // sizeof(Bloco)
+  uint32_t reservado;
+};
+
+// Energia de um nível em décimos de dB, por tabela (65536 valores)
+inline double energia(uint16_t ddb) {
+  static const std::vector<double> tabela = [] {
+    std::vector<double> t(65536);
+    for (size_t i = 0; i < t.size(); i++) t[i] = std::pow(10.0, i / 100.0);
+    return t;
+  }();
+  return tabela[ddb];
+}
+
+inline uint64_t zigzag(int64_t valor) {
+  return ((uint64_t)valor << 1) ^ (uint64_t)(valor >> 63);
+}
+
+inline int64_t dezigzag(uint64_t valor) {
+  return (int64_t)(valor >> 1) ^ -(int64_t)(valor & 1u);
+}
+
+inline void escrever_varint(std::vector<uint8_t> *destino, uint64_t valor) {
+  while (valor >= 0x80u) {
+    destino->push_back((uint8_t)(valor | 0x80u));
+    valor >>= 7;
+  }
+  destino->push_back((uint8_t)valor);
+}
+
+// Lê um varint sem passar de fim; devolve nullptr se estiver truncado
+inline const uint8_t *ler_varint(const uint8_t *p, const uint8_t *fim,
+                                 uint64_t *valor) {
+  if (p < fim && *p < 0x80u) {  // Caso comum: um byte
+    *valor = *p;
+    return p + 1;
+  }
+  uint64_t resultado = 0;
+  for (int n = 0; n < 10 && p < fim; n++, p++) {
+    resultado |= (uint64_t)(*p & 0x7Fu) << (7 * n);
+    if (!(*p & 0x80u)) {
+      *valor = resultado;
+      return p + 1;
+    }
+  }
+  return nullptr;
+}
+
+// Decodificação das colunas de um bloco: devolvem false se o bloco estiver
+// corrompido
+inline bool decodificar_instantes(const uint8_t *p, const uint8_t *fim,
+                                  uint32_t linhas, int64_t base,
+                                  int64_t *saida) {
+  uint64_t v, repeticoes;
+  if (linhas == 0) return true;
+  if (!(p = ler_varint(p, fim, &v))) return false;
+  saida[0] = base + dezigzag(v);
+  for (uint32_t i = 1; i < linhas;) {
+    if (!(p = ler_varint(p, fim, &v)) ||
+        !(p = ler_varint(p, fim, &repeticoes)) || repeticoes > linhas - i) {
+      return false;
+    }
+    int64_t delta = dezigzag(v);
+    for (uint64_t k = 0; k < repeticoes; k++, i++) {
+      saida[i] = saida[i - 1] + delta;
+    }
+  }
+  return true;
+}
+
+inline bool decodificar_niveis(const uint8_t *p, const uint8_t *fim,
+                               uint32_t linhas, uint16_t *saida) {
+  uint64_t v;
+  uint16_t anterior = 0;
+  for (uint32_t i = 0; i < linhas; i++) {
+    if (!(p = ler_varint(p, fim, &v))) return false;
+    anterior = (uint16_t)(i == 0 ? v : anterior + dezigzag(v));
+    saida[i] = anterior;
+  }
+  return true;
+}
+
+inline bool decodificar_alertas(const uint8_t *p, const uint8_t *fim,
+                                uint32_t linhas, uint16_t *saida) {
+  uint64_t valor, repeticoes;
+  for (uint32_t i = 0; i < linhas;) {
+    if (!(p = ler_varint(p, fim, &valor)) ||
+        !(p = ler_varint(p, fim, &repeticoes)) || repeticoes > linhas - i) {
+      return false;
+    }
+    for (uint64_t k = 0; k < repeticoes; k++) saida[i++] = (uint16_t)valor;
+  }
+  return true;
+}
+
+// Nomes das salas (salas.txt)
+inline std::vector<std::string> ler_salas(const std::string &base) {
+  std::vector<std::string> nomes;
+  FILE *f = std::fopen((base + "/salas.txt").c_str(), "r");
+  if (f == nullptr) return nomes;
+  char linha[256];
+  while (std::fgets(linha, sizeof(linha), f)) {
+    linha[std::strcspn(linha, "\r\n")] = '\0';
+    nomes.push_back(linha);
+  }
+  std::fclose(f);
+  return nomes;
+}
+
+// Gravação. As linhas de uma sala devem vir em ordem de tempo para a
+// compressão render; fora de ordem continuam corretas
+class Escritor {
+ public:
+  ~Escritor() { fechar(); }
+
+  // Cria a base ou continua uma existente. Retorna false (com perror) se não
+  // conseguir
+  bool abrir(const std::string &base) {
+    mkdir(base.c_str(), 0755);
+    for (int c = 0; c < kColunas; c++) {
+      colunas_[c] = abrir_arquivo(base + "/" + kArquivos[c], &posicao_[c]);
+      if (colunas_[c] == nullptr) return false;
+    }
+    uint64_t tamanho_indice = 0;
+    indice_ = abrir_arquivo(base + "/blocos.idx", &tamanho_indice);
+    salas_ = abrir_arquivo(base + "/salas.txt", nullptr);
+    if (indice_ == nullptr || salas_ == nullptr) return false;
+    // Uma gravação interrompida pode ter deixado uma entrada pela metade
+    uint64_t inteiro = 0;
+    if (tamanho_indice >= sizeof(Cabecalho)) {
+      inteiro = tamanho_indice -
+                (tamanho_indice - sizeof(Cabecalho)) % sizeof(Bloco);
+    }
+    if (inteiro != tamanho_indice &&
+        ftruncate(fileno(indice_), inteiro) != 0) {
+      std::perror((base + "/blocos.idx").c_str());
+      return false;
+    }
+    if (inteiro == 0) {
+      Cabecalho cabecalho = {kMagica, kVersao, sizeof(Bloco), 0};
+      std::fwrite(&cabecalho, sizeof(cabecalho), 1, indice_);
+    }
+    nomes_ = ler_salas(base);
+    for (uint32_t i = 0; i < nomes_.size(); i++) ids_[nomes_[i]] = i;
+    pendentes_.resize(nomes_.size());
+    return true;
+  }
+
+  // Número da sala, criando-a se for nova
+  uint32_t sala(const std::string &nome) {
+    auto it = ids_.find(nome);
+    if (it != ids_.end()) return it->second;
+    uint32_t id = nomes_.size();
+    nomes_.push_back(nome);
+    ids_[nome] = id;
+    pendentes_.emplace_back();
+    std::fprintf(salas_, "%s\n", nome.c_str());
+    return id;
+  }
+
+  void adicionar(const Linha &linha) {
+    if (linha.sala >= pendentes_.size()) pendentes_.resize(linha.sala + 1);
+    Pendente &p = pendentes_[linha.sala];
+    if (p.linhas == 0) p.reservar();
+    p.instante[p.linhas] = linha.instante;
+    p.leq[p.linhas] = linha.leq_ddb;
+    p.lmax[p.linhas] = linha.lmax_ddb;
+    p.alertas[p.linhas] = linha.alertas;
+    if (++p.linhas == kLinhasBloco) gravar(linha.sala, &p);
+  }
+
+  // Grava os blocos incompletos e fecha os arquivos
+  void fechar() {
+    if (indice_ == nullptr) return;
+    for (uint32_t s = 0; s < pendentes_.size(); s++) {
+      if (pendentes_[s].linhas) gravar(s, &pendentes_[s]);
+    }
+    publicar();
+    for (auto &f : colunas_) std::fclose(f);
+    std::fclose(indice_);
+    std::fclose(salas_);
+    indice_ = nullptr;
+  }
+
+  uint64_t linhas() const { return linhas_; }
+  uint64_t blocos() const { return blocos_; }
+  uint64_t bytes() const {
+    uint64_t total = 0;
+    for (uint64_t p : posicao_) total += p;
+    return total + blocos_ * sizeof(Bloco);
+  }
+
+ private:
+  struct Pendente {
+    void reservar() {
+      instante.resize(kLinhasBloco);
+      leq.resize(kLinhasBloco);
+      lmax.resize(kLinhasBloco);
+      alertas.resize(kLinhasBloco);
+    }
+    uint32_t linhas = 0;
+    std::vector<int64_t> instante;
+    std::vector<uint16_t> leq, lmax, alertas;
+  };
+
+  static FILE *abrir_arquivo(const std::string &caminho, uint64_t *tamanho) {
+    FILE *f = std::fopen(caminho.c_str(), "ab");
+    if (f == nullptr) {
+      std::perror(caminho.c_str());
+      return nullptr;
+    }
+    std::setvbuf(f, nullptr, _IOFBF, 1 << 20);
+    std::fseek(f, 0, SEEK_END);
+    if (tamanho) *tamanho = std::ftell(f);
+    return f;
+  }
+
+  static void sincronizar(FILE *f) {
+    std::fflush(f);
+    fsync(fileno(f));
+  }
+
+  // Torna duráveis as colunas e os nomes das salas e só então anexa ao índice
+  // as entradas dos blocos gravados desde a última publicação
+  void publicar() {
+    if (indice_pendente_.empty()) return;
+    for (FILE *f : colunas_) sincronizar(f);
+    sincronizar(salas_);
+    std::fwrite(indice_pendente_.data(), sizeof(Bloco), indice_pendente_.size(),
+                indice_);
+    sincronizar(indice_);
+    indice_pendente_.clear();
+  }
+
+  void anexar(Bloco *bloco, int coluna) {
+    bloco->inicio[coluna] = posicao_[coluna];
+    bloco->tamanho[coluna] = buffer_.size();
+    std::fwrite(buffer_.data(), 1, buffer_.size(), colunas_[coluna]);
+    posicao_[coluna] += buffer_.size();
+    buffer_.clear();
+  }
+
+  void gravar(uint32_t sala, Pendente *p) {
+    Bloco bloco = {};
+    bloco.sala = sala;
+    bloco.linhas = p->linhas;
+    bloco.instante_min = *std::min_element(p->instante.begin(),
+                                           p->instante.begin() + p->linhas);
+    bloco.instante_max = *std::max_element(p->instante.begin(),
+                                           p->instante.begin() + p->linhas);
+    bloco.leq_min = UINT16_MAX;
+
+    // Instantes: deltas em corridas
+    escrever_varint(&buffer_, zigzag(p->instante[0] - bloco.instante_min));
+    for (uint32_t i = 1; i < p->linhas;) {
+      int64_t delta = p->instante[i] - p->instante[i - 1];
+      uint32_t repeticoes = 1;
+      while (i + repeticoes < p->linhas &&
+             p->instante[i + repeticoes] - p->instante[i + repeticoes - 1] ==
+                 delta) {
+        repeticoes++;
+      }
+      escrever_varint(&buffer_, zigzag(delta));
+      escrever_varint(&buffer_, repeticoes);
+      i += repeticoes;
+    }
+    anexar(&bloco, kInstante);
+
+    // Níveis: deltas do anterior, com o resumo do índice
+    for (uint32_t i = 0; i < p->linhas; i++) {
+      uint16_t leq = p->leq[i];
+      escrever_varint(&buffer_, i == 0 ? leq : zigzag(leq - p->leq[i - 1]));
+      bloco.leq_min = std::min(bloco.leq_min, leq);
+      bloco.leq_max = std::max(bloco.leq_max, leq);
+      bloco.energia += energia(leq);
+    }
+    anexar(&bloco, kLeq);
+    for (uint32_t i = 0; i < p->linhas; i++) {
+      uint16_t lmax = p->lmax[i];
+      escrever_varint(&buffer_, i == 0 ? lmax : zigzag(lmax - p->lmax[i - 1]));
+      bloco.lmax_max = std::max(bloco.lmax_max, lmax);
+    }
+    anexar(&bloco, kLmax);
+
+    // Alertas: quase sempre zero, em corridas
+    for (uint32_t i = 0; i < p->linhas;) {
+      uint32_t repeticoes = 1;
+      while (i + repeticoes < p->linhas &&
+             p->alertas[i + repeticoes] == p->alertas[i]) {
+        repeticoes++;
+      }
+      escrever_varint(&buffer_, p->alertas[i]);
+      escrever_varint(&buffer_, repeticoes);
+      bloco.alertas += p->alertas[i] * repeticoes;
+      i += repeticoes;
+    }
+    anexar(&bloco, kAlertas);
+
+    indice_pendente_.push_back(bloco);
+    linhas_ += p->linhas;
+    blocos_++;
+    p->linhas = 0;
+    if (indice_pendente_.size() == kBlocosPublicacao) publicar();
+  }
+
+  FILE *colunas_[kColunas] = {};
+  FILE *indice_ = nullptr;
+  FILE *salas_ = nullptr;
+  uint64_t posicao_[kColunas] = {};
+  uint64_t linhas_ = 0;
+  uint64_t blocos_ = 0;
+  std::vector<Pendente> pendentes_;
+  std::vector<std::string> nomes_;
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::vector<uint8_t> buffer_;
+  std::vector<Bloco> indice_pendente_;
+};
+
+// Consulta de um intervalo [inicio, fim), opcionalmente só numa faixa do dia
+// (hora local = UTC + fuso_s). A faixa pode cruzar a meia-noite: 22 h às 7 h
+// é janela_inicio = 22 * 3600, janela_fim = 7 * 3600
+struct Consulta {
+  int64_t inicio = INT64_MIN;
+  int64_t fim = INT64_MAX;
+  uint32_t sala = kTodas;
+  bool janela = false;
+  uint32_t janela_inicio = 0;  // Segundos do dia
+  uint32_t janela_fim = 0;
+  int32_t fuso_s = 0;
+  uint16_t limiar_ddb = UINT16_MAX;  // Conta os segundos com Leq >= limiar
+};
+
+// Resultado de uma sala
+struct Resultado {
+  uint64_t segundos = 0;
+  double energia = 0;
+  uint16_t lmax_ddb = 0;
+  uint64_t alertas = 0;
+  uint64_t acima = 0;  // Segundos com Leq >= limiar
+
+  double leq_db() const {
+    return segundos ? 10.0 * std::log10(energia / segundos) : 0.0;
+  }
+};
+
+// O que a consulta precisou tocar
+struct Custo {
+  uint64_t blocos_indice = 0;     // Respondidos só pelo índice
+  uint64_t blocos_lidos = 0;      // Descomprimidos
+  uint64_t blocos_ignorados = 0;  // Vistos no índice e descartados
+  uint64_t bytes_lidos = 0;
+};
+
+// Leitura por mapeamento dos arquivos na memória
+class Leitor {
+ public:
+  ~Leitor() {
+    for (auto &m : colunas_) desmapear(&m);
+    desmapear(&indice_);
+  }
+
+  bool abrir(const std::string &base) {
+    for (int c = 0; c < kColunas; c++) {
+      if (!mapear(base + "/" + kArquivos[c], &colunas_[c])) return false;
+    }
+    if (!mapear(base + "/blocos.idx", &indice_)) return false;
+    Cabecalho cabecalho;
+    if (indice_.tamanho < sizeof(cabecalho)) {
+      std::fprintf(stderr, "%s: indice vazio\n", base.c_str());
+      return false;
+    }
+    std::memcpy(&cabecalho, indice_.dados, sizeof(cabecalho));
+    if (cabecalho.magica != kMagica || cabecalho.versao != kVersao ||
+        cabecalho.tamanho_bloco != sizeof(Bloco)) {
+      std::fprintf(stderr, "%s: indice de outro formato\n", base.c_str());
+      return false;
+    }
+    blocos_ = reinterpret_cast<const Bloco *>(indice_.dados + sizeof(cabecalho));
+    quantidade_ = (indice_.tamanho - sizeof(cabecalho)) / sizeof(Bloco);
+    nomes_ = ler_salas(base);
+
+    // Blocos de cada sala em ordem de início, com o maior fim acumulado
+    // para achar por busca binária o primeiro que alcança a consulta
+    por_sala_.assign(nomes_.size(), {});
+    for (uint32_t i = 0; i < quantidade_; i++) {
+      if (blocos_[i].sala >= por_sala_.size()) {
+        por_sala_.resize(blocos_[i].sala + 1);
+      }
+      por_sala_[blocos_[i].sala].push_back(i);
+      linhas_ += blocos_[i].linhas;
+    }
+    fim_acumulado_.resize(por_sala_.size());
+    for (size_t s = 0; s < por_sala_.size(); s++) {
+      auto &lista = por_sala_[s];
+      std::stable_sort(lista.begin(), lista.end(), [&](uint32_t a, uint32_t b) {
+        return blocos_[a].instante_min < blocos_[b].instante_min;
+      });
+      int64_t maior = INT64_MIN;
+      for (uint32_t i : lista) {
+        maior = std::max(maior, blocos_[i].instante_max);
+        fim_acumulado_[s].push_back(maior);
+      }
+    }
+    return true;
+  }
+
+  size_t salas() const { return por_sala_.size(); }
+  size_t blocos() const { return quantidade_; }
+  uint64_t linhas() const { return linhas_; }
+
+  std::string nome(uint32_t sala) const {
+    return sala < nomes_.size() ? nomes_[sala] : std::to_string(sala);
+  }
+
+  bool buscar_sala(const std::string &nome, uint32_t *sala) const {
+    auto it = std::find(nomes_.begin(), nomes_.end(), nome);
+    if (it == nomes_.end()) return false;
+    *sala = it - nomes_.begin();
+    return true;
+  }
+
+  // Um Resultado por sala (índice = número da sala)
+  std::vector<Resultado> consultar(const Consulta &c,
+                                   Custo *custo = nullptr) const {
+    std::vector<Resultado> resultados(salas());
+    Custo local;
+    if (custo == nullptr) custo = &local;
+    std::vector<int64_t> instantes(kLinhasBloco);
+    std::vector<uint16_t> leq(kLinhasBloco), lmax(kLinhasBloco),
+        alertas(kLinhasBloco);
+
+    uint32_t primeira = c.sala == kTodas ? 0 : c.sala;
+    uint32_t ultima = c.sala == kTodas ? salas() : c.sala + 1;
+    uint32_t largura = (c.janela_fim + kDia - c.janela_inicio) % kDia;
+    for (uint32_t s = primeira; s < ultima && s < salas(); s++) {
+      Resultado &r = resultados[s];
+      const auto &lista = por_sala_[s];
+      size_t i = std::lower_bound(fim_acumulado_[s].begin(),
+                                  fim_acumulado_[s].end(), c.inicio) -
+                 fim_acumulado_[s].begin();
+      for (; i < lista.size() && blocos_[lista[i]].instante_min < c.fim; i++) {
+        const Bloco &b = blocos_[lista[i]];
+        if (b.instante_max < c.inicio) {
+          custo->blocos_ignorados++;
+          continue;
+        }
+        bool coberto = b.instante_min >= c.inicio && b.instante_max < c.fim;
+        if (c.janela) {
+          uint32_t posicao = deslocar(b.instante_min, c);
+          int64_t duracao = b.instante_max - b.instante_min;
+          if (posicao >= largura && posicao + duracao < kDia) {
+            custo->blocos_ignorados++;  // Inteiro fora da faixa do dia
+            continue;
+          }
+          coberto = coberto && posicao + duracao < largura;
+        }
+        bool limiar_resolvido =
+            c.limiar_ddb <= b.leq_min || c.limiar_ddb > b.leq_max;
+        if (coberto && limiar_resolvido) {
+          r.segundos += b.linhas;
+          r.energia += b.energia;
+          r.lmax_ddb = std::max(r.lmax_ddb, b.lmax_max);
+          r.alertas += b.alertas;
+          if (c.limiar_ddb <= b.leq_min) r.acima += b.linhas;
+          custo->blocos_indice++;
+          continue;
+        }
+
+        // Parcial: só as colunas que podem mudar o resultado
+        custo->blocos_lidos++;
+        bool ler_lmax = b.lmax_max > r.lmax_ddb;
+        bool ler_alertas = b.alertas > 0;
+        if (!decodificar_instantes(coluna(kInstante, b), fim_coluna(kInstante, b),
+                                   b.linhas, b.instante_min,
+                                   instantes.data()) ||
+            !decodificar_niveis(coluna(kLeq, b), fim_coluna(kLeq, b), b.linhas,
+                                leq.data()) ||
+            (ler_lmax && !decodificar_niveis(coluna(kLmax, b),
+                                             fim_coluna(kLmax, b), b.linhas,
+                                             lmax.data())) ||
+            (ler_alertas && !decodificar_alertas(coluna(kAlertas, b),
+                                                 fim_coluna(kAlertas, b),
+                                                 b.linhas, alertas.data()))) {
+          std::fprintf(stderr, "bloco %u corrompido\n", lista[i]);
+          continue;
+        }
+        custo->bytes_lidos += b.tamanho[kInstante] + b.tamanho[kLeq] +
+                              (ler_lmax ? b.tamanho[kLmax] : 0) +
+                              (ler_alertas ? b.tamanho[kAlertas] : 0);
+        for (uint32_t k = 0; k < b.linhas; k++) {
+          int64_t t = instantes[k];
+          if (t < c.inicio || t >= c.fim) continue;
+          if (c.janela && deslocar(t, c) >= largura) continue;
+          r.segundos++;
+          r.energia += energia(leq[k]);
+          r.acima += leq[k] >= c.limiar_ddb;
+          if (ler_lmax) r.lmax_ddb = std::max(r.lmax_ddb, lmax[k]);
+          if (ler_alertas) r.alertas += alertas[k];
+        }
+      }
+    }
+    return resultados;
+  }
+
+ private:
+  struct Mapa {
+    const uint8_t *dados = nullptr;
+    size_t tamanho = 0;
+  };
+
+  static bool mapear(const std::string &caminho, Mapa *mapa) {
+    int fd = open(caminho.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) < 0) {
+      std::perror(caminho.c_str());
+      if (fd >= 0) close(fd);
+      return false;
+    }
+    mapa->tamanho = info.st_size;
+    if (mapa->tamanho) {
+      void *p = mmap(nullptr, mapa->tamanho, PROT_READ, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED) {
+        std::perror(caminho.c_str());
+        close(fd);
+        return false;
+      }
+      mapa->dados = static_cast<const uint8_t *>(p);
+    }
+    close(fd);
+    return true;
+  }
+
+  static void desmapear(Mapa *mapa) {
+    if (mapa->dados) munmap(const_cast<uint8_t *>(mapa->dados), mapa->tamanho);
+    mapa->dados = nullptr;
+  }
+
+  // Segundos desde o início da faixa do dia (hora local)
+  static uint32_t deslocar(int64_t instante, const Consulta &c) {
+    int64_t segundo = (instante + c.fuso_s - c.janela_inicio) % kDia;
+    return segundo < 0 ? segundo + kDia : segundo;
+  }
+
+  const uint8_t *coluna(int c, const Bloco &b) const {
+    return colunas_[c].dados + b.inicio[c];
+  }
+
+  // Fim do bloco na coluna, limitado ao arquivo (índice corrompido)
+  const uint8_t *fim_coluna(int c, const Bloco &b) const {
+    uint64_t fim = std::min<uint64_t>(b.inicio[c] + b.tamanho[c],
+                                      colunas_[c].tamanho);
+    return colunas_[c].dados + std::max<uint64_t>(fim, b.inicio[c]);
+  }
+
+  Mapa colunas_[kColunas];
+  Mapa indice_;
+  const Bloco *blocos_ = nullptr;
+  size_t quantidade_ = 0;
+  uint64_t linhas_ = 0;
+  std::vector<std::string> nomes_;
+  std::vector<std::vector<uint32_t>> por_sala_;
+  std::vector<std::vector<int64_t>> fim_acumulado_;
+};
+
+}  // namespace historico
+
+#endif
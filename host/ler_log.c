@@ -0,0 +1,82 @@
+// ==========================================================================
+// Decodificador do log de medições gravado na flash.
+// Uso: ler_log log.bin > log.csv
+//
+// log.bin é a cópia da região do log (FLASH_LOG_OFFSET, 512 KiB), por
+// exemplo com:
+//   picotool save -r 0x1017F000 0x101FF000 log.bin
+// Os blocos válidos (assinatura e CRC conferidos) são ordenados pela
+// sequência e impressos em CSV: sessao,minuto,leq_db,lmax_db,alertas. Blocos
+// corrompidos são ignorados e contados na saída de erro.
+// ==========================================================================
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "codec_medicoes.h"
+
+typedef struct {
+  uint32_t sequencia;
+  long posicao;
+} bloco_t;
+
+static int comparar(const void *a, const void *b) {
+  uint32_t sa = ((const bloco_t *)a)->sequencia;
+  uint32_t sb = ((const bloco_t *)b)->sequencia;
+  return (sa > sb) - (sa < sb);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "uso: %s log.bin\n", argv[0]);
+    return 1;
+  }
+  FILE *f = fopen(argv[1], "rb");
+  if (!f) {
+    perror(argv[1]);
+    return 1;
+  }
+  fseek(f, 0, SEEK_END);
+  long tamanho = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t *imagem = malloc(tamanho);
+  if (fread(imagem, 1, tamanho, f) != (size_t)tamanho) {
+    perror(argv[1]);
+    return 1;
+  }
+  fclose(f);
+
+  long total = tamanho / CODEC_BLOCO_TAMANHO;
+  bloco_t *blocos = malloc(total * sizeof(bloco_t));
+  int validos = 0, invalidos = 0;
+  for (long i = 0; i < total; i++) {
+    const uint8_t *bloco = imagem + i * CODEC_BLOCO_TAMANHO;
+    codec_cabecalho_t cabecalho;
+    if (codec_ler_cabecalho(bloco, &cabecalho)) {
+      blocos[validos++] = (bloco_t){cabecalho.sequencia, i};
+    } else if (bloco[0] != 0xFF) {
+      invalidos++;  // Não apagado e não válido
+    }
+  }
+  qsort(blocos, validos, sizeof(bloco_t), comparar);
+
+  printf("sessao,minuto,leq_db,lmax_db,alertas\n");
+  long registros = 0;
+  for (int b = 0; b < validos; b++) {
+    medicao_t medicoes[CODEC_REGISTROS_MAX];
+    int n = codec_decodificar(
+        imagem + blocos[b].posicao * CODEC_BLOCO_TAMANHO, medicoes,
+        CODEC_REGISTROS_MAX);
+    for (int i = 0; i < n; i++) {
+      printf("%u,%lu,%.1f,%.1f,%u\n", medicoes[i].sessao,
+             (unsigned long)medicoes[i].minuto, medicoes[i].leq_ddb / 10.0,
+             medicoes[i].lmax_ddb / 10.0, medicoes[i].alertas);
+    }
+    registros += n;
+  }
+  fprintf(stderr, "%d blocos validos, %d invalidos, %ld registros\n", validos,
+          invalidos, registros);
+
+  free(blocos);
+  free(imagem);
+  return 0;
+}
@@ -0,0 +1,174 @@
+// ==========================================================================
+// Receptor da telemetria UDP do medidor (inc/telemetria_protocolo.h).
+// Uso: receptor_telemetria [porta] [--csv]
+//
+// Escuta a porta (padrão TELEMETRIA_PORTA_PADRAO) em todas as interfaces e
+// confere cada datagrama: assinatura, versão e tamanho. Por dispositivo,
+// acompanha a sequência dos datagramas (lacunas = perdidos na rede) e os
+// registros descartados pelo medidor sem rede. Sem --csv mostra um resumo por
+// datagrama; com --csv imprime um registro por linha:
+//   dispositivo,sessao,segundo,leq_db,lmax_db,alertas,instante
+// instante é a hora UNIX estimada do registro, como o `historico importar`
+// espera: o segundo do medidor somado ao deslocamento da âncora do
+// dispositivo (ver ancorar), então o acumulado reenviado depois de uma queda
+// da rede mantém a hora em que foi medido
+// ==========================================================================
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "telemetria_protocolo.h"
+
+#define DISPOSITIVOS_MAX 256
+#define ANCORA_FOLGA_S 2  // Atraso aceito ao mover a âncora (deriva, rede)
+
+typedef struct {
+  uint64_t dispositivo;
+  uint16_t sessao;
+  uint32_t proxima_sequencia;
+  uint64_t datagramas;
+  uint64_t registros;
+  uint64_t perdidos;  // Datagramas que faltaram na sequência
+  int ancorado;
+  uint32_t ancora_segundo;  // Registro mais novo já visto na sessão
+  int64_t deslocamento;     // Hora UNIX menos segundo do medidor
+} dispositivo_t;
+
+static dispositivo_t dispositivos[DISPOSITIVOS_MAX];
+static int num_dispositivos = 0;
+
+// Estado do dispositivo; um novo boot (sessão diferente) recomeça a sequência
+static dispositivo_t *buscar(uint64_t id, uint16_t sessao) {
+  for (int i = 0; i < num_dispositivos; i++) {
+    if (dispositivos[i].dispositivo != id) continue;
+    if (dispositivos[i].sessao != sessao) {
+      dispositivos[i].sessao = sessao;
+      dispositivos[i].proxima_sequencia = 0;
+      dispositivos[i].ancorado = 0;
+    }
+    return &dispositivos[i];
+  }
+  if (num_dispositivos == DISPOSITIVOS_MAX) return NULL;
+  dispositivo_t *d = &dispositivos[num_dispositivos++];
+  memset(d, 0, sizeof(*d));
+  d->dispositivo = id;
+  d->sessao = sessao;
+  return d;
+}
+
+// Atualiza a âncora com o registro mais novo de um datagrama e retorna o
+// deslocamento a somar ao segundo de cada registro. Um registro mais novo que
+// a âncora só a move se chegou no horário que ela prevê, com folga de
+// ANCORA_FOLGA_S; um datagrama atrasado (o acumulado reenviado depois de uma
+// queda da rede) é datado pela âncora anterior. Um datagrama adiantado em
+// relação à previsão mostra que a âncora veio atrasada e a substitui
+static int64_t ancorar(dispositivo_t *d, uint32_t segundo, time_t chegada) {
+  int64_t deslocamento = (int64_t)chegada - segundo;
+  if (!d->ancorado || deslocamento < d->deslocamento ||
+      (segundo > d->ancora_segundo &&
+       deslocamento <= d->deslocamento + ANCORA_FOLGA_S)) {
+    d->deslocamento = deslocamento;
+  }
+  if (!d->ancorado || segundo > d->ancora_segundo) d->ancora_segundo = segundo;
+  d->ancorado = 1;
+  return d->deslocamento;
+}
+
+int main(int argc, char **argv) {
+  int porta = TELEMETRIA_PORTA_PADRAO;
+  int csv = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--csv") == 0) {
+      csv = 1;
+    } else {
+      porta = atoi(argv[i]);
+    }
+  }
+
+  int s = socket(AF_INET, SOCK_DGRAM, 0);
+  struct sockaddr_in endereco = {.sin_family = AF_INET,
+                                 .sin_port = htons(porta),
+                                 .sin_addr.s_addr = htonl(INADDR_ANY)};
+  if (s < 0 || bind(s, (struct sockaddr *)&endereco, sizeof(endereco)) < 0) {
+    perror("socket");
+    return 1;
+  }
+  fprintf(stderr, "escutando UDP %d\n", porta);
+  if (csv) printf("dispositivo,sessao,segundo,leq_db,lmax_db,alertas,instante\n");
+
+  uint8_t datagrama[2048];
+  uint64_t invalidos = 0;
+  for (;;) {
+    struct sockaddr_in origem;
+    socklen_t tamanho_origem = sizeof(origem);
+    ssize_t n = recvfrom(s, datagrama, sizeof(datagrama), 0,
+                         (struct sockaddr *)&origem, &tamanho_origem);
+    if (n < 0) {
+      perror("recvfrom");
+      return 1;
+    }
+
+    telemetria_cabecalho_t cabecalho;
+    if ((size_t)n < sizeof(cabecalho)) {
+      invalidos++;
+      continue;
+    }
+    memcpy(&cabecalho, datagrama, sizeof(cabecalho));
+    if (cabecalho.magica != TELEMETRIA_MAGICA ||
+        cabecalho.versao != TELEMETRIA_VERSAO ||
+        (size_t)n != sizeof(cabecalho) + cabecalho.quantidade *
+                                             sizeof(telemetria_registro_t)) {
+      invalidos++;
+      fprintf(stderr, "datagrama invalido de %s (%ld invalidos)\n",
+              inet_ntoa(origem.sin_addr), (long)invalidos);
+      continue;
+    }
+
+    dispositivo_t *d = buscar(cabecalho.dispositivo, cabecalho.sessao);
+    if (d == NULL) continue;
+    if (cabecalho.sequencia > d->proxima_sequencia) {
+      d->perdidos += cabecalho.sequencia - d->proxima_sequencia;
+    }
+    d->proxima_sequencia = cabecalho.sequencia + 1;
+    d->datagramas++;
+    d->registros += cabecalho.quantidade;
+
+    const uint8_t *p = datagrama + sizeof(cabecalho);
+    telemetria_registro_t registro = {0};
+    int64_t deslocamento = 0;
+    if (cabecalho.quantidade > 0) {
+      telemetria_registro_t ultimo;
+      memcpy(&ultimo, p + (cabecalho.quantidade - 1) * sizeof(ultimo),
+             sizeof(ultimo));
+      deslocamento = ancorar(d, ultimo.segundo, time(NULL));
+    }
+    for (int i = 0; i < cabecalho.quantidade; i++) {
+      memcpy(&registro, p + i * sizeof(registro), sizeof(registro));
+      if (csv) {
+        printf("%016llx,%u,%lu,%.1f,%.1f,%u,%lld\n",
+               (unsigned long long)cabecalho.dispositivo, cabecalho.sessao,
+               (unsigned long)registro.segundo, registro.leq_ddb / 10.0,
+               registro.lmax_ddb / 10.0, registro.alertas,
+               (long long)(registro.segundo + deslocamento));
+      }
+    }
+    if (csv) {
+      fflush(stdout);
+    } else {
+      printf("%016llx %s sessao %u seq %lu: %u registros, ultimo %lu s "
+             "Leq %.1f dB | perdidos %llu, descartados %lu\n",
+             (unsigned long long)cabecalho.dispositivo,
+             inet_ntoa(origem.sin_addr), cabecalho.sessao,
+             (unsigned long)cabecalho.sequencia, cabecalho.quantidade,
+             (unsigned long)registro.segundo, registro.leq_ddb / 10.0,
+             (unsigned long long)d->perdidos,
+             (unsigned long)cabecalho.descartados);
+      fflush(stdout);
+    }
+  }
+}
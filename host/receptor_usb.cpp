@@ -0,0 +1,245 @@
+// ==========================================================================
+// Receptor do fluxo binário USB CDC do medidor (inc/usb_protocolo.h).
+// Uso: receptor_usb <dispositivo|arquivo> [--audio] [segundos]
+//
+// Lê os pacotes da porta serial (ex.: /dev/ttyACM0) ou de uma gravação do
+// fluxo, confere o sincronismo e a continuidade da sequência e, a cada
+// segundo, mostra a vazão, a taxa de amostras de áudio recebidas, o último
+// nível e os pacotes perdidos (lacunas na sequência). O estado do medidor
+// (enviado a cada conexão) e cada alerta encerrado são mostrados assim que
+// chegam. Com --audio pede ao dispositivo os blocos de
+// áudio bruto.
+// ==========================================================================
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "usb_protocolo.h"
+}
+
+namespace {
+
+using Relogio = std::chrono::steady_clock;
+
+constexpr size_t kCargaMaxima = 4096;  // Maior carga aceita antes de ressinc.
+
+struct Contadores {
+  uint64_t bytes = 0;
+  uint64_t pacotes = 0;
+  uint64_t amostras = 0;
+  uint64_t perdidos = 0;      // Soma das lacunas de sequência
+  uint64_t ressincronias = 0; // Bytes descartados procurando o sincronismo
+  uint64_t reinicios = 0;     // Sequência voltou (nova conexão)
+};
+
+class Receptor {
+ public:
+  // Consome bytes recebidos e processa todos os pacotes completos
+  void alimentar(const uint8_t *dados, size_t n) {
+    buffer_.insert(buffer_.end(), dados, dados + n);
+    total_.bytes += n;
+    periodo_.bytes += n;
+
+    size_t pos = 0;
+    while (buffer_.size() - pos >= sizeof(usb_pacote_t)) {
+      usb_pacote_t cabecalho;
+      std::memcpy(&cabecalho, buffer_.data() + pos, sizeof(cabecalho));
+      if (cabecalho.sincronismo != USB_PACOTE_SINCRONISMO ||
+          cabecalho.tamanho > kCargaMaxima ||
+          (cabecalho.tipo != USB_PACOTE_NIVEL &&
+           cabecalho.tipo != USB_PACOTE_AUDIO &&
+           cabecalho.tipo != USB_PACOTE_EVENTO &&
+           cabecalho.tipo != USB_PACOTE_ESTADO)) {
+        pos++;
+        total_.ressincronias++;
+        continue;
+      }
+      size_t completo = sizeof(cabecalho) + cabecalho.tamanho;
+      if (buffer_.size() - pos < completo) break;
+
+      processar(cabecalho, buffer_.data() + pos + sizeof(cabecalho));
+      pos += completo;
+    }
+    buffer_.erase(buffer_.begin(), buffer_.begin() + pos);
+  }
+
+  // Mostra e zera os contadores do período
+  void relatar(double segundos) {
+    std::printf(
+        "%7.1f KiB/s  %6.0f amostras/s  nivel %5.1f dB  perdidos %llu "
+        "(total %llu)\n",
+        periodo_.bytes / 1024.0 / segundos, periodo_.amostras / segundos,
+        ultimo_db_, (unsigned long long)periodo_.perdidos,
+        (unsigned long long)total_.perdidos);
+    periodo_ = Contadores{};
+  }
+
+  void resumo(double segundos) const {
+    std::printf(
+        "\n%llu pacotes, %.1f KiB em %.1f s (%.1f KiB/s), %llu amostras de "
+        "audio\n",
+        (unsigned long long)total_.pacotes, total_.bytes / 1024.0, segundos,
+        total_.bytes / 1024.0 / segundos, (unsigned long long)total_.amostras);
+    std::printf(
+        "Perdidos: %llu (%.3f%%), ressincronias: %llu bytes, reinicios da "
+        "sequencia: %llu\n",
+        (unsigned long long)total_.perdidos,
+        100.0 * total_.perdidos /
+            (total_.pacotes + total_.perdidos ? total_.pacotes + total_.perdidos
+                                              : 1),
+        (unsigned long long)total_.ressincronias,
+        (unsigned long long)total_.reinicios);
+  }
+
+  uint64_t perdidos() const { return total_.perdidos; }
+
+ private:
+  void processar(const usb_pacote_t &cabecalho, const uint8_t *carga) {
+    if (tem_sequencia_) {
+      uint32_t esperada = proxima_sequencia_;
+      if (cabecalho.sequencia > esperada) {
+        total_.perdidos += cabecalho.sequencia - esperada;
+        periodo_.perdidos += cabecalho.sequencia - esperada;
+      } else if (cabecalho.sequencia < esperada) {
+        total_.reinicios++;
+      }
+    }
+    tem_sequencia_ = true;
+    proxima_sequencia_ = cabecalho.sequencia + 1;
+    total_.pacotes++;
+
+    if (cabecalho.tipo == USB_PACOTE_NIVEL &&
+        cabecalho.tamanho == sizeof(float)) {
+      std::memcpy(&ultimo_db_, carga, sizeof(float));
+    } else if (cabecalho.tipo == USB_PACOTE_AUDIO) {
+      uint64_t n = cabecalho.tamanho / sizeof(uint16_t);
+      total_.amostras += n;
+      periodo_.amostras += n;
+    } else if (cabecalho.tipo == USB_PACOTE_EVENTO &&
+               cabecalho.tamanho == sizeof(usb_evento_t)) {
+      usb_evento_t evento;
+      std::memcpy(&evento, carga, sizeof(evento));
+      std::printf("Alerta %.*s: %.1f s a partir de %.1f s, pico %.1f dB, "
+                  "exposicao %.1f dB\n",
+                  (int)sizeof(evento.regra), evento.regra,
+                  evento.duracao_ms / 1000.0, evento.inicio_ms / 1000.0,
+                  evento.pico_db, evento.exposicao_db);
+    } else if (cabecalho.tipo == USB_PACOTE_ESTADO &&
+               cabecalho.tamanho == sizeof(usb_estado_t)) {
+      usb_estado_t estado;
+      std::memcpy(&estado, carga, sizeof(estado));
+      std::printf("ADC: %.1f Hz nominal, %.1f Hz medido, janela de %u "
+                  "amostras, sobreamostragem %ux\n",
+                  estado.taxa_nominal_hz, estado.taxa_medida_hz,
+                  estado.amostras_janela, estado.sobreamostragem);
+      if (std::isnan(estado.piso_ruido_db)) {
+        std::printf("Piso de ruido nao caracterizado\n");
+      } else {
+        std::printf("Piso de ruido: %.1f dB, offset DC %.2f contagens\n",
+                    estado.piso_ruido_db, estado.offset_dc);
+      }
+      std::printf("Log: sessao %u, %u registros na flash\n",
+                  estado.sessao_log, estado.registros_log);
+      if (estado.display_presente) {
+        std::printf("I2C: %u kHz (estavel ate %u kHz), %.1f quadros/s\n",
+                    estado.i2c_khz, estado.i2c_max_khz, estado.display_fps);
+      } else {
+        std::printf("Display nao responde: medindo sem display\n");
+      }
+    }
+  }
+
+  std::vector<uint8_t> buffer_;
+  Contadores total_, periodo_;
+  bool tem_sequencia_ = false;
+  uint32_t proxima_sequencia_ = 0;
+  float ultimo_db_ = 0.0f;
+};
+
+// Coloca a porta serial em modo bruto (sem eco nem tradução de bytes)
+bool configurar_serial(int fd) {
+  termios tio;
+  if (tcgetattr(fd, &tio) != 0) return false;
+  cfmakeraw(&tio);
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 1;  // Leituras voltam após 100 ms sem dados
+  return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "uso: %s <dispositivo|arquivo> [--audio] [segundos]\n",
+                 argv[0]);
+    return 1;
+  }
+  std::string caminho = argv[1];
+  bool audio = false;
+  double duracao = 0.0;  // 0: até o fim do arquivo ou Ctrl+C
+  for (int i = 2; i < argc; i++) {
+    if (std::strcmp(argv[i], "--audio") == 0) {
+      audio = true;
+    } else {
+      duracao = std::atof(argv[i]);
+    }
+  }
+
+  int fd = open(caminho.c_str(), O_RDWR | O_NOCTTY);
+  if (fd < 0) fd = open(caminho.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::perror(caminho.c_str());
+    return 1;
+  }
+  bool serial = isatty(fd) && configurar_serial(fd);
+  if (serial) {
+    tcflush(fd, TCIFLUSH);
+    uint8_t comando =
+        audio ? USB_COMANDO_AUDIO_LIGAR : USB_COMANDO_AUDIO_DESLIGAR;
+    if (write(fd, &comando, 1) != 1) std::perror("comando");
+  }
+
+  Receptor receptor;
+  auto inicio = Relogio::now();
+  auto ultimo_relato = inicio;
+  uint8_t dados[16384];
+  while (true) {
+    ssize_t n = read(fd, dados, sizeof(dados));
+    if (n < 0) {
+      std::perror("read");
+      break;
+    }
+    if (n == 0 && !serial) break;  // Fim da gravação
+    receptor.alimentar(dados, static_cast<size_t>(n));
+
+    auto agora = Relogio::now();
+    double periodo = std::chrono::duration<double>(agora - ultimo_relato).count();
+    if (periodo >= 1.0) {
+      receptor.relatar(periodo);
+      ultimo_relato = agora;
+    }
+    if (duracao > 0.0 &&
+        std::chrono::duration<double>(agora - inicio).count() >= duracao) {
+      break;
+    }
+  }
+
+  if (serial && audio) {
+    uint8_t comando = USB_COMANDO_AUDIO_DESLIGAR;
+    if (write(fd, &comando, 1) != 1) std::perror("comando");
+  }
+  close(fd);
+  receptor.resumo(
+      std::chrono::duration<double>(Relogio::now() - inicio).count());
+  return receptor.perdidos() != 0;
+}
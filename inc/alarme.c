@@ -0,0 +1,103 @@
+#include "alarme.h"
+
+#include <math.h>
+#include <string.h>
+
+void alarme_iniciar(alarme_t *alarme, float histerese_db,
+                    uint32_t duracao_min_ms, uint32_t retencao_ms,
+                    uint32_t janela_ms) {
+  memset(alarme, 0, sizeof(*alarme));
+  alarme->histerese_db = histerese_db;
+  alarme->duracao_min_ms = duracao_min_ms;
+  alarme->retencao_ms = retencao_ms;
+  alarme->janela_s = janela_ms / 1000.0f;
+}
+
+static void acumular(alarme_t *alarme, float db, uint32_t agora_ms) {
+  alarme->atual.fim_ms = agora_ms;
+  if (db > alarme->atual.pico_db) alarme->atual.pico_db = db;
+  alarme->atual.energia += powf(10.0f, db / 10.0f) * alarme->janela_s;
+}
+
+static alarme_transicao_t disparar(alarme_t *alarme) {
+  alarme->estado = ALARME_ATIVO;
+  alarme->eventos++;
+  return ALARME_DISPAROU;
+}
+
+static alarme_transicao_t encerrar(alarme_t *alarme) {
+  alarme->ultimo = alarme->atual;
+  alarme->estado = ALARME_INATIVO;
+  return ALARME_ENCERROU;
+}
+
+// Avalia uma leitura contra o limite de disparo atual. O limite pode mudar a
+// qualquer leitura (ajuste pelos botões); a liberação acompanha o limite
+alarme_transicao_t alarme_avaliar(alarme_t *alarme, float db, float limite_db,
+                                  uint32_t agora_ms) {
+  bool acima = db > limite_db;
+  bool liberado = db < limite_db - alarme->histerese_db;
+
+  switch (alarme->estado) {
+    case ALARME_INATIVO:
+      if (!acima) break;
+      memset(&alarme->atual, 0, sizeof(alarme->atual));
+      alarme->atual.inicio_ms = agora_ms;
+      alarme->desde_ms = agora_ms;
+      alarme->estado = ALARME_PENDENTE;
+      acumular(alarme, db, agora_ms);
+      if (alarme->duracao_min_ms == 0) return disparar(alarme);
+      break;
+    case ALARME_PENDENTE:
+      if (!acima) {
+        alarme->estado = ALARME_INATIVO;  // Pico curto demais
+        break;
+      }
+      acumular(alarme, db, agora_ms);
+      if (agora_ms - alarme->desde_ms >= alarme->duracao_min_ms) {
+        return disparar(alarme);
+      }
+      break;
+    case ALARME_ATIVO:
+      if (liberado) {
+        alarme->estado = ALARME_RETENDO;
+        alarme->desde_ms = agora_ms;
+      } else {
+        acumular(alarme, db, agora_ms);
+      }
+      break;
+    case ALARME_RETENDO:
+      if (!liberado) {
+        alarme->estado = ALARME_ATIVO;
+        acumular(alarme, db, agora_ms);
+      } else if (agora_ms - alarme->desde_ms >= alarme->retencao_ms) {
+        return encerrar(alarme);
+      }
+      break;
+  }
+  return ALARME_NENHUMA;
+}
+
+// Encerra na hora o evento em andamento (saída dos modos de monitoramento).
+// Um evento ainda pendente é descartado
+alarme_transicao_t alarme_cancelar(alarme_t *alarme) {
+  if (alarme->estado == ALARME_ATIVO || alarme->estado == ALARME_RETENDO) {
+    return encerrar(alarme);
+  }
+  alarme->estado = ALARME_INATIVO;
+  return ALARME_NENHUMA;
+}
+
+// Buzzer e aviso na tela: ligados do disparo até o fim da retenção
+bool alarme_ativo(const alarme_t *alarme) {
+  return alarme->estado == ALARME_ATIVO || alarme->estado == ALARME_RETENDO;
+}
+
+// Nível de exposição sonora do evento (dB re 1 s)
+float alarme_exposicao_db(const alarme_evento_t *evento) {
+  return evento->energia > 0.0 ? 10.0f * log10f((float)evento->energia) : 0.0f;
+}
+
+uint32_t alarme_duracao_ms(const alarme_evento_t *evento) {
+  return evento->fim_ms - evento->inicio_ms;
+}
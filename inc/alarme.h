@@ -0,0 +1,63 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef alarme_inc_h
+#define alarme_inc_h
+
+// Máquina de estados do alarme de ruído, avaliada uma vez por leitura em
+// tempo constante. Limites separados de disparo (limite) e de liberação
+// (limite - histerese) evitam que o ruído em torno do limite faça o buzzer
+// trepidar, e dois tempos filtram os eventos:
+//   INATIVO   --acima do limite-->                  PENDENTE
+//   PENDENTE  --abaixo do limite-->                 INATIVO (descartado)
+//   PENDENTE  --acima por duracao_min_ms-->         ATIVO (evento disparado)
+//   ATIVO     --abaixo da liberação-->              RETENDO
+//   RETENDO   --acima da liberação-->               ATIVO (mesmo evento)
+//   RETENDO   --abaixo por retencao_ms-->           INATIVO (evento encerrado)
+// Um evento guarda início, fim (última leitura acima da liberação), pico e a
+// energia das leituras acima da liberação
+
+typedef enum {
+  ALARME_INATIVO,
+  ALARME_PENDENTE,
+  ALARME_ATIVO,
+  ALARME_RETENDO
+} alarme_estado_t;
+
+// O que a leitura mudou
+typedef enum {
+  ALARME_NENHUMA,
+  ALARME_DISPAROU,  // Novo evento (PENDENTE -> ATIVO)
+  ALARME_ENCERROU   // Evento concluído em `ultimo`
+} alarme_transicao_t;
+
+typedef struct {
+  uint32_t inicio_ms;  // Primeira leitura acima do limite
+  uint32_t fim_ms;     // Última leitura acima da liberação
+  float pico_db;
+  double energia;      // Soma de 10^(dB/10) * duração da leitura (s)
+} alarme_evento_t;
+
+typedef struct {
+  float histerese_db;
+  uint32_t duracao_min_ms;
+  uint32_t retencao_ms;
+  float janela_s;           // Duração de cada leitura
+  alarme_estado_t estado;
+  uint32_t desde_ms;        // Início do estado PENDENTE ou RETENDO
+  alarme_evento_t atual;    // Evento em andamento
+  alarme_evento_t ultimo;   // Último evento encerrado
+  uint32_t eventos;         // Eventos disparados
+} alarme_t;
+
+extern void alarme_iniciar(alarme_t *alarme, float histerese_db,
+                           uint32_t duracao_min_ms, uint32_t retencao_ms,
+                           uint32_t janela_ms);
+extern alarme_transicao_t alarme_avaliar(alarme_t *alarme, float db,
+                                         float limite_db, uint32_t agora_ms);
+extern alarme_transicao_t alarme_cancelar(alarme_t *alarme);
+extern bool alarme_ativo(const alarme_t *alarme);
+extern float alarme_exposicao_db(const alarme_evento_t *evento);
+extern uint32_t alarme_duracao_ms(const alarme_evento_t *evento);
+
+#endif
@@ -0,0 +1,322 @@
+#include "aquisicao.h"
+
+#include <string.h>
+
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+// Motor de aquisição: o ADC roda livre em round-robin sobre o canal de áudio e
+// os canais lentos (joystick etc.), e dois canais de DMA encadeados enchem
+// alternadamente dois buffers intercalados. Na interrupção de fim de DMA o
+// buffer concluído é separado: o áudio vai contíguo para um anel de blocos e
+// cada canal lento é decimado para uma média por bloco. O ADC nunca é
+// reconfigurado durante a aquisição, então o fluxo de áudio não tem buracos.
+// Com sobreamostragem, o áudio é convertido a um múltiplo da taxa pedida e
+// cada amostra do bloco é a soma de fator_sobreamostragem conversões: o ruído
+// próprio do ADC (alguns LSB) serve de dither e a soma ganha meio bit efetivo
+// a cada vez que o fator dobra.
+// A aquisição é iniciada no núcleo 1, e a interrupção de DMA e tudo o que ela
+// chama ficam na RAM: enquanto o núcleo 0 apaga ou grava a flash (XIP
+// suspensa), o núcleo 1 continua separando os buffers sem tocar na flash
+
+#define AQ_MAX_AMOSTRAS_BRUTAS (AQ_AMOSTRAS_BLOCO * AQ_MAX_CANAIS)
+
+static uint16_t buffer_bruto[2][AQ_MAX_AMOSTRAS_BRUTAS];
+static aq_bloco_t blocos[AQ_BLOCOS];
+static volatile uint32_t bloco_escrita = 0;  // Incrementado na interrupção
+static volatile uint32_t bloco_leitura = 0;  // Incrementado pelo consumidor
+static volatile uint32_t blocos_perdidos = 0;
+static uint32_t sequencia = 0;
+
+static uint32_t mascara_canais = 0;  // Entradas do ADC no round-robin
+static uint8_t num_canais = 0;
+static uint8_t ordem_canais[AQ_MAX_CANAIS];  // Entrada de cada posição
+static uint8_t entrada_audio;
+static volatile uint16_t valor_lento[AQ_MAX_CANAIS];
+
+static int canal_dma[2];
+static spin_lock_t *trava;  // Protege o estado compartilhado entre núcleos
+static uint nucleo_irq;  // Núcleo que atende a interrupção de DMA
+
+static uint8_t fator_sobreamostragem = 1;  // Conversões somadas por amostra
+static aq_bloco_t *bloco_atual = NULL;     // Bloco em preenchimento
+static uint32_t posicao_bloco = 0;         // Próxima amostra de bloco_atual
+static bool descartar_bloco = false;       // Anel cheio: bloco perdido
+
+static uint32_t taxa_pedida = AQ_TAXA_PADRAO_HZ;
+static float taxa_nominal = 0.0f;
+// Referência para medir a taxa efetiva: primeiro bloco após (re)configurar
+static volatile bool medir_reiniciar = true;
+static volatile uint32_t medir_sequencia_inicial = 0;
+static volatile uint64_t medir_instante_inicial = 0;
+static volatile uint32_t medir_sequencia = 0;
+static volatile uint64_t medir_instante = 0;
+
+// Instante atual (us) lido direto do temporizador: time_us_64 pode estar na
+// flash
+static __force_inline uint64_t aquisicao_agora_us(void) {
+  uint32_t alto, baixo;
+  do {
+    alto = timer_hw->timerawh;
+    baixo = timer_hw->timerawl;
+  } while (alto != timer_hw->timerawh);
+  return ((uint64_t)alto << 32) | baixo;
+}
+
+// Conclui o bloco em preenchimento e publica-o no anel
+static void __not_in_flash_func(aquisicao_concluir_bloco)(void) {
+  uint64_t agora = aquisicao_agora_us();
+  sequencia++;
+  if (medir_reiniciar) {
+    medir_sequencia_inicial = sequencia;
+    medir_instante_inicial = agora;
+    medir_reiniciar = false;
+  }
+  medir_sequencia = sequencia;
+  medir_instante = agora;
+
+  if (!descartar_bloco) {
+    bloco_atual->sequencia = sequencia;
+    bloco_atual->instante_us = agora;
+    bloco_escrita++;
+  }
+  bloco_atual = NULL;
+}
+
+// Separa um buffer intercalado: o áudio, somado em grupos de
+// fator_sobreamostragem conversões (AQ_AMOSTRAS_BLOCO é múltiplo do fator,
+// então um grupo nunca atravessa dois buffers), continua o bloco do anel em
+// preenchimento, e os canais lentos são reduzidos à média do buffer
+static void __not_in_flash_func(aquisicao_separar)(const uint16_t *bruto) {
+  uint32_t soma[AQ_MAX_CANAIS] = {0};
+  uint32_t acumulado = 0;
+  uint8_t somadas = 0;
+
+  int n = 0;
+  for (int i = 0; i < AQ_AMOSTRAS_BLOCO; i++) {
+    for (int c = 0; c < num_canais; c++) {
+      uint8_t entrada = ordem_canais[c];
+      uint16_t amostra = bruto[n++] & 0x0FFF;
+      if (entrada != entrada_audio) {
+        soma[entrada] += amostra;
+        continue;
+      }
+
+      acumulado += amostra;
+      if (++somadas < fator_sobreamostragem) continue;
+
+      if (bloco_atual == NULL) {
+        posicao_bloco = 0;
+        bloco_atual = &blocos[bloco_escrita % AQ_BLOCOS];
+        descartar_bloco = bloco_escrita - bloco_leitura >= AQ_BLOCOS;
+        if (descartar_bloco) blocos_perdidos++;
+      }
+      if (!descartar_bloco) {
+        bloco_atual->amostras[posicao_bloco] = (uint16_t)acumulado;
+      }
+      if (++posicao_bloco == AQ_AMOSTRAS_BLOCO) aquisicao_concluir_bloco();
+      acumulado = 0;
+      somadas = 0;
+    }
+  }
+
+  for (int c = 0; c < num_canais; c++) {
+    uint8_t entrada = ordem_canais[c];
+    if (entrada != entrada_audio) {
+      valor_lento[entrada] = soma[entrada] / AQ_AMOSTRAS_BLOCO;
+    }
+  }
+}
+
+// Fim de um dos buffers: rearma o canal de DMA concluído (o outro já está
+// rodando por encadeamento) e separa os dados
+static void __not_in_flash_func(aquisicao_irq_dma)(void) {
+  for (int i = 0; i < 2; i++) {
+    uint32_t mascara = 1u << canal_dma[i];
+    if (!(dma_hw->ints1 & mascara)) continue;
+
+    dma_hw->ints1 = mascara;
+    dma_hw->ch[canal_dma[i]].write_addr = (uintptr_t)buffer_bruto[i];
+    uint32_t estado = spin_lock_blocking(trava);
+    aquisicao_separar(buffer_bruto[i]);
+    spin_unlock(trava, estado);
+  }
+}
+
+// Inclui um canal lento (decimado para uma média por bloco) no round-robin.
+// Deve ser chamado antes de aquisicao_iniciar
+void aquisicao_adicionar_canal_lento(uint gpio) {
+  adc_gpio_init(gpio);
+  mascara_canais |= 1u << (gpio - 26);
+}
+
+// Configura o ADC e o DMA e inicia a aquisição contínua. taxa_hz é a taxa de
+// cada canal: o ADC converte a taxa_hz vezes o número de canais. A
+// interrupção de DMA é habilitada no núcleo que chama (o núcleo 1)
+void aquisicao_iniciar(uint gpio_audio, uint32_t taxa_hz) {
+  trava = spin_lock_init(spin_lock_claim_unused(true));
+  adc_init();
+  adc_gpio_init(gpio_audio);
+  entrada_audio = gpio_audio - 26;
+  mascara_canais |= 1u << entrada_audio;
+
+  // O round-robin percorre as entradas em ordem crescente a partir da
+  // primeira selecionada; começando pela menor, a ordem é fixa
+  num_canais = 0;
+  for (uint8_t entrada = 0; entrada < AQ_MAX_CANAIS; entrada++) {
+    if (mascara_canais & (1u << entrada)) ordem_canais[num_canais++] = entrada;
+  }
+  adc_select_input(ordem_canais[0]);
+  adc_set_round_robin(num_canais > 1 ? mascara_canais : 0);
+  adc_fifo_setup(true, true, 1, false, false);
+  aquisicao_definir_taxa(taxa_hz);
+
+  uint amostras_brutas = AQ_AMOSTRAS_BLOCO * num_canais;
+  canal_dma[0] = dma_claim_unused_channel(true);
+  canal_dma[1] = dma_claim_unused_channel(true);
+  for (int i = 0; i < 2; i++) {
+    dma_channel_config c = dma_channel_get_default_config(canal_dma[i]);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, DREQ_ADC);
+    channel_config_set_chain_to(&c, canal_dma[!i]);
+    dma_channel_configure(canal_dma[i], &c, buffer_bruto[i], &adc_hw->fifo,
+                          amostras_brutas, false);
+    dma_channel_set_irq1_enabled(canal_dma[i], true);
+  }
+  nucleo_irq = get_core_num();
+  irq_add_shared_handler(DMA_IRQ_1, aquisicao_irq_dma,
+                         PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_1, true);
+
+  adc_fifo_drain();
+  dma_channel_start(canal_dma[0]);
+  adc_run(true);
+}
+
+// Define a taxa de amostragem de cada canal pelo divisor de clock do ADC: uma
+// conversão a cada (1 + div) ciclos de clk_adc, com div em passos de 1/256.
+// O ADC converte fator_sobreamostragem vezes mais rápido que taxa_hz, que é
+// a taxa das amostras entregues nos blocos. Pode ser chamada com a aquisição
+// em andamento (o round-robin não perde o alinhamento). Retorna a taxa nominal
+// obtida, que é exata sempre que AQ_CLOCK_ADC_HZ / (taxa_hz * fator * canais)
+// for múltiplo de 1/256 (ex.: 8, 16 e 48 kHz com dois canais sem
+// sobreamostragem, 8 e 16 kHz com fator 4)
+float aquisicao_definir_taxa(uint32_t taxa_hz) {
+  uint8_t canais = num_canais ? num_canais : 1;
+  float ciclos = (float)AQ_CLOCK_ADC_HZ /
+                 ((float)taxa_hz * fator_sobreamostragem * canais);
+  if (ciclos < 96.0f) ciclos = 96.0f;  // Uma conversão leva 96 ciclos
+
+  uint32_t div_fixo = (uint32_t)((ciclos - 1.0f) * 256.0f + 0.5f);
+  adc_set_clkdiv(div_fixo / 256.0f);
+
+  taxa_pedida = taxa_hz;
+  taxa_nominal = AQ_CLOCK_ADC_HZ * 256.0f /
+                 ((div_fixo + 256.0f) * fator_sobreamostragem * canais);
+  medir_reiniciar = true;
+  return taxa_nominal;
+}
+
+// Define quantas conversões (potência de 2, até AQ_SOBREAMOSTRAGEM_MAX) são
+// somadas em cada amostra de áudio, reduzindo o fator se o ADC não comportar
+// a taxa atual multiplicada por ele, e reprograma o divisor. Deve ser chamada
+// depois de aquisicao_iniciar; o bloco em preenchimento é reiniciado.
+// Retorna o fator aplicado
+uint8_t aquisicao_definir_sobreamostragem(uint8_t fator) {
+  uint8_t canais = num_canais ? num_canais : 1;
+  uint8_t aplicado = 1;
+  while (aplicado * 2 <= fator && aplicado * 2 <= AQ_SOBREAMOSTRAGEM_MAX &&
+         (uint64_t)taxa_pedida * aplicado * 2 * canais * 96 <=
+             AQ_CLOCK_ADC_HZ) {
+    aplicado *= 2;
+  }
+
+  uint32_t estado = spin_lock_blocking(trava);
+  fator_sobreamostragem = aplicado;
+  bloco_atual = NULL;
+  spin_unlock(trava, estado);
+
+  aquisicao_definir_taxa(taxa_pedida);
+  return aplicado;
+}
+
+// Conversões somadas em cada amostra dos blocos de áudio
+uint8_t aquisicao_sobreamostragem(void) { return fator_sobreamostragem; }
+
+// Taxa de cada canal configurada no divisor do ADC (Hz)
+float aquisicao_taxa_nominal(void) { return taxa_nominal; }
+
+// Taxa efetiva de cada canal medida pelos blocos concluídos desde a última
+// configuração (Hz), contra o temporizador do sistema. Zero até haver dois
+// blocos
+float aquisicao_taxa_medida(void) {
+  uint32_t estado = spin_lock_blocking(trava);
+  bool reiniciar = medir_reiniciar;
+  uint32_t s0 = medir_sequencia_inicial, s1 = medir_sequencia;
+  uint64_t t0 = medir_instante_inicial, t1 = medir_instante;
+  spin_unlock(trava, estado);
+
+  if (reiniciar || s1 == s0 || t1 <= t0) return 0.0f;
+  return (float)(s1 - s0) * AQ_AMOSTRAS_BLOCO * 1e6f / (float)(t1 - t0);
+}
+
+// Retorna o bloco de áudio mais antigo ainda não consumido, ou NULL se não
+// houver. O bloco é lido diretamente do anel e continua válido até
+// aquisicao_liberar_bloco
+const aq_bloco_t *aquisicao_proximo_bloco(void) {
+  if (bloco_leitura == bloco_escrita) return NULL;
+  return &blocos[bloco_leitura % AQ_BLOCOS];
+}
+
+// Devolve ao anel o bloco obtido por aquisicao_proximo_bloco
+void aquisicao_liberar_bloco(void) {
+  if (bloco_leitura != bloco_escrita) bloco_leitura++;
+}
+
+// Último valor decimado (média do bloco) de um canal lento
+uint16_t aquisicao_canal_lento(uint gpio) { return valor_lento[gpio - 26]; }
+
+// Blocos descartados porque o consumidor não acompanhou a aquisição
+uint32_t aquisicao_blocos_perdidos(void) { return blocos_perdidos; }
+
+// Suspende a aquisição se a interrupção de DMA for atendida pelo núcleo que
+// chama. Com as interrupções desse núcleo desligadas (ex.: durante a gravação
+// da flash) o canal concluído não seria rearmado e o DMA encadeado passaria a
+// escrever além de buffer_bruto. Retorna true se suspendeu; nesse caso
+// aquisicao_retomar deve ser chamada ao fim da operação
+bool aquisicao_suspender(void) {
+  if (num_canais == 0 || get_core_num() != nucleo_irq) return false;
+
+  uint32_t mascara = (1u << canal_dma[0]) | (1u << canal_dma[1]);
+  adc_run(false);
+  // O aborto pode sinalizar a interrupção do canal (errata RP2040-E13)
+  hw_clear_bits(&dma_hw->inte1, mascara);
+  dma_hw->abort = mascara;
+  while (dma_hw->abort & mascara) tight_loop_contents();
+  dma_hw->ints1 = mascara;
+  hw_set_bits(&dma_hw->inte1, mascara);
+  return true;
+}
+
+// Retoma a aquisição suspensa por aquisicao_suspender. O buffer interrompido
+// e o bloco em preenchimento são descartados e o round-robin recomeça pela
+// primeira entrada
+void aquisicao_retomar(void) {
+  uint amostras_brutas = AQ_AMOSTRAS_BLOCO * num_canais;
+
+  adc_fifo_drain();  // Espera a conversão em curso e esvazia a FIFO
+  adc_select_input(ordem_canais[0]);
+  for (int i = 0; i < 2; i++) {
+    dma_channel_set_write_addr(canal_dma[i], buffer_bruto[i], false);
+    dma_channel_set_trans_count(canal_dma[i], amostras_brutas, false);
+  }
+  bloco_atual = NULL;
+  medir_reiniciar = true;
+  dma_channel_start(canal_dma[0]);
+  adc_run(true);
+}
@@ -0,0 +1,41 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+
+#ifndef aquisicao_inc_h
+#define aquisicao_inc_h
+
+// Taxa de amostragem de cada canal (Hz); pode ser definida na compilação
+#ifndef AQ_TAXA_PADRAO_HZ
+#define AQ_TAXA_PADRAO_HZ 16000
+#endif
+#define AQ_AMOSTRAS_BLOCO 256    // Amostras de áudio por bloco
+#define AQ_BLOCOS 16             // Blocos de áudio no anel (potência de 2)
+#define AQ_MAX_CANAIS 5          // Entradas do ADC (0 a 3 + sensor interno)
+#define AQ_CLOCK_ADC_HZ 48000000 // Clock do ADC (clk_adc)
+#define AQ_SOBREAMOSTRAGEM_MAX 16 // Maior soma de conversões (cabe em 16 bits)
+
+// Bloco de áudio contíguo, já separado dos outros canais do round-robin. Cada
+// amostra é a soma de aquisicao_sobreamostragem() conversões de 12 bits
+typedef struct {
+  uint16_t amostras[AQ_AMOSTRAS_BLOCO];
+  uint32_t sequencia;   // Número do bloco desde o início da aquisição
+  uint64_t instante_us; // Instante em que o bloco foi concluído
+} aq_bloco_t;
+
+extern void aquisicao_adicionar_canal_lento(uint gpio);
+extern void aquisicao_iniciar(uint gpio_audio, uint32_t taxa_hz);
+extern float aquisicao_definir_taxa(uint32_t taxa_hz);
+extern uint8_t aquisicao_definir_sobreamostragem(uint8_t fator);
+extern uint8_t aquisicao_sobreamostragem(void);
+extern float aquisicao_taxa_nominal(void);
+extern float aquisicao_taxa_medida(void);
+extern const aq_bloco_t *aquisicao_proximo_bloco(void);
+extern void aquisicao_liberar_bloco(void);
+extern uint16_t aquisicao_canal_lento(uint gpio);
+extern uint32_t aquisicao_blocos_perdidos(void);
+extern bool aquisicao_suspender(void);
+extern void aquisicao_retomar(void);
+
+#endif
@@ -0,0 +1,157 @@
+#include "bandas.h"
+
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BANDAS_UM (1 << BANDAS_Q)
+
+// Converte um coeficiente para Q2.14
+static int32_t bandas_q(double valor) {
+  return (int32_t)lround(valor * BANDAS_UM);
+}
+
+// Passa-faixa RBJ de ganho unitário no centro (b1 = 0, b2 = -b0)
+static void bandas_projetar_faixa(bandas_biquad_t *f, double w0, double q) {
+  double alpha = sin(w0) / (2.0 * q);
+  double a0 = 1.0 + alpha;
+
+  memset(f, 0, sizeof(*f));
+  f->b0 = bandas_q(alpha / a0);
+  f->b2 = -f->b0;
+  f->a1 = bandas_q(-2.0 * cos(w0) / a0);
+  f->a2 = bandas_q((1.0 - alpha) / a0);
+}
+
+// Passa-baixa RBJ
+static void bandas_projetar_baixa(bandas_biquad_t *f, double w0, double q) {
+  double alpha = sin(w0) / (2.0 * q);
+  double a0 = 1.0 + alpha;
+  double b = (1.0 - cos(w0)) / 2.0 / a0;
+
+  memset(f, 0, sizeof(*f));
+  f->b0 = bandas_q(b);
+  f->b1 = bandas_q(2.0 * b);
+  f->b2 = f->b0;
+  f->a1 = bandas_q(-2.0 * cos(w0) / a0);
+  f->a2 = bandas_q((1.0 - alpha) / a0);
+}
+
+static inline int32_t bandas_biquad(bandas_biquad_t *f, int32_t x) {
+  int32_t acc = f->b0 * x + f->b1 * f->x1 + f->b2 * f->x2 - f->a1 * f->y1 -
+                f->a2 * f->y2;
+  int32_t y = (acc + (1 << (BANDAS_Q - 1))) >> BANDAS_Q;
+
+  f->x2 = f->x1;
+  f->x1 = x;
+  f->y2 = f->y1;
+  f->y1 = y;
+  return y;
+}
+
+// Projeta o banco para a taxa de amostragem. A banda mais aguda é a maior da
+// série cuja borda superior fica abaixo de BANDAS_BORDA_MAX * taxa_hz, o que
+// deixa as bandas dos níveis decimados na parte plana do anti-aliasing; a cada
+// nível abaixo as frequências caem uma oitava, até BANDAS_FREQ_MIN
+void bandas_iniciar(bandas_t *b, float taxa_hz, bool terco_oitava) {
+  memset(b, 0, sizeof(*b));
+  b->por_nivel = terco_oitava ? BANDAS_POR_NIVEL : 1;
+
+  // Meia largura de banda em oitavas e fator de qualidade da banda. Com duas
+  // seções iguais em cascata a banda de -3 dB estreita por sqrt(sqrt(2) - 1),
+  // então cada seção usa um Q menor para manter a largura nominal
+  double meia = terco_oitava ? 1.0 / 6.0 : 0.5;
+  double q = 1.0 / (pow(2.0, meia) - pow(2.0, -meia));
+  double q_secao = q * sqrt(sqrt(2.0) - 1.0);
+  int passo = terco_oitava ? 1 : 3;  // Em terços de oitava
+
+  int k = 0;
+  double borda = BANDAS_BORDA_MAX * taxa_hz;
+  while (1000.0 * pow(2.0, (k + passo) / 3.0) * pow(2.0, meia) < borda) {
+    k += passo;
+  }
+  while (1000.0 * pow(2.0, k / 3.0) * pow(2.0, meia) >= borda) {
+    k -= passo;
+  }
+  int k_base = k - (b->por_nivel - 1) * passo;  // Banda mais grave do nível 0
+
+  // Coeficientes do nível 0; os demais níveis reutilizam os mesmos valores
+  bandas_nivel_t modelo;
+  memset(&modelo, 0, sizeof(modelo));
+  for (int j = 0; j < b->por_nivel; j++) {
+    double fc = 1000.0 * pow(2.0, (k_base + j * passo) / 3.0);
+    double w0 = 2.0 * M_PI * fc / taxa_hz;
+    bandas_projetar_faixa(&modelo.faixa[j][0], w0, q_secao);
+    modelo.faixa[j][1] = modelo.faixa[j][0];
+  }
+  // Butterworth de 6ª ordem em 0,22 * taxa do nível
+  bandas_projetar_baixa(&modelo.antialias[0], 2.0 * M_PI * 0.22, 0.5176);
+  bandas_projetar_baixa(&modelo.antialias[1], 2.0 * M_PI * 0.22, 0.7071);
+  bandas_projetar_baixa(&modelo.antialias[2], 2.0 * M_PI * 0.22, 1.9319);
+
+  while (b->niveis < BANDAS_NIVEIS &&
+         1000.0 * pow(2.0, (k - 3 * b->niveis) / 3.0) >= BANDAS_FREQ_MIN) {
+    b->nivel[b->niveis++] = modelo;
+  }
+
+  b->num_bandas = b->niveis * b->por_nivel;
+  for (int n = 0; n < b->niveis; n++) {
+    for (int j = 0; j < b->por_nivel; j++) {
+      int indice = (b->niveis - 1 - n) * b->por_nivel + j;
+      b->frequencia[indice] =
+          1000.0f * powf(2.0f, (k_base - 3 * n + j * passo) / 3.0f);
+    }
+  }
+}
+
+// Processa uma amostra no nível 0 e desce pelos níveis enquanto a decimação
+// deixar a amostra passar
+static void bandas_amostra(bandas_t *b, int32_t x) {
+  for (int n = 0; n < b->niveis; n++) {
+    bandas_nivel_t *nivel = &b->nivel[n];
+
+    for (int j = 0; j < b->por_nivel; j++) {
+      int32_t y = bandas_biquad(&nivel->faixa[j][0], x);
+      y = bandas_biquad(&nivel->faixa[j][1], y);
+      nivel->energia[j] += (uint64_t)((int64_t)y * y);
+    }
+    nivel->amostras++;
+
+    if (n + 1 == b->niveis) return;
+    x = bandas_biquad(&nivel->antialias[0], x);
+    x = bandas_biquad(&nivel->antialias[1], x);
+    x = bandas_biquad(&nivel->antialias[2], x);
+    nivel->descartar = !nivel->descartar;
+    if (nivel->descartar) return;
+  }
+}
+
+// Processa n amostras sem offset DC. Para não saturar os acumuladores de 32
+// bits, as amostras devem ficar em +-8192 (ADC de 12 bits deslocado de 2 bits)
+void bandas_processar(bandas_t *b, const int16_t *x, int n) {
+  for (int i = 0; i < n; i++) {
+    bandas_amostra(b, x[i]);
+  }
+}
+
+// Calcula o Leq de cada banda desde a última chamada (do grave ao agudo),
+// soma offset_db para converter a unidade interna em dB SPL e zera os
+// acumuladores. Retorna o número de bandas
+int bandas_leq(bandas_t *b, float offset_db, float *leq_db) {
+  for (int n = 0; n < b->niveis; n++) {
+    bandas_nivel_t *nivel = &b->nivel[n];
+    for (int j = 0; j < b->por_nivel; j++) {
+      int indice = (b->niveis - 1 - n) * b->por_nivel + j;
+      float media = nivel->amostras
+                        ? (float)nivel->energia[j] / nivel->amostras
+                        : 0.0f;
+      leq_db[indice] = 10.0f * log10f(media + 1e-12f) + offset_db;
+      nivel->energia[j] = 0;
+    }
+    nivel->amostras = 0;
+  }
+  return b->num_bandas;
+}
@@ -0,0 +1,47 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef bandas_inc_h
+#define bandas_inc_h
+
+// Banco de filtros de oitava / terço de oitava em ponto fixo. Cada nível de
+// decimação cobre uma oitava: os filtros de banda do nível superior rodam na
+// taxa de amostragem e, a cada nível abaixo, o sinal passa por um filtro
+// anti-aliasing e é decimado por 2, de modo que os mesmos coeficientes servem
+// para todas as oitavas e as bandas graves custam quase nada. As frequências
+// centrais seguem a série de base 2 (1000 Hz * 2^(k/3))
+
+#define BANDAS_NIVEIS 10    // Oitavas (níveis de decimação) no máximo
+#define BANDAS_POR_NIVEL 3  // Terços de oitava por nível
+#define BANDAS_MAX (BANDAS_NIVEIS * BANDAS_POR_NIVEL)
+#define BANDAS_Q 14         // Formato dos coeficientes (Q2.14)
+#define BANDAS_FREQ_MIN 31.0f  // Nível mais grave: banda mais aguda >= (Hz)
+#define BANDAS_BORDA_MAX 0.36  // Borda superior da banda mais aguda / taxa
+
+// Seção biquad na forma direta I, estado em inteiros
+typedef struct {
+  int32_t b0, b1, b2, a1, a2;
+  int32_t x1, x2, y1, y2;
+} bandas_biquad_t;
+
+typedef struct {
+  bandas_biquad_t faixa[BANDAS_POR_NIVEL][2];  // Duas seções por banda
+  bandas_biquad_t antialias[3];  // Passa-baixa antes da decimação por 2
+  bool descartar;                // Fase da decimação
+  uint64_t energia[BANDAS_POR_NIVEL];
+  uint32_t amostras;
+} bandas_nivel_t;
+
+typedef struct {
+  uint8_t por_nivel;  // 1 (oitava) ou 3 (terço de oitava)
+  uint8_t niveis;
+  uint8_t num_bandas;
+  float frequencia[BANDAS_MAX];  // Centro de cada banda, do grave ao agudo
+  bandas_nivel_t nivel[BANDAS_NIVEIS];  // nivel[0] roda na taxa do sinal
+} bandas_t;
+
+extern void bandas_iniciar(bandas_t *b, float taxa_hz, bool terco_oitava);
+extern void bandas_processar(bandas_t *b, const int16_t *x, int n);
+extern int bandas_leq(bandas_t *b, float offset_db, float *leq_db);
+
+#endif
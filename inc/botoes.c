@@ -0,0 +1,114 @@
+#include "botoes.h"
+
+#include "pico/util/queue.h"
+
+// Máquina de estados de cada botão. As bordas chegam pela interrupção de GPIO
+// e o temporizador de varredura cuida do debounce da liberação, do toque longo
+// e da repetição automática. Os eventos vão para uma fila consumida pelo loop
+// principal, então nenhum toque se perde enquanto o display é desenhado
+typedef enum {
+  ESTADO_SOLTO,
+  ESTADO_PRESSIONADO,
+  ESTADO_REPETINDO,
+} estado_botao_t;
+
+typedef struct {
+  uint gpio;
+  bool ativo;
+  estado_botao_t estado;
+  uint32_t instante_transicao;  // Última transição aceita
+  uint32_t proximo_evento;      // Próximo LONGO/REPETICAO
+} botao_t;
+
+static botao_t botoes[BOTOES_MAX];
+static queue_t fila_eventos;
+static repeating_timer_t temporizador_varredura;
+static volatile uint32_t eventos_perdidos = 0;
+
+static void botoes_emitir(uint8_t botao, tipo_evento_botao_t tipo,
+                          uint32_t agora) {
+  evento_botao_t evento = {.botao = botao, .tipo = tipo, .instante_us = agora};
+  if (!queue_try_add(&fila_eventos, &evento)) {
+    eventos_perdidos++;
+  }
+}
+
+// Interrupção de borda: o toque é reportado imediatamente (debounce pela borda
+// de entrada) e bordas seguintes são ignoradas durante BOTOES_DEBOUNCE_MS
+static void botoes_irq(uint gpio, uint32_t eventos) {
+  uint32_t agora = time_us_32();
+
+  for (uint8_t i = 0; i < BOTOES_MAX; i++) {
+    botao_t *b = &botoes[i];
+    if (!b->ativo || b->gpio != gpio) continue;
+
+    if (!(eventos & GPIO_IRQ_EDGE_FALL) || b->estado != ESTADO_SOLTO) return;
+    if (agora - b->instante_transicao < BOTOES_DEBOUNCE_MS * 1000) return;
+
+    b->estado = ESTADO_PRESSIONADO;
+    b->instante_transicao = agora;
+    b->proximo_evento = agora + BOTOES_LONGO_MS * 1000;
+    botoes_emitir(i, BOTAO_PRESSIONADO, agora);
+    return;
+  }
+}
+
+// Varredura periódica dos botões pressionados: confirma a liberação pelo nível
+// do pino (após o debounce) e gera LONGO e REPETICAO
+static bool botoes_varredura(repeating_timer_t *t) {
+  uint32_t agora = time_us_32();
+
+  for (uint8_t i = 0; i < BOTOES_MAX; i++) {
+    botao_t *b = &botoes[i];
+    if (!b->ativo || b->estado == ESTADO_SOLTO) continue;
+    if (agora - b->instante_transicao < BOTOES_DEBOUNCE_MS * 1000) continue;
+
+    if (gpio_get(b->gpio)) {
+      b->estado = ESTADO_SOLTO;
+      b->instante_transicao = agora;
+      botoes_emitir(i, BOTAO_SOLTO, agora);
+    } else if ((int32_t)(agora - b->proximo_evento) >= 0) {
+      botoes_emitir(i, b->estado == ESTADO_PRESSIONADO ? BOTAO_LONGO
+                                                       : BOTAO_REPETICAO,
+                    agora);
+      b->estado = ESTADO_REPETINDO;
+      b->proximo_evento = agora + BOTOES_REPETICAO_MS * 1000;
+    }
+  }
+  return true;
+}
+
+// Cria a fila de eventos e inicia o temporizador de varredura
+void botoes_iniciar(void) {
+  queue_init(&fila_eventos, sizeof(evento_botao_t), BOTOES_FILA);
+  add_repeating_timer_ms(BOTOES_VARREDURA_MS, botoes_varredura, NULL,
+                         &temporizador_varredura);
+}
+
+// Configura o pino como entrada com pull-up (botão ativo em nível baixo) e
+// habilita a interrupção de borda de descida
+bool botoes_registrar(uint8_t botao, uint gpio) {
+  if (botao >= BOTOES_MAX) return false;
+
+  gpio_init(gpio);
+  gpio_set_dir(gpio, GPIO_IN);
+  gpio_pull_up(gpio);
+
+  botoes[botao] = (botao_t){.gpio = gpio, .ativo = true};
+  gpio_set_irq_enabled_with_callback(gpio, GPIO_IRQ_EDGE_FALL, true,
+                                     botoes_irq);
+  return true;
+}
+
+// Retira o próximo evento da fila; retorna false se não houver eventos
+bool botoes_obter_evento(evento_botao_t *evento) {
+  return queue_try_remove(&fila_eventos, evento);
+}
+
+// Retorna true se o botão está pressionado segundo a máquina de estados
+bool botoes_pressionado(uint8_t botao) {
+  return botao < BOTOES_MAX && botoes[botao].estado != ESTADO_SOLTO;
+}
+
+// Eventos descartados por fila cheia
+uint32_t botoes_eventos_perdidos(void) { return eventos_perdidos; }
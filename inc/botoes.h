@@ -0,0 +1,35 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+
+#ifndef botoes_inc_h
+#define botoes_inc_h
+
+#define BOTOES_MAX 4                // Botões registráveis
+#define BOTOES_FILA 16              // Eventos pendentes na fila
+#define BOTOES_DEBOUNCE_MS 20       // Bordas ignoradas após uma transição
+#define BOTOES_LONGO_MS 600         // Tempo pressionado até o evento LONGO
+#define BOTOES_REPETICAO_MS 150     // Período da repetição automática
+#define BOTOES_VARREDURA_MS 5       // Período do temporizador de varredura
+
+typedef enum {
+  BOTAO_PRESSIONADO,  // Borda de descida confirmada (emitido na própria IRQ)
+  BOTAO_LONGO,        // Mantido por BOTOES_LONGO_MS
+  BOTAO_REPETICAO,    // A cada BOTOES_REPETICAO_MS após o LONGO
+  BOTAO_SOLTO,        // Botão liberado
+} tipo_evento_botao_t;
+
+typedef struct {
+  uint8_t botao;  // Índice passado em botoes_registrar
+  uint8_t tipo;   // tipo_evento_botao_t
+  uint32_t instante_us;
+} evento_botao_t;
+
+extern void botoes_iniciar(void);
+extern bool botoes_registrar(uint8_t botao, uint gpio);
+extern bool botoes_obter_evento(evento_botao_t *evento);
+extern bool botoes_pressionado(uint8_t botao);
+extern uint32_t botoes_eventos_perdidos(void);
+
+#endif
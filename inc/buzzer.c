@@ -0,0 +1,129 @@
+#include "buzzer.h"
+
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "pico/stdlib.h"
+
+static uint32_t slice;
+static uint32_t canal;
+static uint32_t contagem_hz;  // Clock do contador do PWM
+static int alarme = -1;
+
+// Estado do sequenciador, mexido pela interrupção e, com ela desligada, por
+// buzzer_tocar / buzzer_parar
+static const buzzer_sequencia_t *volatile sequencia = NULL;
+static uint8_t passo;
+static uint64_t inicio_passo_us;
+static uint64_t fim_passo_us;
+static uint64_t proximo_us;
+
+static void aplicar_frequencia(uint32_t hz) {
+  if (hz == 0) {
+    pwm_set_chan_level(slice, canal, 0);  // Silêncio com o PWM rodando
+    return;
+  }
+  uint32_t topo = contagem_hz / hz;
+  if (topo > 65536) topo = 65536;
+  if (topo < 2) topo = 2;
+  pwm_set_wrap(slice, (uint16_t)(topo - 1));
+  pwm_set_chan_level(slice, canal, (uint16_t)(topo / 2));  // 50%
+}
+
+// Frequência do passo atual no instante t (interpolada nas varreduras)
+static uint32_t frequencia(const buzzer_passo_t *p, uint64_t t) {
+  int32_t delta = (int32_t)p->freq_fim_hz - p->freq_inicio_hz;
+  uint64_t duracao = fim_passo_us - inicio_passo_us;
+  return p->freq_inicio_hz +
+         (int32_t)((int64_t)delta * (int64_t)(t - inicio_passo_us) /
+                   (int64_t)duracao);
+}
+
+static void entrar_passo(uint8_t indice, uint64_t inicio_us) {
+  const buzzer_passo_t *p = &sequencia->passos[indice];
+  passo = indice;
+  inicio_passo_us = inicio_us;
+  uint16_t duracao_ms = p->duracao_ms ? p->duracao_ms : 1;
+  fim_passo_us = inicio_us + duracao_ms * 1000ull;
+  aplicar_frequencia(p->freq_inicio_hz);
+}
+
+// Instante do próximo evento do passo atual: o fim, ou o próximo degrau da
+// varredura
+static uint64_t proximo_evento(uint64_t agora_us) {
+  const buzzer_passo_t *p = &sequencia->passos[passo];
+  if (p->freq_inicio_hz != p->freq_fim_hz &&
+      agora_us + BUZZER_VARREDURA_US < fim_passo_us) {
+    return agora_us + BUZZER_VARREDURA_US;
+  }
+  return fim_passo_us;
+}
+
+static void parar_pwm(void) {
+  sequencia = NULL;
+  pwm_set_chan_level(slice, canal, 0);
+  pwm_set_enabled(slice, false);
+}
+
+// Interrupção do alarme: avança a sequência. Se o próximo instante já passou
+// (interrupção atrasada), processa em seguida sem esperar
+static void no_alarme(uint numero) {
+  (void)numero;
+  do {
+    if (sequencia == NULL) return;
+    if (proximo_us >= fim_passo_us) {
+      int proximo = passo + 1;
+      if (proximo >= sequencia->num) {
+        if (sequencia->repetir_de < 0) {
+          parar_pwm();
+          return;
+        }
+        proximo = sequencia->repetir_de;
+      }
+      entrar_passo((uint8_t)proximo, fim_passo_us);
+    } else {
+      aplicar_frequencia(frequencia(&sequencia->passos[passo], proximo_us));
+    }
+    proximo_us = proximo_evento(proximo_us);
+  } while (hardware_alarm_set_target(alarme, from_us_since_boot(proximo_us)));
+}
+
+// Configura o PWM do pino e reserva um alarme do timer para o sequenciador
+void buzzer_iniciar(uint32_t pino) {
+  gpio_set_function(pino, GPIO_FUNC_PWM);
+  slice = pwm_gpio_to_slice_num(pino);
+  canal = pwm_gpio_to_channel(pino);
+  pwm_config config = pwm_get_default_config();
+  pwm_config_set_clkdiv_int(&config, BUZZER_DIVISOR);
+  pwm_init(slice, &config, false);
+  contagem_hz = clock_get_hz(clk_sys) / BUZZER_DIVISOR;
+
+  alarme = hardware_alarm_claim_unused(true);
+  hardware_alarm_set_callback(alarme, no_alarme);
+}
+
+// Toca a sequência desde o primeiro passo, interrompendo a atual
+void buzzer_tocar(const buzzer_sequencia_t *nova) {
+  if (alarme < 0 || nova == NULL || nova->num == 0) return;
+  hardware_alarm_cancel(alarme);
+  uint32_t interrupcoes = save_and_disable_interrupts();
+  sequencia = nova;
+  entrar_passo(0, time_us_64());
+  pwm_set_counter(slice, 0);
+  pwm_set_enabled(slice, true);
+  proximo_us = proximo_evento(inicio_passo_us);
+  restore_interrupts(interrupcoes);
+  if (hardware_alarm_set_target(alarme, from_us_since_boot(proximo_us))) {
+    no_alarme(alarme);  // Passo mais curto que a própria configuração
+  }
+}
+
+void buzzer_parar(void) {
+  if (alarme < 0) return;
+  hardware_alarm_cancel(alarme);
+  uint32_t interrupcoes = save_and_disable_interrupts();
+  parar_pwm();
+  restore_interrupts(interrupcoes);
+}
@@ -0,0 +1,42 @@
+#include <stdint.h>
+
+#ifndef buzzer_inc_h
+#define buzzer_inc_h
+
+// Sequenciador do buzzer: toca sozinho, a partir de uma tabela de passos,
+// tons, silêncios e varreduras de frequência. Um alarme de hardware do timer
+// dispara no fim de cada passo (e a cada BUZZER_VARREDURA_US numa varredura)
+// e a interrupção reescreve o TOP e o nível do PWM, que só são aplicados na
+// virada do contador, sem cortar o ciclo em curso. Os instantes são
+// absolutos (fim do passo anterior + duração), então o erro não acumula e
+// fica na latência da interrupção, bem abaixo de 1 ms. A exceção são as
+// gravações na flash (log, configurações e calibração), que desligam as
+// interrupções do core0, onde o alarme é atendido: o passo em curso se
+// estende pela gravação (até algumas dezenas de ms num apagamento de setor)
+// e a sequência retoma no instante absoluto seguinte, sem acumular o atraso.
+// O laço principal só escolhe a sequência
+
+#define BUZZER_VARREDURA_US 1000  // Passo de frequência das varreduras
+#define BUZZER_DIVISOR 16         // Divisor do PWM: de 120 Hz a 20 kHz em 16 bits
+
+// Um passo: tom fixo (freq_inicio_hz == freq_fim_hz), varredura linear ou
+// silêncio (as duas frequências em 0)
+typedef struct {
+  uint16_t freq_inicio_hz;
+  uint16_t freq_fim_hz;
+  uint16_t duracao_ms;
+} buzzer_passo_t;
+
+// Sequência de passos. Ao fim volta ao passo repetir_de (uma introdução pode
+// ficar antes dele), ou para se repetir_de < 0
+typedef struct {
+  const buzzer_passo_t *passos;
+  uint8_t num;
+  int8_t repetir_de;
+} buzzer_sequencia_t;
+
+extern void buzzer_iniciar(uint32_t pino);
+extern void buzzer_tocar(const buzzer_sequencia_t *sequencia);
+extern void buzzer_parar(void);
+
+#endif
@@ -0,0 +1,71 @@
+#include "calibracao.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "aquisicao.h"
+#include "crc32.h"
+#include "flash_layout.h"
+#include "hardware/sync.h"
+
+static uint32_t calibracao_crc(const void *registro, uint16_t tamanho) {
+  return crc32_calcular(registro, tamanho - sizeof(uint32_t));
+}
+
+// Lê o registro de calibração pela XIP. Retorna false (e um registro zerado)
+// se o setor estiver apagado ou corrompido. Registros de versões anteriores
+// são aceitos e completados com zeros
+bool calibracao_carregar(calibracao_registro_t *registro) {
+  const calibracao_registro_t *gravado =
+      FLASH_ENDERECO(FLASH_CALIBRACAO_OFFSET);
+  uint16_t tamanho = gravado->tamanho;
+
+  memset(registro, 0, sizeof(*registro));
+  if (gravado->magica != CALIBRACAO_MAGICA || gravado->versao == 0 ||
+      gravado->versao > CALIBRACAO_VERSAO ||
+      tamanho < CALIBRACAO_TAMANHO_V1 ||
+      tamanho > sizeof(calibracao_registro_t) ||
+      tamanho % sizeof(uint32_t) != 0) {
+    return false;
+  }
+
+  uint32_t crc;
+  memcpy(&crc, (const uint8_t *)gravado + tamanho - sizeof(crc), sizeof(crc));
+  if (crc != calibracao_crc(gravado, tamanho)) return false;
+
+  memcpy(registro, gravado, tamanho - sizeof(crc));
+  registro->crc = crc;
+  return true;
+}
+
+// Apaga o setor de calibração e grava o novo registro. As interrupções deste
+// núcleo ficam desligadas durante a operação (a XIP fica indisponível), então
+// a aquisição é suspensa se a interrupção de DMA dela rodar aqui. Iniciada no
+// núcleo 1, ela continua rodando da RAM
+bool calibracao_salvar(const calibracao_registro_t *registro) {
+  union {
+    calibracao_registro_t registro;
+    uint8_t bytes[FLASH_PAGE_SIZE];
+  } pagina;
+  calibracao_registro_t *novo = &pagina.registro;
+
+  memset(pagina.bytes, 0xFF, sizeof(pagina.bytes));
+  *novo = *registro;
+  novo->magica = CALIBRACAO_MAGICA;
+  novo->versao = CALIBRACAO_VERSAO;
+  novo->tamanho = sizeof(calibracao_registro_t);
+  novo->crc = calibracao_crc(novo, novo->tamanho);
+
+  bool suspensa = aquisicao_suspender();
+  uint32_t estado = save_and_disable_interrupts();
+  flash_range_erase(FLASH_CALIBRACAO_OFFSET, FLASH_SECTOR_SIZE);
+  flash_range_program(FLASH_CALIBRACAO_OFFSET, pagina.bytes, FLASH_PAGE_SIZE);
+  restore_interrupts(estado);
+  if (suspensa) aquisicao_retomar();
+
+  calibracao_registro_t conferido;
+  return calibracao_carregar(&conferido) &&
+         memcmp(&conferido.ganho_mdb, &novo->ganho_mdb,
+                offsetof(calibracao_registro_t, crc) -
+                    offsetof(calibracao_registro_t, ganho_mdb)) == 0;
+}
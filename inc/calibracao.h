@@ -0,0 +1,31 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef calibracao_inc_h
+#define calibracao_inc_h
+
+#define CALIBRACAO_MAGICA 0x4D43414Cu  // "LACM"
+#define CALIBRACAO_VERSAO 2
+
+// Registro de calibração gravado no setor FLASH_CALIBRACAO_OFFSET. Versões
+// novas só acrescentam campos antes do CRC; um registro antigo é aceito e os
+// campos que ele não tem ficam zerados
+typedef struct {
+  uint32_t magica;
+  uint16_t versao;
+  uint16_t tamanho;    // Bytes gravados, incluindo o CRC
+  int32_t ganho_mdb;   // Correção somada ao nível medido (milésimos de dB)
+  // Versão 2: caracterização do ADC em repouso (zero = não caracterizado)
+  float ruido_quadratico;  // Média dos quadrados do piso (contagens << 2)
+  uint32_t ruido_sobreamostragem;  // Fator de sobreamostragem da medição
+  int32_t dc_q16;                  // Offset DC da entrada (contagens << 16)
+  uint32_t crc;        // CRC-32 dos campos anteriores
+} calibracao_registro_t;
+
+// Tamanho do registro da versão 1 (ganho seguido do CRC)
+#define CALIBRACAO_TAMANHO_V1 16
+
+extern bool calibracao_carregar(calibracao_registro_t *registro);
+extern bool calibracao_salvar(const calibracao_registro_t *registro);
+
+#endif
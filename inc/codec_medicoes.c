@@ -0,0 +1,152 @@
+#include "codec_medicoes.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "crc32.h"
+
+// Formato compacto do log de medições. Os níveis já chegam quantizados em
+// décimos de dB; cada registro guarda só a diferença para o anterior do mesmo
+// bloco, em quatro varints (7 bits por byte, o bit 7 indica continuação):
+//   zigzag(minuto - (minuto anterior + 1)), zigzag(delta Leq),
+//   zigzag(delta Lmax), alertas
+// Minutos consecutivos e níveis estáveis cabem em 1 byte por campo. O
+// primeiro registro de cada bloco parte de uma referência zerada, então
+// qualquer bloco é decodificado sozinho. Os bytes não usados do bloco ficam
+// em 0xFF (flash apagada)
+
+static uint32_t zigzag(int32_t valor) {
+  return ((uint32_t)valor << 1) ^ (uint32_t)(valor >> 31);
+}
+
+static int32_t dezigzag(uint32_t valor) {
+  return (int32_t)(valor >> 1) ^ -(int32_t)(valor & 1u);
+}
+
+static int escrever_varint(uint8_t *destino, uint32_t valor) {
+  int n = 0;
+  while (valor >= 0x80u) {
+    destino[n++] = (uint8_t)(valor | 0x80u);
+    valor >>= 7;
+  }
+  destino[n++] = (uint8_t)valor;
+  return n;
+}
+
+// Lê um varint de no máximo 5 bytes sem passar de fim. Retorna os bytes
+// consumidos, ou 0 se o varint estiver truncado
+static int ler_varint(const uint8_t *origem, const uint8_t *fim,
+                      uint32_t *valor) {
+  uint32_t resultado = 0;
+  for (int n = 0; n < 5 && origem + n < fim; n++) {
+    resultado |= (uint32_t)(origem[n] & 0x7Fu) << (7 * n);
+    if (!(origem[n] & 0x80u)) {
+      *valor = resultado;
+      return n + 1;
+    }
+  }
+  return 0;
+}
+
+static void referencia_inicial(medicao_t *referencia) {
+  memset(referencia, 0, sizeof(*referencia));
+  referencia->minuto = UINT32_MAX;  // O primeiro minuto esperado é o 0
+}
+
+static uint32_t bloco_crc(const uint8_t *bloco, uint16_t tamanho) {
+  uint32_t zero = 0;
+  uint32_t crc = crc32_calcular(bloco, offsetof(codec_cabecalho_t, crc));
+  crc = crc32_continuar(crc, &zero, sizeof(zero));
+  return crc32_continuar(crc, bloco + sizeof(codec_cabecalho_t), tamanho);
+}
+
+// Começa um bloco vazio em `bloco`
+void codec_iniciar(codec_escritor_t *escritor, uint8_t *bloco) {
+  memset(bloco, 0xFF, CODEC_BLOCO_TAMANHO);
+  escritor->bloco = bloco;
+  escritor->usado = sizeof(codec_cabecalho_t);
+  escritor->quantidade = 0;
+  escritor->sessao = 0;
+  referencia_inicial(&escritor->anterior);
+}
+
+// Codifica um registro no bloco. Retorna false (sem alterar o bloco) se ele
+// não couber ou for de outra sessão: o bloco deve ser fechado e um novo
+// iniciado
+bool codec_adicionar(codec_escritor_t *escritor, const medicao_t *medicao) {
+  if (escritor->quantidade > 0 && medicao->sessao != escritor->sessao) {
+    return false;
+  }
+
+  uint8_t registro[CODEC_REGISTRO_MAX];
+  const medicao_t *anterior = &escritor->anterior;
+  int n = escrever_varint(
+      registro, zigzag((int32_t)(medicao->minuto - (anterior->minuto + 1))));
+  n += escrever_varint(registro + n,
+                       zigzag((int32_t)medicao->leq_ddb - anterior->leq_ddb));
+  n += escrever_varint(registro + n, zigzag((int32_t)medicao->lmax_ddb -
+                                            anterior->lmax_ddb));
+  n += escrever_varint(registro + n, medicao->alertas);
+  if (escritor->usado + n > CODEC_BLOCO_TAMANHO) return false;
+
+  memcpy(escritor->bloco + escritor->usado, registro, n);
+  escritor->usado += n;
+  escritor->quantidade++;
+  escritor->sessao = medicao->sessao;
+  escritor->anterior = *medicao;
+  return true;
+}
+
+// Escreve o cabeçalho e o CRC; o bloco fica pronto para gravar
+void codec_fechar(codec_escritor_t *escritor, uint32_t sequencia) {
+  codec_cabecalho_t cabecalho = {
+      .magica = CODEC_MAGICA,
+      .sequencia = sequencia,
+      .sessao = escritor->sessao,
+      .quantidade = escritor->quantidade,
+      .tamanho = escritor->usado - sizeof(codec_cabecalho_t),
+      .reservado = 0xFFFF,
+      .crc = 0};
+  memcpy(escritor->bloco, &cabecalho, sizeof(cabecalho));
+  cabecalho.crc = bloco_crc(escritor->bloco, cabecalho.tamanho);
+  memcpy(escritor->bloco, &cabecalho, sizeof(cabecalho));
+}
+
+// Copia o cabeçalho de um bloco e confere a assinatura, os limites e o CRC
+bool codec_ler_cabecalho(const uint8_t *bloco, codec_cabecalho_t *cabecalho) {
+  memcpy(cabecalho, bloco, sizeof(*cabecalho));
+  return cabecalho->magica == CODEC_MAGICA && cabecalho->quantidade > 0 &&
+         cabecalho->quantidade <= CODEC_REGISTROS_MAX &&
+         cabecalho->tamanho <=
+             CODEC_BLOCO_TAMANHO - sizeof(codec_cabecalho_t) &&
+         cabecalho->crc == bloco_crc(bloco, cabecalho->tamanho);
+}
+
+// Decodifica até `max` registros de um bloco. Retorna quantos foram lidos, ou
+// -1 se o bloco for inválido
+int codec_decodificar(const uint8_t *bloco, medicao_t *registros, int max) {
+  codec_cabecalho_t cabecalho;
+  if (!codec_ler_cabecalho(bloco, &cabecalho)) return -1;
+
+  const uint8_t *p = bloco + sizeof(codec_cabecalho_t);
+  const uint8_t *fim = p + cabecalho.tamanho;
+  medicao_t atual;
+  referencia_inicial(&atual);
+  atual.sessao = cabecalho.sessao;
+
+  int lidos = 0;
+  while (lidos < cabecalho.quantidade && lidos < max) {
+    uint32_t campo[4];
+    for (int i = 0; i < 4; i++) {
+      int n = ler_varint(p, fim, &campo[i]);
+      if (n == 0) return -1;
+      p += n;
+    }
+    atual.minuto += 1 + (uint32_t)dezigzag(campo[0]);
+    atual.leq_ddb += dezigzag(campo[1]);
+    atual.lmax_ddb += dezigzag(campo[2]);
+    atual.alertas = campo[3];
+    registros[lidos++] = atual;
+  }
+  return lidos;
+}
@@ -0,0 +1,53 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef codec_medicoes_inc_h
+#define codec_medicoes_inc_h
+
+#define CODEC_MAGICA 0x5A474F4Cu   // "LOGZ"
+#define CODEC_BLOCO_TAMANHO 256    // Um bloco por página da flash
+// Cada registro ocupa de 4 a 17 bytes (quatro varints)
+#define CODEC_REGISTRO_MIN 4
+#define CODEC_REGISTRO_MAX 17
+#define CODEC_REGISTROS_MAX \
+  ((CODEC_BLOCO_TAMANHO - sizeof(codec_cabecalho_t)) / CODEC_REGISTRO_MIN)
+
+// Resumo de um minuto de medição
+typedef struct {
+  uint32_t minuto;    // Minutos desde o início da sessão
+  uint16_t sessao;    // Número da sessão (incrementado a cada boot)
+  uint16_t leq_ddb;   // Leq do minuto (décimos de dB)
+  uint16_t lmax_ddb;  // Maior leitura de janela no minuto (décimos de dB)
+  uint16_t alertas;   // Alertas disparados no minuto
+} medicao_t;
+
+// Cabeçalho de cada bloco, seguido de `tamanho` bytes de registros
+typedef struct {
+  uint32_t magica;
+  uint32_t sequencia;   // Número do bloco desde o primeiro uso do log
+  uint16_t sessao;      // Sessão de todos os registros do bloco
+  uint16_t quantidade;  // Registros no bloco
+  uint16_t tamanho;     // Bytes de registros após o cabeçalho
+  uint16_t reservado;
+  uint32_t crc;         // CRC-32 do cabeçalho (com este campo zerado) e dados
+} codec_cabecalho_t;
+
+// Estado do codificador de um bloco
+typedef struct {
+  uint8_t *bloco;         // CODEC_BLOCO_TAMANHO bytes
+  uint16_t usado;         // Bytes ocupados, incluindo o cabeçalho
+  uint16_t quantidade;
+  uint16_t sessao;
+  medicao_t anterior;     // Referência do delta do próximo registro
+} codec_escritor_t;
+
+extern void codec_iniciar(codec_escritor_t *escritor, uint8_t *bloco);
+extern bool codec_adicionar(codec_escritor_t *escritor,
+                            const medicao_t *medicao);
+extern void codec_fechar(codec_escritor_t *escritor, uint32_t sequencia);
+extern bool codec_ler_cabecalho(const uint8_t *bloco,
+                                codec_cabecalho_t *cabecalho);
+extern int codec_decodificar(const uint8_t *bloco, medicao_t *registros,
+                             int max);
+
+#endif
@@ -0,0 +1,134 @@
+#include "configuracoes.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "crc32.h"
+#include "flash_layout.h"
+#include "hardware/sync.h"
+#include "pico/stdlib.h"
+
+// Configurações em dois setores alternados: cada gravação vai para o setor
+// que não guarda a cópia mais recente, com a geração seguinte. O setor antigo
+// só é apagado na gravação depois dessa, então uma queda de energia no meio
+// da escrita deixa sempre uma cópia válida. Na leitura vale a cópia íntegra
+// (assinatura, versão e CRC) de maior geração
+
+typedef struct {
+  uint32_t magica;
+  uint16_t versao;
+  uint16_t tamanho;   // sizeof(configuracoes_registro_t)
+  uint32_t geracao;   // Incrementada a cada gravação
+  configuracoes_t valores;
+  uint32_t crc;       // CRC-32 dos campos anteriores
+} configuracoes_registro_t;
+
+static int setor_atual = -1;  // Setor com a cópia mais recente (-1: nenhum)
+static uint32_t geracao = 0;
+static configuracoes_t salvas;      // Conteúdo da cópia mais recente
+static configuracoes_t pendentes;   // Última alteração ainda não gravada
+static bool ha_pendentes = false;
+static uint8_t falhas = 0;          // Gravações de pendentes que falharam
+static uint32_t instante_alteracao_ms = 0;
+
+static uint32_t setor_offset(int setor) {
+  return FLASH_CONFIGURACOES_OFFSET + setor * FLASH_SECTOR_SIZE;
+}
+
+static const configuracoes_registro_t *registro_flash(int setor) {
+  return FLASH_ENDERECO(setor_offset(setor));
+}
+
+static uint32_t registro_crc(const configuracoes_registro_t *registro) {
+  return crc32_calcular(registro, offsetof(configuracoes_registro_t, crc));
+}
+
+static bool registro_valido(const configuracoes_registro_t *registro) {
+  return registro->magica == CONFIGURACOES_MAGICA &&
+         registro->versao == CONFIGURACOES_VERSAO &&
+         registro->tamanho == sizeof(configuracoes_registro_t) &&
+         registro->crc == registro_crc(registro);
+}
+
+// Lê a cópia válida mais recente. Retorna false se nenhum dos setores tiver
+// uma cópia íntegra; nesse caso *configuracoes deve trazer os valores de
+// fábrica, que passam a ser a referência: só uma alteração deles é gravada
+bool configuracoes_carregar(configuracoes_t *configuracoes) {
+  setor_atual = -1;
+  for (int setor = 0; setor < 2; setor++) {
+    const configuracoes_registro_t *registro = registro_flash(setor);
+    if (!registro_valido(registro)) continue;
+    if (setor_atual < 0 || (int32_t)(registro->geracao - geracao) > 0) {
+      setor_atual = setor;
+      geracao = registro->geracao;
+      salvas = registro->valores;
+    }
+  }
+
+  ha_pendentes = false;
+  falhas = 0;
+  if (setor_atual < 0) {
+    salvas = *configuracoes;
+    return false;
+  }
+  *configuracoes = salvas;
+  return true;
+}
+
+static bool configuracoes_gravar(const configuracoes_t *configuracoes) {
+  union {
+    configuracoes_registro_t registro;
+    uint8_t bytes[FLASH_PAGE_SIZE];
+  } pagina;
+  int destino = setor_atual == 0 ? 1 : 0;
+
+  memset(pagina.bytes, 0xFF, sizeof(pagina.bytes));
+  pagina.registro.magica = CONFIGURACOES_MAGICA;
+  pagina.registro.versao = CONFIGURACOES_VERSAO;
+  pagina.registro.tamanho = sizeof(configuracoes_registro_t);
+  pagina.registro.geracao = geracao + 1;
+  pagina.registro.valores = *configuracoes;
+  pagina.registro.crc = registro_crc(&pagina.registro);
+
+  uint32_t estado = save_and_disable_interrupts();
+  flash_range_erase(setor_offset(destino), FLASH_SECTOR_SIZE);
+  flash_range_program(setor_offset(destino), pagina.bytes, FLASH_PAGE_SIZE);
+  restore_interrupts(estado);
+
+  if (!registro_valido(registro_flash(destino))) return false;
+  setor_atual = destino;
+  geracao++;
+  salvas = *configuracoes;
+  return true;
+}
+
+// Chamada a cada volta do laço principal com as configurações em uso. Grava
+// só quando elas diferem da cópia na flash (ou dos valores de fábrica, sem
+// cópia) e ficaram CONFIGURACOES_ESPERA_MS sem mudar. Depois de
+// CONFIGURACOES_TENTATIVAS gravações com falha os mesmos valores não são
+// mais tentados; uma nova alteração recomeça a contagem
+void configuracoes_processar(const configuracoes_t *configuracoes) {
+  uint32_t agora = to_ms_since_boot(get_absolute_time());
+
+  if (memcmp(configuracoes, &salvas, sizeof(salvas)) == 0) {
+    ha_pendentes = false;
+    return;
+  }
+  if (!ha_pendentes ||
+      memcmp(configuracoes, &pendentes, sizeof(pendentes)) != 0) {
+    pendentes = *configuracoes;
+    ha_pendentes = true;
+    falhas = 0;
+    instante_alteracao_ms = agora;
+    return;
+  }
+  if (falhas >= CONFIGURACOES_TENTATIVAS) return;
+  if (agora - instante_alteracao_ms < CONFIGURACOES_ESPERA_MS) return;
+
+  if (configuracoes_gravar(&pendentes)) {
+    ha_pendentes = false;
+  } else {
+    falhas++;
+    instante_alteracao_ms = agora;  // Tenta de novo após outra espera
+  }
+}
@@ -0,0 +1,24 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef configuracoes_inc_h
+#define configuracoes_inc_h
+
+#define CONFIGURACOES_MAGICA 0x47464E43u  // "CNFG"
+#define CONFIGURACOES_VERSAO 1
+// Tempo sem alterações antes de gravar: ajustes seguidos viram uma gravação
+#define CONFIGURACOES_ESPERA_MS 3000
+// Gravações com falha (cópia não confere) antes de desistir dos mesmos valores
+#define CONFIGURACOES_TENTATIVAS 3
+
+// Ajustes do usuário preservados entre reinicializações
+typedef struct {
+  int16_t limite_ddb;  // Limite de alerta (décimos de dB)
+  uint8_t modo;        // Modo de exibição (enum Modo)
+  uint8_t reservado;
+} configuracoes_t;
+
+extern bool configuracoes_carregar(configuracoes_t *configuracoes);
+extern void configuracoes_processar(const configuracoes_t *configuracoes);
+
+#endif
@@ -0,0 +1,21 @@
+#include "crc32.h"
+
+// CRC-32 (IEEE 802.3, polinômio refletido 0xEDB88320) calculado bit a bit:
+// os registros protegidos são pequenos e isso evita uma tabela de 1 KiB
+
+// Continua um CRC já iniciado (use crc = 0 para começar)
+uint32_t crc32_continuar(uint32_t crc, const void *dados, size_t tamanho) {
+  const uint8_t *p = dados;
+  crc = ~crc;
+  while (tamanho--) {
+    crc ^= *p++;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1u));
+    }
+  }
+  return ~crc;
+}
+
+uint32_t crc32_calcular(const void *dados, size_t tamanho) {
+  return crc32_continuar(0, dados, tamanho);
+}
@@ -0,0 +1,11 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef crc32_inc_h
+#define crc32_inc_h
+
+extern uint32_t crc32_calcular(const void *dados, size_t tamanho);
+extern uint32_t crc32_continuar(uint32_t crc, const void *dados,
+                                size_t tamanho);
+
+#endif
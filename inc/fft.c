@@ -0,0 +1,79 @@
+#include "fft.h"
+
+#include "fft_tabela.h"
+
+// Seno em Q15 de um ângulo de passo * 2 * pi / 1024
+static inline int32_t fft_seno(uint32_t passo) {
+  passo &= FFT_MAX_PONTOS - 1;
+  if (passo <= 256) return fft_seno_q15[passo];
+  if (passo <= 512) return fft_seno_q15[512 - passo];
+  if (passo <= 768) return -fft_seno_q15[passo - 512];
+  return -fft_seno_q15[1024 - passo];
+}
+
+static inline int32_t fft_cosseno(uint32_t passo) {
+  return fft_seno(passo + 256);
+}
+
+// Aplica a janela de Hann, w[n] = (1 - cos(2 * pi * n / N)) / 2, derivada da
+// mesma tabela dos fatores de giro
+void fft_janela_hann(int16_t *x, int log2n) {
+  int n = 1 << log2n;
+  int passo = FFT_MAX_PONTOS >> log2n;
+
+  for (int i = 0; i < n; i++) {
+    int32_t w = (32768 - fft_cosseno(i * passo)) >> 1;
+    x[i] = (int16_t)((x[i] * w) >> 15);
+  }
+}
+
+// FFT radix-2 com dizimação no tempo: reordenação por bit reverso seguida de
+// log2n estágios de borboletas, cada um escalado por 1/2
+void fft_complexa(int16_t *re, int16_t *im, int log2n) {
+  int n = 1 << log2n;
+
+  for (int i = 1, j = 0; i < n; i++) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j |= bit;
+    if (i < j) {
+      int16_t t = re[i];
+      re[i] = re[j];
+      re[j] = t;
+      t = im[i];
+      im[i] = im[j];
+      im[j] = t;
+    }
+  }
+
+  for (int estagio = 1; estagio <= log2n; estagio++) {
+    int metade = 1 << (estagio - 1);
+    int passo = FFT_MAX_PONTOS >> estagio;  // Giro entre k e k + 1
+
+    for (int k = 0; k < metade; k++) {
+      int32_t wr = fft_cosseno(k * passo);
+      int32_t wi = -fft_seno(k * passo);
+
+      for (int i = k; i < n; i += 2 * metade) {
+        int j = i + metade;
+        int32_t tr = (wr * re[j] - wi * im[j]) >> 15;
+        int32_t ti = (wr * im[j] + wi * re[j]) >> 15;
+        int32_t ur = re[i], ui = im[i];
+
+        re[i] = (int16_t)((ur + tr) >> 1);
+        im[i] = (int16_t)((ui + ti) >> 1);
+        re[j] = (int16_t)((ur - tr) >> 1);
+        im[j] = (int16_t)((ui - ti) >> 1);
+      }
+    }
+  }
+}
+
+// Potência (re² + im²) das raias 0 a N/2 - 1
+void fft_potencia(const int16_t *re, const int16_t *im, int log2n,
+                  uint32_t *potencia) {
+  int metade = 1 << (log2n - 1);
+  for (int i = 0; i < metade; i++) {
+    potencia[i] = (uint32_t)(re[i] * re[i]) + (uint32_t)(im[i] * im[i]);
+  }
+}
@@ -0,0 +1,20 @@
+#include <stdint.h>
+
+#ifndef fft_inc_h
+#define fft_inc_h
+
+// FFT complexa radix-2 em ponto fixo (Q15), in-place, de 256 a 1024 pontos.
+// Cada estágio divide o resultado por 2 para não saturar, então a saída é a
+// DFT dividida por N. Os fatores de giro vêm de uma tabela em flash
+// (fft_tabela.h)
+
+#define FFT_LOG2_MIN 8
+#define FFT_LOG2_MAX 10
+#define FFT_MAX_PONTOS (1 << FFT_LOG2_MAX)
+
+extern void fft_janela_hann(int16_t *x, int log2n);
+extern void fft_complexa(int16_t *re, int16_t *im, int log2n);
+extern void fft_potencia(const int16_t *re, const int16_t *im, int log2n,
+                         uint32_t *potencia);
+
+#endif
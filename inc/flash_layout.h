@@ -0,0 +1,25 @@
+#include "hardware/flash.h"
+
+#ifndef flash_layout_inc_h
+#define flash_layout_inc_h
+
+// Mapa das regiões reservadas no fim da flash QSPI. O firmware ocupa o início
+// da flash; as regiões abaixo crescem do fim para o começo. Offsets são
+// relativos ao início da flash (para flash_range_*); para ler pela XIP some
+// XIP_BASE
+
+#define FLASH_TAMANHO PICO_FLASH_SIZE_BYTES
+
+// Calibração do microfone: último setor
+#define FLASH_CALIBRACAO_OFFSET (FLASH_TAMANHO - FLASH_SECTOR_SIZE)
+
+// Log de medições por minuto: anel de setores logo abaixo da calibração
+#define FLASH_LOG_TAMANHO (512 * 1024)
+#define FLASH_LOG_OFFSET (FLASH_CALIBRACAO_OFFSET - FLASH_LOG_TAMANHO)
+
+// Configurações do usuário: dois setores alternados abaixo do log
+#define FLASH_CONFIGURACOES_OFFSET (FLASH_LOG_OFFSET - 2 * FLASH_SECTOR_SIZE)
+
+#define FLASH_ENDERECO(offset) ((const void *)(XIP_BASE + (offset)))
+
+#endif
@@ -0,0 +1,72 @@
+#include "goertzel.h"
+
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Configura um detector por frequência para a taxa de amostragem informada
+void goertzel_iniciar(goertzel_banco_t *banco, const float *frequencias,
+                      int num, float taxa_hz) {
+  memset(banco, 0, sizeof(*banco));
+  banco->num = num > GOERTZEL_MAX ? GOERTZEL_MAX : num;
+
+  for (int i = 0; i < banco->num; i++) {
+    goertzel_detector_t *d = &banco->detector[i];
+    d->frequencia = frequencias[i];
+    d->coef = (int32_t)lroundf(2.0f * cosf(2.0f * M_PI * frequencias[i] /
+                                           taxa_hz) *
+                               (1 << GOERTZEL_Q));
+  }
+}
+
+// Roda todos os detectores sobre um bloco de n amostras sem DC. Para um tom
+// puro, 2 * |X|² / (n * energia) vale 1; a razão é a fração da energia do
+// bloco que está na frequência do detector
+void goertzel_processar(goertzel_banco_t *banco, const int16_t *x, int n) {
+  int64_t energia = 0;
+  for (int i = 0; i < n; i++) {
+    energia += (int32_t)x[i] * x[i];
+  }
+  bool audivel = energia >= (int64_t)GOERTZEL_ENERGIA_MIN * n;
+
+  for (int k = 0; k < banco->num; k++) {
+    goertzel_detector_t *d = &banco->detector[k];
+    int32_t s1 = 0, s2 = 0;
+
+    // Ressonador de segunda ordem; o produto pelo coeficiente usa 64 bits
+    // porque s1 cresce até ~n * amplitude / 2
+    for (int i = 0; i < n; i++) {
+      int32_t s = x[i] + (int32_t)(((int64_t)d->coef * s1) >> GOERTZEL_Q) - s2;
+      s2 = s1;
+      s1 = s;
+    }
+
+    float f1 = (float)s1, f2 = (float)s2;
+    float coef = (float)d->coef / (1 << GOERTZEL_Q);
+    float potencia = f1 * f1 + f2 * f2 - coef * f1 * f2;
+    d->razao = audivel ? 2.0f * potencia / ((float)n * (float)energia) : 0.0f;
+
+    if (d->razao >= GOERTZEL_RAZAO) {
+      if (d->consecutivos < GOERTZEL_BLOCOS_MIN) d->consecutivos++;
+      if (d->consecutivos == GOERTZEL_BLOCOS_MIN && !d->ativo) {
+        d->ativo = true;
+        d->ocorrencias++;
+      }
+    } else if (d->consecutivos > 0) {
+      // Libera aos poucos para tolerar um bloco ruim no meio do bipe
+      if (--d->consecutivos == 0) d->ativo = false;
+    }
+  }
+}
+
+// Soma das ocorrências de todos os detectores
+uint32_t goertzel_total(const goertzel_banco_t *banco) {
+  uint32_t total = 0;
+  for (int k = 0; k < banco->num; k++) {
+    total += banco->detector[k].ocorrencias;
+  }
+  return total;
+}
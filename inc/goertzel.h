@@ -0,0 +1,38 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef goertzel_inc_h
+#define goertzel_inc_h
+
+// Banco de detectores de Goertzel para bipes de equipamentos médicos em
+// frequências conhecidas. Cada bloco de aquisição passa por todos os
+// detectores; um tom só conta como ocorrência depois de presente em
+// blocos_min blocos seguidos, e a contagem é separada dos alertas de ruído
+
+#define GOERTZEL_MAX 8         // Detectores no banco
+#define GOERTZEL_Q 14          // Formato do coeficiente 2 * cos(w) (Q2.14)
+#define GOERTZEL_RAZAO 0.35f   // Fração mínima da energia do bloco no tom
+#define GOERTZEL_BLOCOS_MIN 6  // Blocos seguidos para confirmar o tom
+#define GOERTZEL_ENERGIA_MIN 4096  // Energia média mínima (contagens² << 4)
+
+typedef struct {
+  float frequencia;
+  int32_t coef;           // 2 * cos(2 * pi * f / taxa) em Q2.14
+  float razao;            // Fração da energia do último bloco neste tom
+  uint8_t consecutivos;   // Blocos seguidos acima do limiar
+  bool ativo;             // Tom sustentado presente
+  uint32_t ocorrencias;   // Tons sustentados detectados
+} goertzel_detector_t;
+
+typedef struct {
+  uint8_t num;
+  goertzel_detector_t detector[GOERTZEL_MAX];
+} goertzel_banco_t;
+
+extern void goertzel_iniciar(goertzel_banco_t *banco, const float *frequencias,
+                             int num, float taxa_hz);
+extern void goertzel_processar(goertzel_banco_t *banco, const int16_t *x,
+                               int n);
+extern uint32_t goertzel_total(const goertzel_banco_t *banco);
+
+#endif
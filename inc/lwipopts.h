@@ -0,0 +1,52 @@
+#include "relogio.h"
+
+#ifndef lwipopts_inc_h
+#define lwipopts_inc_h
+
+// Configuração do lwIP para o CYW43 em modo de varredura
+// (pico_cyw43_arch_lwip_poll): sem sistema operacional, toda a pilha roda
+// dentro de cyw43_arch_poll no laço principal do núcleo 0
+
+#define NO_SYS 1
+#define LWIP_SOCKET 0
+#define LWIP_NETCONN 0
+#define MEM_LIBC_MALLOC 0
+#define MEM_ALIGNMENT 4
+#define MEM_SIZE 8000
+#define MEMP_NUM_TCP_SEG 32
+#define MEMP_NUM_ARP_QUEUE 10
+#define PBUF_POOL_SIZE 24
+
+#define LWIP_ARP 1
+#define LWIP_ETHERNET 1
+#define LWIP_ICMP 1
+#define LWIP_RAW 1
+#define LWIP_IPV4 1
+#define LWIP_UDP 1
+#define LWIP_TCP 1
+#define LWIP_DHCP 1
+#define LWIP_DNS 1
+#define TCP_MSS 1460
+#define TCP_WND (8 * TCP_MSS)
+#define TCP_SND_BUF (8 * TCP_MSS)
+#define TCP_SND_QUEUELEN ((4 * (TCP_SND_BUF) + (TCP_MSS - 1)) / (TCP_MSS))
+#define LWIP_TCP_KEEPALIVE 1
+#define LWIP_NETIF_STATUS_CALLBACK 1
+#define LWIP_NETIF_LINK_CALLBACK 1
+#define LWIP_NETIF_HOSTNAME 1
+#define LWIP_NETIF_TX_SINGLE_PBUF 1
+#define DHCP_DOES_ARP_CHECK 0
+#define LWIP_DHCP_DOES_ACD_CHECK 0
+#define LWIP_CHKSUM_ALGORITHM 3
+
+// Hora do relógio por SNTP (pico_lwip_sntp), para as regras de alerta com
+// horário. O cliente usa um temporizador além dos internos do lwIP
+#define SNTP_SERVER_DNS 1
+#define SNTP_SET_SYSTEM_TIME(segundos) relogio_ajustar_utc(segundos)
+#define MEMP_NUM_SYS_TIMEOUT (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 1)
+
+#define LWIP_STATS 0
+#define LWIP_STATS_DISPLAY 0
+#define LWIP_DEBUG 0
+
+#endif
@@ -0,0 +1,199 @@
+#include "medicoes.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "flash_layout.h"
+#include "hardware/sync.h"
+
+// Log de medições em anel na região FLASH_LOG_OFFSET. Os registros são
+// comprimidos (codec_medicoes) num buffer de página na RAM, e cada página de
+// 256 bytes é programada uma única vez, já cheia; ao entrar num setor, ele é
+// apagado antes (o que descarta as páginas mais antigas). Como a escrita
+// percorre o anel inteiro, todos os setores se desgastam por igual. No boot,
+// a página de maior sequência válida indica onde o log continua.
+// Durante o apagamento e a programação a XIP fica suspensa e as interrupções
+// deste núcleo ficam desligadas; a aquisição roda no núcleo 1 a partir da
+// RAM e não é afetada
+
+#define PAGINAS_POR_SETOR (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
+#define PAGINAS_TOTAL MEDICOES_PAGINAS_TOTAL
+
+static_assert(CODEC_BLOCO_TAMANHO == FLASH_PAGE_SIZE,
+              "um bloco do codec por página da flash");
+
+static uint8_t buffer[2][FLASH_PAGE_SIZE] __attribute__((aligned(4)));
+static codec_escritor_t escritor[2];
+static uint8_t buffer_atual = 0;    // Índice da página em preenchimento
+static bool pagina_pronta = false;  // buffer[!buffer_atual] aguarda gravação
+
+static uint32_t proxima_pagina = 0;    // Página do anel a ser gravada
+static uint32_t proxima_sequencia = 0;
+static uint32_t pagina_antiga = 0;     // Página mais antiga do log
+static uint32_t paginas_usadas = 0;    // Páginas da mais antiga à recente
+static uint32_t registros_total = 0;   // Registros nas páginas válidas
+static uint16_t sessao = 0;
+
+static const uint8_t *pagina_flash(uint32_t pagina) {
+  return FLASH_ENDERECO(FLASH_LOG_OFFSET + pagina * FLASH_PAGE_SIZE);
+}
+
+// Registros de uma página do anel (0 se ela for inválida)
+static uint16_t pagina_quantidade(uint32_t pagina) {
+  codec_cabecalho_t cabecalho;
+  if (!codec_ler_cabecalho(pagina_flash(pagina), &cabecalho)) return 0;
+  return cabecalho.quantidade;
+}
+
+static bool pagina_apagada(const uint8_t *pagina) {
+  const uint32_t *palavras = (const uint32_t *)pagina;
+  for (size_t i = 0; i < FLASH_PAGE_SIZE / sizeof(uint32_t); i++) {
+    if (palavras[i] != 0xFFFFFFFFu) return false;
+  }
+  return true;
+}
+
+// Varre o anel e posiciona a escrita logo após a página mais recente. A
+// sessão é uma a mais que a da página mais recente
+void medicoes_iniciar(void) {
+  bool encontrou = false;
+  uint32_t maior = 0, menor = 0, pagina_maior = 0;
+  codec_cabecalho_t cabecalho, recente;
+
+  registros_total = 0;
+  for (uint32_t p = 0; p < PAGINAS_TOTAL; p++) {
+    if (!codec_ler_cabecalho(pagina_flash(p), &cabecalho)) continue;
+
+    registros_total += cabecalho.quantidade;
+    if (!encontrou || cabecalho.sequencia > maior) {
+      maior = cabecalho.sequencia;
+      pagina_maior = p;
+      recente = cabecalho;
+    }
+    if (!encontrou || cabecalho.sequencia < menor) {
+      menor = cabecalho.sequencia;
+      pagina_antiga = p;
+    }
+    encontrou = true;
+  }
+
+  if (encontrou) {
+    sessao = recente.sessao + 1;
+    paginas_usadas =
+        (pagina_maior + PAGINAS_TOTAL - pagina_antiga) % PAGINAS_TOTAL + 1;
+    proxima_sequencia = maior + 1;
+    proxima_pagina = (pagina_maior + 1) % PAGINAS_TOTAL;
+  }
+
+  buffer_atual = 0;
+  pagina_pronta = false;
+  codec_iniciar(&escritor[buffer_atual], buffer[buffer_atual]);
+}
+
+uint16_t medicoes_sessao(void) { return sessao; }
+
+// Comprime um registro no buffer na RAM. Quando ele não cabe mais, a página
+// fica pronta para medicoes_processar e o registro abre a página seguinte; se
+// a anterior ainda não foi gravada, ela é sobrescrita
+void medicoes_adicionar(const medicao_t *medicao) {
+  if (codec_adicionar(&escritor[buffer_atual], medicao)) return;
+
+  pagina_pronta = true;
+  buffer_atual = !buffer_atual;
+  codec_iniciar(&escritor[buffer_atual], buffer[buffer_atual]);
+  codec_adicionar(&escritor[buffer_atual], medicao);
+}
+
+// Grava a página pronta, se houver. Deve ser chamada no laço principal do
+// núcleo 0; o apagamento de um setor leva dezenas de milissegundos
+void medicoes_processar(void) {
+  if (!pagina_pronta) return;
+  codec_escritor_t *pronto = &escritor[!buffer_atual];
+
+  // Após um boot no meio de um setor, só continua nele se o restante estiver
+  // apagado; senão pula para o início do próximo (as páginas puladas ficam
+  // no log como inválidas)
+  while (proxima_pagina % PAGINAS_POR_SETOR != 0 &&
+         !pagina_apagada(pagina_flash(proxima_pagina))) {
+    uint32_t puladas =
+        PAGINAS_POR_SETOR - proxima_pagina % PAGINAS_POR_SETOR;
+    proxima_pagina = (proxima_pagina + puladas) % PAGINAS_TOTAL;
+    if (paginas_usadas > 0) paginas_usadas += puladas;
+  }
+
+  // Apagar o setor descarta as páginas mais antigas que estavam nele
+  bool apagar = proxima_pagina % PAGINAS_POR_SETOR == 0;
+  if (apagar) {
+    while (paginas_usadas > 0 &&
+           pagina_antiga / PAGINAS_POR_SETOR ==
+               proxima_pagina / PAGINAS_POR_SETOR) {
+      registros_total -= pagina_quantidade(pagina_antiga);
+      pagina_antiga = (pagina_antiga + 1) % PAGINAS_TOTAL;
+      paginas_usadas--;
+    }
+  }
+
+  codec_fechar(pronto, proxima_sequencia);
+
+  uint32_t offset = FLASH_LOG_OFFSET + proxima_pagina * FLASH_PAGE_SIZE;
+  uint32_t estado = save_and_disable_interrupts();
+  if (apagar) flash_range_erase(offset, FLASH_SECTOR_SIZE);
+  flash_range_program(offset, pronto->bloco, FLASH_PAGE_SIZE);
+  restore_interrupts(estado);
+
+  if (paginas_usadas == 0) pagina_antiga = proxima_pagina;
+  paginas_usadas++;
+  registros_total += pronto->quantidade;
+
+  proxima_sequencia++;
+  proxima_pagina = (proxima_pagina + 1) % PAGINAS_TOTAL;
+  pagina_pronta = false;
+}
+
+// Registros gravados na flash (não inclui os que ainda estão na RAM)
+uint32_t medicoes_total(void) { return registros_total; }
+
+// Páginas do log, da mais antiga à mais recente (inclui páginas inválidas)
+uint32_t medicoes_paginas(void) { return paginas_usadas; }
+
+// Descomprime a página de índice dado (0 é a mais antiga). Retorna quantos
+// registros foram lidos, ou -1 se o índice não existir ou a página for
+// inválida
+int medicoes_ler_pagina(uint32_t indice, medicao_t *registros, int max) {
+  if (indice >= paginas_usadas) return -1;
+  return codec_decodificar(
+      pagina_flash((pagina_antiga + indice) % PAGINAS_TOTAL), registros, max);
+}
+
+// Posição no anel da página mais antiga, para leitura direta com
+// medicoes_bloco. Páginas gravadas depois terão sequência a partir de
+// medicoes_proxima_sequencia
+uint32_t medicoes_pagina_antiga(void) { return pagina_antiga; }
+uint32_t medicoes_proxima_sequencia(void) { return proxima_sequencia; }
+
+// Bloco gravado numa posição do anel (sem conferência: use
+// codec_ler_cabecalho)
+const uint8_t *medicoes_bloco(uint32_t pagina) {
+  return pagina_flash(pagina % PAGINAS_TOTAL);
+}
+
+// Copia as páginas que ainda estão na RAM, já fechadas como blocos válidos e
+// na ordem em que serão gravadas. Retorna quantas foram copiadas
+int medicoes_pendentes(
+    uint8_t blocos[MEDICOES_PENDENTES_MAX][CODEC_BLOCO_TAMANHO]) {
+  int n = 0;
+  uint32_t sequencia = proxima_sequencia;
+  const codec_escritor_t *ordem[] = {
+      pagina_pronta ? &escritor[!buffer_atual] : NULL,
+      &escritor[buffer_atual]};
+
+  for (int i = 0; i < MEDICOES_PENDENTES_MAX; i++) {
+    if (ordem[i] == NULL || ordem[i]->quantidade == 0) continue;
+    codec_escritor_t copia = *ordem[i];
+    memcpy(blocos[n], copia.bloco, CODEC_BLOCO_TAMANHO);
+    copia.bloco = blocos[n++];
+    codec_fechar(&copia, sequencia++);
+  }
+  return n;
+}
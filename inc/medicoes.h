@@ -0,0 +1,29 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "codec_medicoes.h"
+#include "flash_layout.h"
+
+#ifndef medicoes_inc_h
+#define medicoes_inc_h
+
+// Páginas do anel (uma por bloco do codec)
+#define MEDICOES_PAGINAS_TOTAL (FLASH_LOG_TAMANHO / CODEC_BLOCO_TAMANHO)
+// Páginas ainda na RAM: a pronta para gravação e a em preenchimento
+#define MEDICOES_PENDENTES_MAX 2
+
+extern void medicoes_iniciar(void);
+extern uint16_t medicoes_sessao(void);
+extern void medicoes_adicionar(const medicao_t *medicao);
+extern void medicoes_processar(void);
+extern uint32_t medicoes_total(void);
+extern uint32_t medicoes_paginas(void);
+extern int medicoes_ler_pagina(uint32_t indice, medicao_t *registros,
+                               int max);
+extern uint32_t medicoes_pagina_antiga(void);
+extern uint32_t medicoes_proxima_sequencia(void);
+extern const uint8_t *medicoes_bloco(uint32_t pagina);
+extern int medicoes_pendentes(
+    uint8_t blocos[MEDICOES_PENDENTES_MAX][CODEC_BLOCO_TAMANHO]);
+
+#endif
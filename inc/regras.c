@@ -0,0 +1,146 @@
+#include "regras.h"
+
+#include <math.h>
+#include <string.h>
+
+#define MASCARA (REGRAS_ANEL - 1)
+_Static_assert((REGRAS_ANEL & MASCARA) == 0,
+               "REGRAS_ANEL precisa ser potência de 2");
+_Static_assert(REGRAS_ANEL > REGRAS_LEITURAS_MAX,
+               "o anel precisa de uma posição a mais que a maior janela");
+
+// Compila as definições para leituras de janela_ms. Regras que excedem
+// REGRAS_MAX ou REGRAS_METRICAS_MAX são ignoradas; janelas maiores que
+// REGRAS_LEITURAS_MAX leituras são encurtadas. Retorna as regras compiladas
+int regras_compilar(regras_t *regras, const regra_definicao_t *definicoes,
+                    int num, uint32_t janela_ms) {
+  memset(regras, 0, sizeof(*regras));
+  for (int i = 0; i < num && regras->num_regras < REGRAS_MAX; i++) {
+    const regra_definicao_t *d = &definicoes[i];
+    uint8_t metrica = REGRA_INSTANTANEA;
+
+    if (d->metrica != REGRA_INSTANTANEO) {
+      uint32_t leituras = (d->janela_s * 1000u + janela_ms / 2) / janela_ms;
+      if (leituras < 1) leituras = 1;
+      if (leituras > REGRAS_LEITURAS_MAX) leituras = REGRAS_LEITURAS_MAX;
+      for (metrica = 0; metrica < regras->num_metricas; metrica++) {
+        regras_metrica_t *m = &regras->metrica[metrica];
+        if (m->tipo == d->metrica && m->leituras == leituras) break;
+      }
+      if (metrica == regras->num_metricas) {
+        if (regras->num_metricas == REGRAS_METRICAS_MAX) continue;
+        regras->metrica[metrica].tipo = d->metrica;
+        regras->metrica[metrica].leituras = leituras;
+        regras->num_metricas++;
+      }
+    }
+
+    regra_t *r = &regras->regra[regras->num_regras++];
+    r->definicao = d;
+    r->metrica = metrica;
+    r->dia_todo = d->inicio_min == d->fim_min;
+    alarme_iniciar(&r->alarme, d->histerese_db, d->duracao_min_ms,
+                   d->retencao_ms, janela_ms);
+  }
+  return regras->num_regras;
+}
+
+// Atualiza uma métrica com a leitura de índice n (já gravada na fila de
+// energias). O Leq médio usa as leituras disponíveis enquanto a janela enche
+static void atualizar_metrica(regras_t *regras, regras_metrica_t *m,
+                              uint32_t n) {
+  float e = regras->energia[n & MASCARA];
+
+  if (m->tipo == REGRA_LEQ) {
+    if (n % m->leituras == 0) {
+      // Uma vez por janela refaz a soma, sem o erro acumulado das subtrações
+      m->energia = 0.0;
+      for (uint32_t k = 0; k < m->leituras && k <= n; k++) {
+        m->energia += regras->energia[(n - k) & MASCARA];
+      }
+    } else {
+      m->energia += e;
+      if (n >= m->leituras) {
+        m->energia -= regras->energia[(n - m->leituras) & MASCARA];
+      }
+    }
+    uint32_t presentes = n + 1 < m->leituras ? n + 1 : m->leituras;
+    m->valor_db = 10.0f * log10f((float)(m->energia / presentes));
+    return;
+  }
+
+  // Lmax: a fila guarda, em ordem de chegada, as leituras que ainda podem
+  // vir a ser o máximo da janela (energias decrescentes)
+  while (m->cauda != m->cabeca &&
+         regras->energia[m->fila[(m->cauda - 1) & MASCARA] & MASCARA] <= e) {
+    m->cauda--;
+  }
+  m->fila[m->cauda++ & MASCARA] = (uint16_t)n;
+  while ((uint16_t)((uint16_t)n - m->fila[m->cabeca & MASCARA]) >=
+         m->leituras) {
+    m->cabeca++;
+  }
+  m->valor_db =
+      10.0f * log10f(regras->energia[m->fila[m->cabeca & MASCARA] & MASCARA]);
+}
+
+static bool no_horario(const regra_t *r, int minuto_do_dia) {
+  if (r->dia_todo) return true;
+  if (minuto_do_dia < 0) return false;  // Relógio não sincronizado
+  uint16_t inicio = r->definicao->inicio_min, fim = r->definicao->fim_min;
+  return inicio < fim ? minuto_do_dia >= inicio && minuto_do_dia < fim
+                      : minuto_do_dia >= inicio || minuto_do_dia < fim;
+}
+
+// Avalia uma leitura em todas as regras. minuto_do_dia é a hora local em
+// minutos, ou -1 se desconhecida. Retorna a máscara das regras que
+// dispararam um evento e, em encerradas, a das que encerraram um
+uint32_t regras_avaliar(regras_t *regras, float db, float limite_ajustavel_db,
+                        int minuto_do_dia, uint32_t agora_ms,
+                        uint32_t *encerradas) {
+  uint32_t n = regras->leituras++;
+  regras->energia[n & MASCARA] = powf(10.0f, db / 10.0f);
+  for (int i = 0; i < regras->num_metricas; i++) {
+    atualizar_metrica(regras, &regras->metrica[i], n);
+  }
+
+  uint32_t disparadas = 0;
+  *encerradas = 0;
+  for (int i = 0; i < regras->num_regras; i++) {
+    regra_t *r = &regras->regra[i];
+    r->valor_db = r->metrica == REGRA_INSTANTANEA
+                      ? db
+                      : regras->metrica[r->metrica].valor_db;
+    r->limite_db = r->definicao->limite_db == REGRA_LIMITE_AJUSTAVEL
+                       ? limite_ajustavel_db
+                       : r->definicao->limite_db;
+
+    alarme_transicao_t t =
+        no_horario(r, minuto_do_dia)
+            ? alarme_avaliar(&r->alarme, r->valor_db, r->limite_db, agora_ms)
+            : alarme_cancelar(&r->alarme);
+    if (t == ALARME_DISPAROU) disparadas |= 1u << i;
+    if (t == ALARME_ENCERROU) *encerradas |= 1u << i;
+  }
+  return disparadas;
+}
+
+// Encerra os eventos de todas as regras (fora dos modos de monitoramento).
+// Retorna a máscara das regras que encerraram um evento
+uint32_t regras_cancelar(regras_t *regras) {
+  uint32_t encerradas = 0;
+  for (int i = 0; i < regras->num_regras; i++) {
+    if (alarme_cancelar(&regras->regra[i].alarme) == ALARME_ENCERROU) {
+      encerradas |= 1u << i;
+    }
+  }
+  return encerradas;
+}
+
+// Regra de maior prioridade com alarme ativo, ou NULL
+const regra_t *regras_ativa(const regras_t *regras) {
+  for (int i = 0; i < regras->num_regras; i++) {
+    if (alarme_ativo(&regras->regra[i].alarme)) return &regras->regra[i];
+  }
+  return NULL;
+}
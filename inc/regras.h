@@ -0,0 +1,94 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "alarme.h"
+
+#ifndef regras_inc_h
+#define regras_inc_h
+
+// Regras de alerta: cada uma compara uma métrica do nível (a leitura
+// instantânea, o Leq ou o Lmax de uma janela deslizante de N segundos) com um
+// limite, numa faixa de horário local, e tem sua própria máquina de estados
+// de alarme (inc/alarme.h). A tabela de definições é compilada uma vez numa
+// tabela plana: métricas iguais (tipo e janela) são calculadas uma só vez e
+// cada leitura atualiza todas em tempo constante (soma móvel de energia para
+// o Leq, fila monotônica para o Lmax). A ordem da tabela é a prioridade: o
+// aviso na tela e o padrão do buzzer são os da primeira regra ativa
+
+#define REGRAS_MAX 8
+#define REGRAS_METRICAS_MAX 4   // Pares (Leq ou Lmax, janela) distintos
+// Maior janela em leituras (quase 128 s com leituras de 125 ms). Os anéis de
+// energias e das filas do Lmax têm REGRAS_ANEL posições: a leitura nova é
+// gravada antes de a mais antiga da janela sair, então o anel precisa de uma
+// posição a mais que a janela
+#define REGRAS_LEITURAS_MAX 1023
+#define REGRAS_ANEL 1024  // Potência de 2 maior que REGRAS_LEITURAS_MAX
+#define REGRA_LIMITE_AJUSTAVEL (-1.0f)  // Usa o limite ajustado pelos botões
+#define REGRA_INSTANTANEA 0xFF          // Regra sem métrica de janela
+
+typedef enum { REGRA_INSTANTANEO, REGRA_LEQ, REGRA_LMAX } regra_metrica_t;
+
+// Padrão do buzzer de cada regra
+typedef enum {
+  REGRA_BUZZER_CONTINUO,
+  REGRA_BUZZER_LENTO,     // Bipes longos
+  REGRA_BUZZER_RAPIDO,    // Bipes curtos e rápidos
+  REGRA_BUZZER_SIRENE,    // Varredura de frequência subindo e descendo
+  REGRA_BUZZER_URGENCIA   // Bipes cada vez mais próximos
+} regra_buzzer_t;
+
+// Definição de uma regra. O horário é [inicio_min, fim_min) em minutos do dia
+// local e pode cruzar a meia-noite; inicio_min == fim_min vale o dia todo.
+// Regras com horário só valem com o relógio sincronizado
+typedef struct {
+  const char *nome;  // Mostrado no aviso (até 12 caracteres)
+  regra_metrica_t metrica;
+  uint16_t janela_s;  // Leq e Lmax
+  float limite_db;    // Ou REGRA_LIMITE_AJUSTAVEL
+  uint16_t inicio_min;
+  uint16_t fim_min;
+  float histerese_db;
+  uint32_t duracao_min_ms;
+  uint32_t retencao_ms;
+  regra_buzzer_t buzzer;
+} regra_definicao_t;
+
+// Métrica de janela compilada
+typedef struct {
+  regra_metrica_t tipo;
+  uint16_t leituras;    // Tamanho da janela em leituras
+  double energia;       // Leq: soma das energias da janela
+  uint16_t fila[REGRAS_ANEL];  // Lmax: leituras candidatas a máximo
+  uint16_t cabeca, cauda;
+  float valor_db;
+} regras_metrica_t;
+
+// Regra compilada
+typedef struct {
+  const regra_definicao_t *definicao;
+  uint8_t metrica;  // Índice da métrica ou REGRA_INSTANTANEA
+  bool dia_todo;
+  float valor_db;   // Métrica da última leitura
+  float limite_db;  // Limite da última leitura
+  alarme_t alarme;
+} regra_t;
+
+typedef struct {
+  uint8_t num_regras;
+  uint8_t num_metricas;
+  regra_t regra[REGRAS_MAX];
+  regras_metrica_t metrica[REGRAS_METRICAS_MAX];
+  float energia[REGRAS_ANEL];  // Energia das últimas leituras
+  uint32_t leituras;           // Leituras avaliadas
+} regras_t;
+
+extern int regras_compilar(regras_t *regras,
+                           const regra_definicao_t *definicoes, int num,
+                           uint32_t janela_ms);
+extern uint32_t regras_avaliar(regras_t *regras, float db,
+                               float limite_ajustavel_db, int minuto_do_dia,
+                               uint32_t agora_ms, uint32_t *encerradas);
+extern uint32_t regras_cancelar(regras_t *regras);
+extern const regra_t *regras_ativa(const regras_t *regras);
+
+#endif
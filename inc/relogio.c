@@ -0,0 +1,23 @@
+#include "relogio.h"
+
+#include "pico/stdlib.h"
+
+static bool sincronizado = false;
+static uint64_t referencia_utc_us = 0;  // UTC no boot (us desde 1970)
+
+// Chamada pelo SNTP com os segundos UNIX recebidos do servidor
+void relogio_ajustar_utc(uint32_t segundos) {
+  referencia_utc_us = (uint64_t)segundos * 1000000u - time_us_64();
+  sincronizado = true;
+}
+
+bool relogio_sincronizado(void) { return sincronizado; }
+
+// Minutos desde a meia-noite local, ou -1 sem sincronização
+int relogio_minuto_do_dia(void) {
+  if (!sincronizado) return -1;
+  int64_t minutos = (int64_t)((referencia_utc_us + time_us_64()) / 60000000u) +
+                    FUSO_HORARIO_MIN;
+  int minuto = (int)(minutos % 1440);
+  return minuto < 0 ? minuto + 1440 : minuto;
+}
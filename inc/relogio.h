@@ -0,0 +1,21 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef relogio_inc_h
+#define relogio_inc_h
+
+// Hora local do medidor. O RP2040 não tem relógio com bateria: a hora chega
+// pelo SNTP quando o Wi-Fi conecta (o lwIP chama relogio_ajustar_utc, ver
+// lwipopts.h) e segue pelo timer do sistema entre as sincronizações. Antes
+// da primeira sincronização a hora é desconhecida
+
+// Deslocamento da hora local para UTC, definido na compilação
+#ifndef FUSO_HORARIO_MIN
+#define FUSO_HORARIO_MIN (-180)
+#endif
+
+extern void relogio_ajustar_utc(uint32_t segundos);
+extern bool relogio_sincronizado(void);
+extern int relogio_minuto_do_dia(void);
+
+#endif
@@ -0,0 +1,330 @@
+#include "servidor_http.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lwip/tcp.h"
+#include "pico/stdlib.h"
+#include "telemetria.h"
+
+// Servidor HTTP mínimo sobre a API raw do lwIP, para painéis que consultam
+// vários medidores:
+//   GET /level    nível da última janela
+//   GET /stats    Leq, Lmax e alertas desde o boot
+//   GET /history  histórico do gráfico (uma leitura por janela)
+// Cada conexão atende um pedido e é fechada (Connection: close).
+//
+// O corpo de cada recurso fica num buffer pré-formatado, refeito só quando
+// alguém pede e os dados mudaram desde a última formatação; pedidos seguidos
+// entre duas janelas reaproveitam o mesmo texto. O cabeçalho fixo e o corpo
+// são copiados para a fila de envio (TCP_WRITE_FLAG_COPY): com
+// LWIP_NETIF_TX_SINGLE_PBUF o tcp_write copia os dados de qualquer forma,
+// então o buffer pode ser reformatado logo depois. Tudo roda nos callbacks
+// do lwIP, dentro de telemetria_processar, sem bloquear o laço principal
+
+#define CORPO_MAX 1024   // Maior corpo (histórico de 128 leituras)
+#define RESERVA 32       // Espaço antes do corpo para o Content-Length
+#define PEDIDO_MAX 64    // Basta a primeira linha do pedido
+#define OCIOSA_MAX 3     // Intervalos de poll (2 s) sem pedido completo
+
+typedef enum { NIVEL, ESTATISTICAS, HISTORICO, RECURSOS } recurso_t;
+
+typedef struct {
+  char dados[RESERVA + CORPO_MAX];
+  const char *inicio;    // "Content-Length: n\r\n\r\n" seguido do corpo
+  uint16_t tamanho;
+  uint32_t versao;       // versao_dados usada na formatação (0: nenhuma)
+} resposta_t;
+
+typedef struct {
+  struct tcp_pcb *pcb;   // NULL: conexão livre
+  uint32_t pendente;     // Bytes escritos e ainda não confirmados
+  char pedido[PEDIDO_MAX];
+  uint8_t recebido;
+  uint8_t ociosa;
+  bool respondida;
+} conexao_t;
+
+static const char cabecalho_ok[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Cache-Control: no-store\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Connection: close\r\n";
+static const char resposta_404[] =
+    "HTTP/1.1 404 Not Found\r\n"
+    "Connection: close\r\n"
+    "Content-Length: 0\r\n\r\n";
+static const char resposta_405[] =
+    "HTTP/1.1 405 Method Not Allowed\r\n"
+    "Allow: GET\r\n"
+    "Connection: close\r\n"
+    "Content-Length: 0\r\n\r\n";
+
+static const char *caminhos[RECURSOS] = {"/level", "/stats", "/history"};
+
+static resposta_t respostas[RECURSOS];
+static conexao_t conexoes[SERVIDOR_HTTP_CONEXOES];
+static uint32_t versao_dados = 1;
+static uint32_t atendidas = 0;
+
+// Dados publicados
+static uint16_t sessao = 0;
+static const float *historico = NULL;
+static int tamanho_historico = 0;
+static const uint8_t *indice_historico = NULL;
+static uint32_t janela_ms = 0;
+static float nivel_db = 0.0f;
+static uint32_t instante_ms = 0;
+static double energia = 0.0;
+static uint32_t janelas = 0;
+static float lmax_db = 0.0f;
+static unsigned int alertas_total = 0;
+
+// --------------------------------------------------------------------------
+// Dados e formatação
+// --------------------------------------------------------------------------
+
+// Registra uma janela de medição: último nível, acumulação do Leq e do Lmax
+// desde o boot e o contador de alertas. Só marca os dados como novos; a
+// formatação fica para o próximo pedido
+void servidor_http_janela(float db, unsigned int alertas) {
+  nivel_db = db;
+  instante_ms = to_ms_since_boot(get_absolute_time());
+  energia += powf(10.0f, db / 10.0f);
+  janelas++;
+  lmax_db = fmaxf(lmax_db, db);
+  alertas_total = alertas;
+  versao_dados++;
+}
+
+static int formatar_nivel(char *corpo, size_t tamanho) {
+  return snprintf(corpo, tamanho, "{\"db\":%.1f,\"instante_ms\":%lu}",
+                  nivel_db, (unsigned long)instante_ms);
+}
+
+static int formatar_estatisticas(char *corpo, size_t tamanho) {
+  float leq = janelas ? 10.0f * log10f((float)(energia / janelas)) : 0.0f;
+  return snprintf(corpo, tamanho,
+                  "{\"sessao\":%u,\"segundos\":%lu,\"janelas\":%lu,"
+                  "\"leq_db\":%.1f,\"lmax_db\":%.1f,\"alertas\":%u}",
+                  sessao, (unsigned long)(instante_ms / 1000),
+                  (unsigned long)janelas, leq, lmax_db, alertas_total);
+}
+
+// Histórico da mais antiga à mais recente leitura
+static int formatar_historico(char *corpo, size_t tamanho) {
+  int n = snprintf(corpo, tamanho, "{\"janela_ms\":%lu,\"db\":[",
+                   (unsigned long)janela_ms);
+  for (int i = 0; i < tamanho_historico && n < (int)tamanho; i++) {
+    float db = historico[(*indice_historico + i) % tamanho_historico];
+    n += snprintf(corpo + n, tamanho - n, "%s%.1f", i ? "," : "", db);
+  }
+  if (n < (int)tamanho) n += snprintf(corpo + n, tamanho - n, "]}");
+  return n;
+}
+
+static void formatar(recurso_t recurso, resposta_t *resposta) {
+  char *corpo = resposta->dados + RESERVA;
+  int n;
+  switch (recurso) {
+    case NIVEL: n = formatar_nivel(corpo, CORPO_MAX); break;
+    case ESTATISTICAS: n = formatar_estatisticas(corpo, CORPO_MAX); break;
+    default: n = formatar_historico(corpo, CORPO_MAX); break;
+  }
+  if (n >= CORPO_MAX) n = CORPO_MAX - 1;
+
+  // O Content-Length vai logo antes do corpo, no espaço reservado
+  char comprimento[RESERVA];
+  int c = snprintf(comprimento, sizeof(comprimento),
+                   "Content-Length: %d\r\n\r\n", n);
+  memcpy(corpo - c, comprimento, c);
+  resposta->inicio = corpo - c;
+  resposta->tamanho = (uint16_t)(c + n);
+  resposta->versao = versao_dados;
+}
+
+// Texto atual do recurso, formatado de novo só se os dados mudaram
+static const resposta_t *obter_resposta(recurso_t recurso) {
+  resposta_t *resposta = &respostas[recurso];
+  if (resposta->versao != versao_dados) formatar(recurso, resposta);
+  return resposta;
+}
+
+// --------------------------------------------------------------------------
+// Conexões
+// --------------------------------------------------------------------------
+
+static void liberar(conexao_t *c) { memset(c, 0, sizeof(*c)); }
+
+static void desligar_callbacks(struct tcp_pcb *pcb) {
+  tcp_arg(pcb, NULL);
+  tcp_recv(pcb, NULL);
+  tcp_sent(pcb, NULL);
+  tcp_err(pcb, NULL);
+  tcp_poll(pcb, NULL, 0);
+}
+
+// Fecha a conexão; retorna ERR_ABRT se foi preciso abortá-la
+static err_t fechar(conexao_t *c) {
+  struct tcp_pcb *pcb = c->pcb;
+  err_t resultado = ERR_OK;
+  desligar_callbacks(pcb);
+  if (tcp_close(pcb) != ERR_OK) {
+    tcp_abort(pcb);
+    resultado = ERR_ABRT;
+  }
+  liberar(c);
+  return resultado;
+}
+
+static err_t abortar(conexao_t *c) {
+  desligar_callbacks(c->pcb);
+  tcp_abort(c->pcb);
+  liberar(c);
+  return ERR_ABRT;
+}
+
+// Enfileira a resposta: cabeçalho fixo + texto do recurso, ou uma resposta
+// fixa de erro
+static err_t responder(conexao_t *c) {
+  const char *fixa = NULL;
+  recurso_t recurso = RECURSOS;
+  c->respondida = true;
+
+  if (strncmp(c->pedido, "GET ", 4) != 0) {
+    fixa = resposta_405;
+  } else {
+    const char *caminho = c->pedido + 4;
+    size_t n = strcspn(caminho, " ?\r");
+    for (int i = 0; i < RECURSOS; i++) {
+      if (strlen(caminhos[i]) == n && strncmp(caminho, caminhos[i], n) == 0) {
+        recurso = (recurso_t)i;
+      }
+    }
+    if (recurso == RECURSOS) fixa = resposta_404;
+  }
+
+  err_t erro;
+  if (fixa != NULL) {
+    c->pendente = strlen(fixa);
+    erro = tcp_write(c->pcb, fixa, c->pendente, TCP_WRITE_FLAG_COPY);
+  } else {
+    const resposta_t *resposta = obter_resposta(recurso);
+    c->pendente = sizeof(cabecalho_ok) - 1 + resposta->tamanho;
+    erro = tcp_write(c->pcb, cabecalho_ok, sizeof(cabecalho_ok) - 1,
+                     TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
+    if (erro == ERR_OK) {
+      erro = tcp_write(c->pcb, resposta->inicio, resposta->tamanho,
+                       TCP_WRITE_FLAG_COPY);
+    }
+  }
+  if (erro != ERR_OK) return abortar(c);  // Sem espaço na fila de envio
+  atendidas++;
+  tcp_output(c->pcb);
+  return ERR_OK;
+}
+
+static err_t ao_receber(void *arg, struct tcp_pcb *pcb, struct pbuf *p,
+                        err_t erro) {
+  conexao_t *c = arg;
+  if (p == NULL) return fechar(c);  // Cliente fechou
+  if (erro != ERR_OK) {
+    pbuf_free(p);
+    return erro;
+  }
+
+  if (!c->respondida) {
+    uint16_t espaco = PEDIDO_MAX - 1 - c->recebido;
+    c->recebido += pbuf_copy_partial(p, c->pedido + c->recebido, espaco, 0);
+    c->pedido[c->recebido] = '\0';
+  }
+  tcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  c->ociosa = 0;
+
+  // Responde quando a primeira linha chega inteira (ou não cabe no buffer)
+  if (!c->respondida &&
+      (strchr(c->pedido, '\n') != NULL || c->recebido == PEDIDO_MAX - 1)) {
+    return responder(c);
+  }
+  return ERR_OK;
+}
+
+static err_t ao_enviar(void *arg, struct tcp_pcb *pcb, u16_t confirmados) {
+  conexao_t *c = arg;
+  (void)pcb;
+  c->pendente -= confirmados < c->pendente ? confirmados : c->pendente;
+  if (c->respondida && c->pendente == 0) return fechar(c);
+  return ERR_OK;
+}
+
+// Conexão desfeita pelo lwIP (reset, falta de memória): o pcb já não existe
+static void ao_errar(void *arg, err_t erro) {
+  conexao_t *c = arg;
+  (void)erro;
+  if (c != NULL) liberar(c);
+}
+
+// Fecha conexões paradas: cliente que não completa o pedido ou não confirma
+static err_t ao_verificar(void *arg, struct tcp_pcb *pcb) {
+  conexao_t *c = arg;
+  (void)pcb;
+  if (++c->ociosa >= OCIOSA_MAX) return abortar(c);
+  return ERR_OK;
+}
+
+static err_t ao_aceitar(void *arg, struct tcp_pcb *pcb, err_t erro) {
+  (void)arg;
+  if (erro != ERR_OK || pcb == NULL) return ERR_VAL;
+
+  conexao_t *c = NULL;
+  for (int i = 0; i < SERVIDOR_HTTP_CONEXOES && c == NULL; i++) {
+    if (conexoes[i].pcb == NULL) c = &conexoes[i];
+  }
+  if (c == NULL) {
+    tcp_abort(pcb);  // Todas ocupadas: o cliente tenta de novo
+    return ERR_ABRT;
+  }
+
+  c->pcb = pcb;
+  tcp_arg(pcb, c);
+  tcp_recv(pcb, ao_receber);
+  tcp_sent(pcb, ao_enviar);
+  tcp_err(pcb, ao_errar);
+  tcp_poll(pcb, ao_verificar, 4);  // A cada 2 s
+  tcp_nagle_disable(pcb);
+  return ERR_OK;
+}
+
+// Começa a escutar na porta SERVIDOR_HTTP_PORTA. Só tem efeito com o rádio
+// ligado (telemetria_iniciar já chamada). historico e indice_historico são
+// lidos na formatação de /history, sem cópia
+void servidor_http_iniciar(uint16_t sessao_log, const float *historico_db,
+                           int tamanho, const uint8_t *indice,
+                           uint32_t janela) {
+  sessao = sessao_log;
+  historico = historico_db;
+  tamanho_historico = tamanho;
+  indice_historico = indice;
+  janela_ms = janela;
+
+  if (!telemetria_ligada()) return;
+  struct tcp_pcb *pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+  if (pcb == NULL) return;
+  if (tcp_bind(pcb, IP_ANY_TYPE, SERVIDOR_HTTP_PORTA) != ERR_OK) {
+    tcp_abort(pcb);
+    return;
+  }
+  struct tcp_pcb *escuta =
+      tcp_listen_with_backlog(pcb, SERVIDOR_HTTP_CONEXOES);
+  if (escuta == NULL) {
+    tcp_abort(pcb);
+    return;
+  }
+  tcp_accept(escuta, ao_aceitar);
+}
+
+// Pedidos atendidos com resposta (inclusive 404/405) desde o boot
+uint32_t servidor_http_respostas(void) { return atendidas; }
@@ -0,0 +1,17 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef servidor_http_inc_h
+#define servidor_http_inc_h
+
+#define SERVIDOR_HTTP_PORTA 80
+#define SERVIDOR_HTTP_CONEXOES 8  // Conexões simultâneas atendidas
+
+extern void servidor_http_iniciar(uint16_t sessao, const float *historico,
+                                  int tamanho_historico,
+                                  const uint8_t *indice_historico,
+                                  uint32_t janela_ms);
+extern void servidor_http_janela(float db, unsigned int alertas);
+extern uint32_t servidor_http_respostas(void);
+
+#endif
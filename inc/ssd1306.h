@@ -1,25 +1,34 @@
-#include "ssd1306_i2c.h"
+#ifndef ssd1306_h
+#define ssd1306_h
 
-extern struct render_area area_total;
+#include "ssd1306_i2c.h"
 
-extern void calculate_render_area_buffer_length(struct render_area *area);
-extern void ssd1306_send_command(uint8_t cmd);
-extern void ssd1306_send_command_list(uint8_t *ssd, int number);
-extern void ssd1306_send_buffer(uint8_t ssd[], int buffer_length);
-extern void ssd1306_init();
-extern void ssd1306_scroll(bool set);
-extern void render_on_display(uint8_t *ssd, struct render_area *area);
-extern void ssd1306_set_pixel(uint8_t *ssd, int x, int y, bool set);
-extern void ssd1306_draw_line(uint8_t *ssd, int x_0, int y_0, int x_1, int y_1,
-                              bool set);
-extern void ssd1306_draw_char(uint8_t *ssd, int16_t x, int16_t y,
-                              uint8_t character);
-extern void ssd1306_draw_string(uint8_t *ssd, int16_t x, int16_t y,
-                                char *string);
-extern void ssd1306_command(ssd1306_t *ssd, uint8_t command);
+extern bool ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height,
+                         bool external_vcc, uint8_t address, i2c_inst_t *i2c);
+extern void ssd1306_deinit(ssd1306_t *ssd);
 extern void ssd1306_config(ssd1306_t *ssd);
-extern void ssd1306_init_bm(ssd1306_t *ssd, uint8_t width, uint8_t height,
-                            bool external_vcc, uint8_t address,
-                            i2c_inst_t *i2c);
+extern void ssd1306_command(ssd1306_t *ssd, uint8_t command);
+extern void ssd1306_command_list(ssd1306_t *ssd, const uint8_t *commands,
+                                 size_t number);
+extern void ssd1306_scroll(ssd1306_t *ssd, bool set);
 extern void ssd1306_send_data(ssd1306_t *ssd);
-extern void ssd1306_draw_bitmap(ssd1306_t *ssd, const uint8_t *bitmap);
\ No newline at end of file
+extern void ssd1306_send_region(ssd1306_t *ssd, uint8_t start_column,
+                                uint8_t end_column, uint8_t start_page,
+                                uint8_t end_page);
+extern void ssd1306_reset_stats(ssd1306_t *ssd);
+extern bool ssd1306_calibrate_i2c(ssd1306_t *ssd, uint32_t min_khz,
+                                  uint32_t max_khz, uint32_t step_khz,
+                                  ssd1306_i2c_calibration_t *result);
+extern void ssd1306_clear(ssd1306_t *ssd);
+extern void ssd1306_set_pixel(ssd1306_t *ssd, int x, int y, bool set);
+extern void ssd1306_draw_line(ssd1306_t *ssd, int x_0, int y_0, int x_1,
+                              int y_1, bool set);
+extern void ssd1306_draw_char(ssd1306_t *ssd, int16_t x, int16_t y,
+                              uint8_t character);
+extern void ssd1306_draw_string(ssd1306_t *ssd, int16_t x, int16_t y,
+                                const char *string);
+extern void ssd1306_draw_bitmap(ssd1306_t *ssd, const uint8_t *bitmap);
+extern void ssd1306_blit_bitmap(ssd1306_t *ssd, const uint8_t *bitmap, int x,
+                                int page, int width, int pages);
+
+#endif
@@ -0,0 +1,82 @@
+#include "ssd1306_governor.h"
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "ssd1306.h"
+
+// Hash FNV-1a de 32 bits de uma página do framebuffer
+static uint32_t ssd1306_page_hash(const uint8_t *page, int width) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < width; i++) {
+    hash = (hash ^ page[i]) * 16777619u;
+  }
+  return hash;
+}
+
+// Configura o governador. min_ms é o intervalo usado enquanto o conteúdo é
+// urgente ou muda por inteiro, max_ms o intervalo em regime estável
+void ssd1306_governor_init(ssd1306_governor_t *gov, uint32_t min_ms,
+                           uint32_t max_ms, uint8_t busy_max_percent) {
+  memset(gov, 0, sizeof(*gov));
+  gov->min_interval_us = min_ms * 1000;
+  gov->max_interval_us = max_ms * 1000;
+  gov->busy_max_percent = busy_max_percent ? busy_max_percent : 100;
+  gov->interval_us = gov->min_interval_us;
+}
+
+// Avalia o framebuffer atual e envia ao display apenas as páginas alteradas,
+// se o intervalo adaptativo e o orçamento de tempo permitirem. urgent força o
+// intervalo mínimo (ex.: faixa de alerta piscando). Retorna true se enviou
+bool ssd1306_governor_update(ssd1306_governor_t *gov, ssd1306_t *ssd,
+                             bool urgent) {
+  int pages = ssd->pages;
+  if (pages > ssd1306_governor_max_pages) {
+    pages = ssd1306_governor_max_pages;
+  }
+
+  uint32_t hash[ssd1306_governor_max_pages];
+  int first = -1, last = -1, changed = 0;
+  for (int p = 0; p < pages; p++) {
+    hash[p] = ssd1306_page_hash(ssd1306_framebuffer(ssd) + p * ssd->width,
+                                ssd->width);
+    if (!gov->primed || hash[p] != gov->page_hash[p]) {
+      if (first < 0) first = p;
+      last = p;
+      changed++;
+    }
+  }
+  gov->changed_pages = changed;
+
+  if (changed == 0) {
+    gov->skipped_identical++;
+    return false;
+  }
+
+  // Quanto mais páginas mudam, mais perto do intervalo mínimo
+  uint32_t span = gov->max_interval_us - gov->min_interval_us;
+  uint32_t target = urgent ? gov->min_interval_us
+                           : gov->max_interval_us - span * changed / pages;
+
+  // Orçamento: envio / intervalo <= busy_max_percent
+  uint32_t budget = gov->avg_flush_us * 100 / gov->busy_max_percent;
+  gov->interval_us = target > budget ? target : budget;
+
+  uint64_t now = time_us_64();
+  if (gov->primed && now - gov->last_flush_us < gov->interval_us) {
+    gov->deferred++;
+    return false;
+  }
+
+  ssd1306_send_region(ssd, 0, ssd->width - 1, first, last);
+
+  uint32_t flush_us = ssd->stats.last_flush_us;
+  gov->avg_flush_us = gov->avg_flush_us
+                          ? (gov->avg_flush_us * 7 + flush_us) / 8
+                          : flush_us;
+  gov->last_flush_us = now;
+  memcpy(gov->page_hash, hash, sizeof(hash[0]) * pages);
+  gov->primed = true;
+  gov->flushed++;
+  return true;
+}
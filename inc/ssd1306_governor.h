@@ -0,0 +1,38 @@
+#include "ssd1306_i2c.h"
+
+#ifndef ssd1306_governor_inc_h
+#define ssd1306_governor_inc_h
+
+#define ssd1306_governor_min_ms 33    // Intervalo mínimo (conteúdo urgente)
+#define ssd1306_governor_max_ms 500   // Intervalo em monitoramento estável
+#define ssd1306_governor_busy_max 30  // Parcela máxima (%) do tempo em envios
+
+#define ssd1306_governor_max_pages (64 / ssd1306_page_height)
+
+// Controla quando o framebuffer de uma instância é enviado ao display: quadros
+// idênticos ao que já está no painel não são enviados, a taxa de atualização
+// se adapta à quantidade de páginas alteradas e o tempo gasto em envios nunca
+// passa de busy_max_percent do tempo total
+typedef struct {
+  uint32_t min_interval_us;
+  uint32_t max_interval_us;
+  uint8_t busy_max_percent;
+
+  uint32_t page_hash[ssd1306_governor_max_pages];  // Conteúdo no painel
+  bool primed;                // Já houve um envio (page_hash é válido)
+  uint32_t interval_us;       // Intervalo atual entre envios
+  uint32_t avg_flush_us;      // Média móvel da duração dos envios
+  uint64_t last_flush_us;     // Instante do último envio
+  uint8_t changed_pages;      // Páginas alteradas na última avaliação
+
+  uint32_t flushed;           // Envios realizados
+  uint32_t skipped_identical; // Quadros descartados por serem idênticos
+  uint32_t deferred;          // Quadros adiados pelo intervalo ou orçamento
+} ssd1306_governor_t;
+
+extern void ssd1306_governor_init(ssd1306_governor_t *gov, uint32_t min_ms,
+                                  uint32_t max_ms, uint8_t busy_max_percent);
+extern bool ssd1306_governor_update(ssd1306_governor_t *gov, ssd1306_t *ssd,
+                                    bool urgent);
+
+#endif
@@ -1,4 +1,4 @@
-#include "ssd1306_i2c.h"
+#include "ssd1306.h"
 
 #include <ctype.h>
 #include <stdio.h>
@@ -10,66 +10,89 @@
 #include "pico/stdlib.h"
 #include "ssd1306_font.h"
 
-// Calcular quanto do buffer será destinado à área de renderização
-void calculate_render_area_buffer_length(struct render_area *area) {
-  area->buffer_length = (area->end_column - area->start_column + 1) *
-                        (area->end_page - area->start_page + 1);
+// Toda escrita no barramento passa por aqui para manter as estatísticas da
+// instância. i2c_write_timeout_us devolve o número de bytes escritos,
+// PICO_ERROR_GENERIC quando o endereço não recebe ACK ou PICO_ERROR_TIMEOUT
+// quando a transação não termina no prazo (barramento preso, painel travado):
+// o limite é o tempo de len bytes a 100 kHz, com o dobro de folga, então um
+// barramento com defeito nunca trava a calibração nem o laço principal
+static bool ssd1306_write(ssd1306_t *ssd, const uint8_t *buffer, size_t len) {
+  uint timeout_us = 1000 + len * 9 * 10 * 2;  // 9 bits por byte, 10 us cada
+  int written = i2c_write_timeout_us(ssd->i2c_port, ssd->address, buffer, len,
+                                     false, timeout_us);
+  ssd->stats.transactions++;
+  if (written != (int)len) {
+    ssd->stats.errors++;
+    return false;
+  }
+  ssd->stats.bytes += len;
+  return true;
 }
 
-// Processo de escrita do i2c espera um byte de controle, seguido por dados
-void ssd1306_send_command(uint8_t command) {
-  uint8_t buffer[2] = {0x80, command};
-  i2c_write_blocking(i2c1, ssd1306_i2c_address, buffer, 2, false);
+// Contabiliza a duração de um envio iniciado em start
+static void ssd1306_account_flush(ssd1306_t *ssd, uint32_t start) {
+  uint32_t elapsed = time_us_32() - start;
+  ssd->stats.last_flush_us = elapsed;
+  ssd->stats.total_flush_us += elapsed;
 }
 
-// Envia uma lista de comandos ao hardware
-void ssd1306_send_command_list(uint8_t *ssd, int number) {
-  for (int i = 0; i < number; i++) {
-    ssd1306_send_command(ssd[i]);
+// Inicializa uma instância: aloca o framebuffer conforme a geometria, envia a
+// sequência de configuração e limpa a tela. Retorna false se não houver
+// memória ou se o painel não responder no endereço informado
+bool ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height,
+                  bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
+  memset(ssd, 0, sizeof(*ssd));
+  ssd->width = width;
+  ssd->height = height;
+  ssd->pages = height / ssd1306_page_height;
+  ssd->address = address;
+  ssd->i2c_port = i2c;
+  ssd->external_vcc = external_vcc;
+  ssd->bufsize = ssd->pages * ssd->width + 1;
+  ssd->ram_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
+  if (!ssd->ram_buffer) {
+    return false;
   }
-}
-
-// Copia buffer de referência num novo buffer, a fim de adicionar o byte de
-// controle desde o início
-void ssd1306_send_buffer(uint8_t ssd[], int buffer_length) {
-  uint8_t *temp_buffer = malloc(buffer_length + 1);
+  ssd->ram_buffer[0] = 0x40;
+  ssd->port_buffer[0] = 0x80;
 
-  temp_buffer[0] = 0x40;
-  memcpy(temp_buffer + 1, ssd, buffer_length);
+  ssd1306_config(ssd);
+  ssd1306_send_data(ssd);
+  return ssd->stats.errors == 0;
+}
 
-  i2c_write_blocking(i2c1, ssd1306_i2c_address, temp_buffer, buffer_length + 1,
-                     false);
+// Libera o framebuffer da instância
+void ssd1306_deinit(ssd1306_t *ssd) {
+  free(ssd->ram_buffer);
+  ssd->ram_buffer = NULL;
+}
 
-  free(temp_buffer);
+// Comando de configuração com base na estrutura ssd1306_t
+void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
+  ssd->port_buffer[1] = command;
+  ssd1306_write(ssd, ssd->port_buffer, 2);
 }
 
 // Cria a lista de comandos (com base nos endereços definidos em ssd1306_i2c.h)
-// para a inicialização do display
-void ssd1306_init() {
+// para a inicialização do display, de acordo com a geometria da instância
+void ssd1306_config(ssd1306_t *ssd) {
   uint8_t commands[] = {
-      ssd1306_set_display,
+      ssd1306_set_display | 0x00,
       ssd1306_set_memory_mode,
-      0x00,
-      ssd1306_set_display_start_line,
+      0x00,  // Horizontal: mesmo layout de ssd1306_set_pixel
+      ssd1306_set_display_start_line | 0x00,
       ssd1306_set_segment_remap | 0x01,
       ssd1306_set_mux_ratio,
-      ssd1306_height - 1,
+      ssd->height - 1,
       ssd1306_set_common_output_direction | 0x08,
       ssd1306_set_display_offset,
       0x00,
       ssd1306_set_common_pin_configuration,
-
-#if ((ssd1306_width == 128) && (ssd1306_height == 32))
-      0x02,
-#elif ((ssd1306_width == 128) && (ssd1306_height == 64))
-      0x12,
-#else
-      0x02,
-#endif
+      ssd->height == 64 ? 0x12 : 0x02,
       ssd1306_set_display_clock_divide_ratio,
       0x80,
       ssd1306_set_precharge,
-      0xF1,
+      ssd->external_vcc ? 0x22 : 0xF1,
       ssd1306_set_vcomh_deselect_level,
       0x30,
       ssd1306_set_contrast,
@@ -77,42 +100,86 @@ void ssd1306_init() {
       ssd1306_set_entire_on,
       ssd1306_set_normal_display,
       ssd1306_set_charge_pump,
-      0x14,
+      ssd->external_vcc ? 0x10 : 0x14,
       ssd1306_set_scroll | 0x00,
       ssd1306_set_display | 0x01,
   };
 
-  ssd1306_send_command_list(commands, count_of(commands));
+  ssd1306_command_list(ssd, commands, count_of(commands));
 }
 
 // Cria a lista de comandos para configurar o scrolling
-void ssd1306_scroll(bool set) {
+void ssd1306_scroll(ssd1306_t *ssd, bool set) {
   uint8_t commands[] = {
       ssd1306_set_horizontal_scroll | 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0xFF,
       ssd1306_set_scroll | (set ? 0x01 : 0)};
 
-  ssd1306_send_command_list(commands, count_of(commands));
+  ssd1306_command_list(ssd, commands, count_of(commands));
 }
 
-// Atualiza uma parte do display com uma área de renderização
-void render_on_display(uint8_t *ssd, struct render_area *area) {
-  uint8_t commands[] = {ssd1306_set_column_address, area->start_column,
-                        area->end_column,           ssd1306_set_page_address,
-                        area->start_page,           area->end_page};
+// Zera as estatísticas de transferência da instância
+void ssd1306_reset_stats(ssd1306_t *ssd) {
+  memset(&ssd->stats, 0, sizeof(ssd->stats));
+}
 
-  ssd1306_send_command_list(commands, count_of(commands));
-  ssd1306_send_buffer(ssd, area->buffer_length);
+// Envia count quadros completos e retorna true se todos tiveram ACK. Para no
+// primeiro erro, para um painel ausente não custar count prazos esgotados
+static bool ssd1306_test_frames(ssd1306_t *ssd, int count) {
+  uint32_t errors = ssd->stats.errors;
+  for (int i = 0; i < count && ssd->stats.errors == errors; i++) {
+    ssd1306_send_data(ssd);
+  }
+  return ssd->stats.errors == errors;
+}
+
+// Calibra o clock do barramento do display: sobe de min_khz até max_khz em
+// passos de step_khz, enviando ssd1306_i2c_test_frames quadros em cada passo,
+// e para no primeiro passo com NAK ou erro de barramento. O clock final é o
+// maior clock estável reduzido pela margem ssd1306_i2c_clock_margin. Ao final,
+// mede os quadros por segundo no clock escolhido. Retorna false se o painel
+// não responder nem em min_khz (o barramento fica em min_khz)
+bool ssd1306_calibrate_i2c(ssd1306_t *ssd, uint32_t min_khz, uint32_t max_khz,
+                           uint32_t step_khz,
+                           ssd1306_i2c_calibration_t *result) {
+  uint32_t stable_khz = 0;
+
+  for (uint32_t khz = min_khz; khz <= max_khz; khz += step_khz) {
+    i2c_set_baudrate(ssd->i2c_port, khz * 1000);
+    if (!ssd1306_test_frames(ssd, ssd1306_i2c_test_frames)) {
+      break;
+    }
+    stable_khz = khz;
+  }
+
+  uint32_t chosen_khz = stable_khz * (100 - ssd1306_i2c_clock_margin) / 100;
+  if (chosen_khz < min_khz) {
+    chosen_khz = min_khz;
+  }
+  result->max_stable_khz = stable_khz;
+  result->baudrate = i2c_set_baudrate(ssd->i2c_port, chosen_khz * 1000);
+
+  // Um passo com falha pode ter deixado o painel com dados parciais
+  uint32_t start = time_us_32();
+  bool ok = ssd1306_test_frames(ssd, ssd1306_i2c_test_frames);
+  uint32_t elapsed = time_us_32() - start;
+  result->fps = elapsed ? ssd1306_i2c_test_frames * 1e6f / elapsed : 0.0f;
+
+  return stable_khz != 0 && ok;
+}
+
+// Limpa o framebuffer (não envia nada ao display)
+void ssd1306_clear(ssd1306_t *ssd) {
+  memset(ssd1306_framebuffer(ssd), 0, ssd->bufsize - 1);
 }
 
 // Determina o pixel a ser aceso (no display) de acordo com a coordenada
 // fornecida
-void ssd1306_set_pixel(uint8_t *ssd, int x, int y, bool set) {
-  assert(x >= 0 && x < ssd1306_width && y >= 0 && y < ssd1306_height);
-
-  const int bytes_per_row = ssd1306_width;
+void ssd1306_set_pixel(ssd1306_t *ssd, int x, int y, bool set) {
+  assert(x >= 0 && x < ssd->width && y >= 0 && y < ssd->height);
 
-  int byte_idx = (y / 8) * bytes_per_row + x;
-  uint8_t byte = ssd[byte_idx];
+  int byte_idx = (y / 8) * ssd->width + x;
+  uint8_t *fb = ssd1306_framebuffer(ssd);
+  uint8_t byte = fb[byte_idx];
 
   if (set) {
     byte |= 1 << (y % 8);
@@ -120,11 +187,11 @@ void ssd1306_set_pixel(uint8_t *ssd, int x, int y, bool set) {
     byte &= ~(1 << (y % 8));
   }
 
-  ssd[byte_idx] = byte;
+  fb[byte_idx] = byte;
 }
 
 // Algoritmo de Bresenham básico
-void ssd1306_draw_line(uint8_t *ssd, int x_0, int y_0, int x_1, int y_1,
+void ssd1306_draw_line(ssd1306_t *ssd, int x_0, int y_0, int x_1, int y_1,
                        bool set) {
   int dx = abs(x_1 - x_0);  // Deslocamentos
   int dy = -abs(y_1 - y_0);
@@ -153,7 +220,7 @@ void ssd1306_draw_line(uint8_t *ssd, int x_0, int y_0, int x_1, int y_1,
 }
 
 // Adquire os pixels para um caractere (de acordo com ssd1306_font.h)
-inline int ssd1306_get_font(uint8_t character) {
+static inline int ssd1306_get_font(uint8_t character) {
   if (character >= 'A' && character <= 'Z') {
     return character - 'A' + 1;
   } else if (character >= '0' && character <= '9') {
@@ -163,8 +230,9 @@ inline int ssd1306_get_font(uint8_t character) {
 }
 
 // Desenha um único caractere no display
-void ssd1306_draw_char(uint8_t *ssd, int16_t x, int16_t y, uint8_t character) {
-  if (x > ssd1306_width - 8 || y > ssd1306_height - 8) {
+void ssd1306_draw_char(ssd1306_t *ssd, int16_t x, int16_t y,
+                       uint8_t character) {
+  if (x < 0 || y < 0 || x > ssd->width - 8 || y > ssd->height - 8) {
     return;
   }
 
@@ -172,16 +240,17 @@ void ssd1306_draw_char(uint8_t *ssd, int16_t x, int16_t y, uint8_t character) {
 
   character = toupper(character);
   int idx = ssd1306_get_font(character);
-  int fb_idx = y * 128 + x;
+  uint8_t *fb = ssd1306_framebuffer(ssd) + y * ssd->width + x;
 
   for (int i = 0; i < 8; i++) {
-    ssd[fb_idx++] = font[idx * 8 + i];
+    fb[i] = font[idx * 8 + i];
   }
 }
 
 // Desenha uma string, chamando a função de desenhar caractere várias vezes
-void ssd1306_draw_string(uint8_t *ssd, int16_t x, int16_t y, char *string) {
-  if (x > ssd1306_width - 8 || y > ssd1306_height - 8) {
+void ssd1306_draw_string(ssd1306_t *ssd, int16_t x, int16_t y,
+                         const char *string) {
+  if (x > ssd->width - 8 || y > ssd->height - 8) {
     return;
   }
 
@@ -191,72 +260,93 @@ void ssd1306_draw_string(uint8_t *ssd, int16_t x, int16_t y, char *string) {
   }
 }
 
-// Comando de configuração com base na estrutura ssd1306_t
-void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
-  ssd->port_buffer[1] = command;
-  i2c_write_blocking(ssd->i2c_port, ssd->address, ssd->port_buffer, 2, false);
-}
+// Envia vários comandos numa única transação i2c (byte de controle 0x00
+// seguido da sequência de comandos), em vez de uma transação por comando
+void ssd1306_command_list(ssd1306_t *ssd, const uint8_t *commands,
+                          size_t number) {
+  uint8_t buffer[number + 1];
 
-// Função de configuração do display para o caso do bitmap
-void ssd1306_config(ssd1306_t *ssd) {
-  ssd1306_command(ssd, ssd1306_set_display | 0x00);
-  ssd1306_command(ssd, ssd1306_set_memory_mode);
-  ssd1306_command(ssd, 0x01);
-  ssd1306_command(ssd, ssd1306_set_display_start_line | 0x00);
-  ssd1306_command(ssd, ssd1306_set_segment_remap | 0x01);
-  ssd1306_command(ssd, ssd1306_set_mux_ratio);
-  ssd1306_command(ssd, ssd1306_height - 1);
-  ssd1306_command(ssd, ssd1306_set_common_output_direction | 0x08);
-  ssd1306_command(ssd, ssd1306_set_display_offset);
-  ssd1306_command(ssd, 0x00);
-  ssd1306_command(ssd, ssd1306_set_common_pin_configuration);
-  ssd1306_command(ssd, 0x12);
-  ssd1306_command(ssd, ssd1306_set_display_clock_divide_ratio);
-  ssd1306_command(ssd, 0x80);
-  ssd1306_command(ssd, ssd1306_set_precharge);
-  ssd1306_command(ssd, 0xF1);
-  ssd1306_command(ssd, ssd1306_set_vcomh_deselect_level);
-  ssd1306_command(ssd, 0x30);
-  ssd1306_command(ssd, ssd1306_set_contrast);
-  ssd1306_command(ssd, 0xFF);
-  ssd1306_command(ssd, ssd1306_set_entire_on);
-  ssd1306_command(ssd, ssd1306_set_normal_display);
-  ssd1306_command(ssd, ssd1306_set_charge_pump);
-  ssd1306_command(ssd, 0x14);
-  ssd1306_command(ssd, ssd1306_set_display | 0x01);
+  buffer[0] = 0x00;
+  memcpy(buffer + 1, commands, number);
+  ssd1306_write(ssd, buffer, number + 1);
 }
 
-// Inicializa o display para o caso de exibição de bitmap
-void ssd1306_init_bm(ssd1306_t *ssd, uint8_t width, uint8_t height,
-                     bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
-  ssd->width = width;
-  ssd->height = height;
-  ssd->pages = height / 8U;
-  ssd->address = address;
-  ssd->i2c_port = i2c;
-  ssd->bufsize = ssd->pages * ssd->width + 1;
-  ssd->ram_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
-  ssd->ram_buffer[0] = 0x40;
-  ssd->port_buffer[0] = 0x80;
+// Define a janela de escrita (colunas e páginas) da memória do display
+static void ssd1306_set_window(ssd1306_t *ssd, uint8_t start_column,
+                               uint8_t end_column, uint8_t start_page,
+                               uint8_t end_page) {
+  uint8_t commands[] = {ssd1306_set_column_address, start_column, end_column,
+                        ssd1306_set_page_address,   start_page,   end_page};
+
+  ssd1306_command_list(ssd, commands, count_of(commands));
 }
 
 // Envia os dados ao display
 void ssd1306_send_data(ssd1306_t *ssd) {
-  ssd1306_command(ssd, ssd1306_set_column_address);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->width - 1);
-  ssd1306_command(ssd, ssd1306_set_page_address);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->pages - 1);
-  i2c_write_blocking(ssd->i2c_port, ssd->address, ssd->ram_buffer, ssd->bufsize,
-                     false);
+  uint32_t start = time_us_32();
+
+  ssd1306_set_window(ssd, 0, ssd->width - 1, 0, ssd->pages - 1);
+  ssd1306_write(ssd, ssd->ram_buffer, ssd->bufsize);
+
+  ssd1306_account_flush(ssd, start);
+  ssd->stats.frames++;
 }
 
-// Desenha o bitmap (a ser fornecido em display_oled.c) no display
+// Envia ao display apenas uma região do ram_buffer (colunas start_column a
+// end_column, páginas start_page a end_page). No modo de endereçamento
+// horizontal o ponteiro do display volta para start_column ao fim de cada
+// página, então cada página da região é enviada numa transação própria
+void ssd1306_send_region(ssd1306_t *ssd, uint8_t start_column,
+                         uint8_t end_column, uint8_t start_page,
+                         uint8_t end_page) {
+  if (end_column >= ssd->width) end_column = ssd->width - 1;
+  if (end_page >= ssd->pages) end_page = ssd->pages - 1;
+  if (start_column > end_column || start_page > end_page) return;
+
+  if (start_column == 0 && end_column == ssd->width - 1 && start_page == 0 &&
+      end_page == ssd->pages - 1) {
+    ssd1306_send_data(ssd);
+    return;
+  }
+
+  uint32_t start = time_us_32();
+  int columns = end_column - start_column + 1;
+  uint8_t buffer[columns + 1];
+  buffer[0] = 0x40;
+
+  ssd1306_set_window(ssd, start_column, end_column, start_page, end_page);
+  for (int page = start_page; page <= end_page; page++) {
+    memcpy(buffer + 1, &ssd->ram_buffer[1 + page * ssd->width + start_column],
+           columns);
+    ssd1306_write(ssd, buffer, columns + 1);
+  }
+
+  ssd1306_account_flush(ssd, start);
+  ssd->stats.regions++;
+}
+
+// Desenha o bitmap (a ser fornecido em display_oled.c) no display. O bitmap
+// ocupa a tela inteira no mesmo layout do ram_buffer (página a página, um byte
+// por coluna) e é copiado de uma só vez antes de um único envio do quadro
 void ssd1306_draw_bitmap(ssd1306_t *ssd, const uint8_t *bitmap) {
-  for (int i = 0; i < ssd->bufsize - 1; i++) {
-    ssd->ram_buffer[i + 1] = bitmap[i];
+  memcpy(ssd->ram_buffer + 1, bitmap, ssd->bufsize - 1);
+  ssd1306_send_data(ssd);
+}
 
-    ssd1306_send_data(ssd);
+// Copia um bitmap de width colunas por pages páginas para o ram_buffer a partir
+// da coluna x e da página page, recortando o que ficar fora da tela. Não envia
+// nada ao display: use ssd1306_send_region para atualizar só a região alterada
+void ssd1306_blit_bitmap(ssd1306_t *ssd, const uint8_t *bitmap, int x,
+                         int page, int width, int pages) {
+  int first_column = x < 0 ? -x : 0;
+  int last_column = x + width > ssd->width ? ssd->width - x : width;
+  if (first_column >= last_column) return;
+
+  for (int p = 0; p < pages; p++) {
+    int dest_page = page + p;
+    if (dest_page < 0 || dest_page >= ssd->pages) continue;
+
+    memcpy(&ssd->ram_buffer[1 + dest_page * ssd->width + x + first_column],
+           &bitmap[p * width + first_column], last_column - first_column);
   }
-}
\ No newline at end of file
+}
@@ -6,12 +6,16 @@
 #ifndef ssd1306_inc_h
 #define ssd1306_inc_h
 
-#define ssd1306_height 64  // Define a altura do display (32 pixels)
-#define ssd1306_width 128  // Define a largura do display (128 pixels)
+#define ssd1306_height 64  // Altura padrão do display (32 ou 64 pixels)
+#define ssd1306_width 128  // Largura padrão do display (128 pixels)
 
 #define ssd1306_i2c_address _u(0x3C)  // Define o endereço do i2c do display
 
-#define ssd1306_i2c_clock 400  // Define o tempo do clock (pode ser aumentado)
+#define ssd1306_i2c_clock 400  // Clock inicial do i2c em kHz (Fast-mode)
+#define ssd1306_i2c_clock_max 1000  // Limite da calibração (Fast-mode Plus)
+#define ssd1306_i2c_clock_step 100  // Passo da calibração em kHz
+#define ssd1306_i2c_clock_margin 15  // Margem de segurança (%) na calibração
+#define ssd1306_i2c_test_frames 8  // Quadros enviados para validar cada passo
 
 // Comandos de configuração (endereços)
 #define ssd1306_set_memory_mode _u(0x20)
@@ -48,22 +52,37 @@
 #define ssd1306_write_mode _u(0xFE)
 #define ssd1306_read_mode _u(0xFF)
 
-struct render_area {
-  uint8_t start_column;
-  uint8_t end_column;
-  uint8_t start_page;
-  uint8_t end_page;
-
-  int buffer_length;
-};
-
+// Estatísticas de transferência de uma instância do display
+typedef struct {
+  uint32_t frames;        // Quadros completos enviados
+  uint32_t regions;       // Regiões parciais enviadas
+  uint32_t transactions;  // Transações i2c realizadas
+  uint32_t bytes;         // Bytes enviados (incluindo bytes de controle)
+  uint32_t errors;        // Transações sem ACK ou incompletas
+  uint32_t last_flush_us;   // Duração do último envio (quadro ou região)
+  uint64_t total_flush_us;  // Tempo total gasto em envios
+} ssd1306_stats_t;
+
+// Uma instância por painel: cada display tem seu barramento, endereço,
+// geometria (128x32 ou 128x64), framebuffer e estatísticas próprios
 typedef struct {
   uint8_t width, height, pages, address;
   i2c_inst_t *i2c_port;
   bool external_vcc;
-  uint8_t *ram_buffer;
+  uint8_t *ram_buffer;  // ram_buffer[0] = 0x40, seguido do framebuffer
   size_t bufsize;
   uint8_t port_buffer[2];
+  ssd1306_stats_t stats;
 } ssd1306_t;
 
+// Resultado da calibração do clock i2c
+typedef struct {
+  uint32_t max_stable_khz;  // Maior clock em que todos os quadros tiveram ACK
+  uint32_t baudrate;        // Clock escolhido (com margem), em Hz
+  float fps;                // Quadros completos por segundo no clock escolhido
+} ssd1306_i2c_calibration_t;
+
+// Framebuffer da instância (layout página a página, um byte por coluna)
+#define ssd1306_framebuffer(ssd) ((ssd)->ram_buffer + 1)
+
 #endif
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "telemetria.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "lwip/apps/sntp.h"
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+#include "pico/cyw43_arch.h"
+#include "pico/stdlib.h"
+#include "pico/unique_id.h"
+#include "telemetria_protocolo.h"
+
+// Telemetria por Wi-Fi (CYW43 do pico_w) em datagramas UDP. As janelas de
+// medição são resumidas em registros de um segundo (Leq, Lmax e alertas),
+// que entram numa fila na RAM; quando há rede, lotes de registros saem em
+// datagramas de até TELEMETRIA_REGISTROS_MAX. Sem rede a fila guarda os
+// últimos TELEMETRIA_FILA segundos e descarta os mais antigos; o log por
+// minuto na flash continua cobrindo quedas mais longas.
+//
+// O lwIP roda sem sistema operacional (NO_SYS) e a pilha do rádio só avança
+// dentro de telemetria_processar, no laço principal do núcleo 0. A aquisição
+// roda no núcleo 1 e não espera pelo rádio. A rede e o destino são definidos
+// na compilação (WIFI_SSID, WIFI_SENHA, TELEMETRIA_DESTINO); sem WIFI_SSID o
+// rádio nem é ligado
+
+#ifndef WIFI_SSID
+#define WIFI_SSID ""
+#endif
+#ifndef WIFI_SENHA
+#define WIFI_SENHA ""
+#endif
+#ifndef TELEMETRIA_DESTINO
+#define TELEMETRIA_DESTINO "192.168.0.10"
+#endif
+#ifndef TELEMETRIA_PORTA
+#define TELEMETRIA_PORTA TELEMETRIA_PORTA_PADRAO
+#endif
+
+#define LOTE 10                    // Registros que disparam um envio
+#define PERIODO_MAX_S 10           // Envia um lote incompleto após esse tempo
+#define DATAGRAMAS_POR_CHAMADA 4   // Esvazia a fila aos poucos após uma queda
+#define CONEXAO_MAX_MS 30000       // Desiste de uma tentativa de conexão
+#define RECONEXAO_MS 10000         // Espera entre tentativas
+#define SNTP_SERVIDOR "pool.ntp.org"
+
+typedef enum { DESLIGADA, CONECTANDO, CONECTADA, ESPERA } estado_t;
+
+static estado_t estado = DESLIGADA;
+static uint32_t estado_desde_ms = 0;
+static struct udp_pcb *pcb = NULL;
+static ip_addr_t destino;
+static uint64_t dispositivo = 0;
+static uint16_t sessao = 0;
+static uint32_t sequencia = 0;
+
+static telemetria_registro_t fila[TELEMETRIA_FILA];
+static uint32_t escrita = 0;
+static uint32_t leitura = 0;
+static uint32_t descartados = 0;
+
+// Segundo em resumo
+static uint32_t segundo_atual = 0;
+static float energia_segundo = 0.0f;
+static uint32_t janelas_segundo = 0;
+static float lmax_segundo = 0.0f;
+static unsigned int alertas_inicio_segundo = 0;
+
+static uint32_t agora_ms(void) {
+  return to_ms_since_boot(get_absolute_time());
+}
+
+static void mudar_estado(estado_t novo) {
+  estado = novo;
+  estado_desde_ms = agora_ms();
+}
+
+// Acerta o relógio (inc/relogio.h) na primeira conexão; depois o cliente
+// SNTP volta a sincronizar sozinho a cada hora
+static void iniciar_sntp(void) {
+  if (sntp_enabled()) return;
+  sntp_setoperatingmode(SNTP_OPMODE_POLL);
+  sntp_setservername(0, SNTP_SERVIDOR);
+  sntp_init();
+}
+
+static void conectar(void) {
+  int erro = cyw43_arch_wifi_connect_async(WIFI_SSID, WIFI_SENHA,
+                                           CYW43_AUTH_WPA2_AES_PSK);
+  mudar_estado(erro == 0 ? CONECTANDO : ESPERA);
+}
+
+// Liga o rádio e começa a conexão sem esperar por ela. sessao identifica o
+// boot nos datagramas (a mesma do log na flash)
+void telemetria_iniciar(uint16_t sessao_log) {
+  pico_unique_board_id_t id;
+  pico_get_unique_board_id(&id);
+  memcpy(&dispositivo, id.id, sizeof(dispositivo));
+  sessao = sessao_log;
+
+  if (strlen(WIFI_SSID) == 0 || cyw43_arch_init() != 0) return;
+  cyw43_arch_enable_sta_mode();
+  pcb = udp_new_ip_type(IPADDR_TYPE_ANY);
+  if (pcb == NULL || !ipaddr_aton(TELEMETRIA_DESTINO, &destino)) return;
+  conectar();
+}
+
+static void enfileirar(const telemetria_registro_t *registro) {
+  if (escrita - leitura >= TELEMETRIA_FILA) {
+    leitura++;  // Fila cheia: perde o segundo mais antigo
+    descartados++;
+  }
+  fila[escrita++ & (TELEMETRIA_FILA - 1)] = *registro;
+}
+
+// Acumula uma janela de medição no segundo corrente e, na virada do segundo,
+// enfileira o resumo. alertas é o contador total de alertas do medidor
+void telemetria_janela(float db, unsigned int alertas) {
+  if (estado == DESLIGADA) return;
+  uint32_t segundo = agora_ms() / 1000;
+
+  if (segundo != segundo_atual && janelas_segundo > 0) {
+    telemetria_registro_t registro = {
+        .segundo = segundo_atual,
+        .leq_ddb = (uint16_t)lroundf(
+            100.0f * log10f(energia_segundo / janelas_segundo)),
+        .lmax_ddb = (uint16_t)lroundf(lmax_segundo * 10.0f),
+        .alertas = (uint16_t)(alertas - alertas_inicio_segundo)};
+    enfileirar(&registro);
+    energia_segundo = 0.0f;
+    janelas_segundo = 0;
+    lmax_segundo = 0.0f;
+  }
+  if (segundo != segundo_atual) {
+    segundo_atual = segundo;
+    alertas_inicio_segundo = alertas;
+  }
+
+  energia_segundo += powf(10.0f, db / 10.0f);
+  janelas_segundo++;
+  lmax_segundo = fmaxf(lmax_segundo, db);
+}
+
+// Monta e envia um datagrama com até TELEMETRIA_REGISTROS_MAX registros do
+// início da fila. Eles só saem da fila se o lwIP aceitar o datagrama
+static bool enviar_lote(void) {
+  uint32_t n = escrita - leitura;
+  if (n > TELEMETRIA_REGISTROS_MAX) n = TELEMETRIA_REGISTROS_MAX;
+
+  uint16_t tamanho = sizeof(telemetria_cabecalho_t) +
+                     n * sizeof(telemetria_registro_t);
+  struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, tamanho, PBUF_RAM);
+  if (p == NULL) return false;
+
+  telemetria_cabecalho_t cabecalho = {.magica = TELEMETRIA_MAGICA,
+                                      .versao = TELEMETRIA_VERSAO,
+                                      .quantidade = (uint8_t)n,
+                                      .sessao = sessao,
+                                      .dispositivo = dispositivo,
+                                      .sequencia = sequencia,
+                                      .descartados = descartados};
+  uint8_t *destino_dados = p->payload;
+  memcpy(destino_dados, &cabecalho, sizeof(cabecalho));
+  destino_dados += sizeof(cabecalho);
+  for (uint32_t i = 0; i < n; i++) {
+    memcpy(destino_dados, &fila[(leitura + i) & (TELEMETRIA_FILA - 1)],
+           sizeof(telemetria_registro_t));
+    destino_dados += sizeof(telemetria_registro_t);
+  }
+
+  err_t erro = udp_sendto(pcb, p, &destino, TELEMETRIA_PORTA);
+  pbuf_free(p);
+  if (erro != ERR_OK) return false;
+  leitura += n;
+  sequencia++;
+  return true;
+}
+
+// Atende o rádio e a pilha IP, reconecta quando preciso e envia os lotes
+// prontos: LOTE registros, ou qualquer quantidade com PERIODO_MAX_S de
+// idade. Deve ser chamada com frequência no laço principal
+void telemetria_processar(void) {
+  if (estado == DESLIGADA) return;
+  cyw43_arch_poll();
+
+  int enlace = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+  uint32_t decorrido = agora_ms() - estado_desde_ms;
+
+  switch (estado) {
+    case CONECTANDO:
+      if (enlace == CYW43_LINK_UP) {
+        mudar_estado(CONECTADA);
+        iniciar_sntp();
+      } else if (enlace < 0 || decorrido >= CONEXAO_MAX_MS) {
+        mudar_estado(ESPERA);  // Falha, rede ausente ou senha errada
+      }
+      break;
+    case ESPERA:
+      if (decorrido >= RECONEXAO_MS) conectar();
+      break;
+    case CONECTADA:
+      if (enlace != CYW43_LINK_UP) {
+        mudar_estado(ESPERA);
+        break;
+      }
+      for (int i = 0; i < DATAGRAMAS_POR_CHAMADA; i++) {
+        uint32_t pendentes = escrita - leitura;
+        if (pendentes == 0) break;
+        uint32_t idade = segundo_atual - fila[leitura & (TELEMETRIA_FILA - 1)]
+                                             .segundo;
+        if (pendentes < LOTE && idade < PERIODO_MAX_S) break;
+        if (!enviar_lote()) break;  // Sem memória: tenta na próxima chamada
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+// Rádio ligado (WIFI_SSID definido e CYW43 iniciado), com ou sem conexão
+bool telemetria_ligada(void) { return estado != DESLIGADA; }
+
+bool telemetria_conectada(void) { return estado == CONECTADA; }
+
+// Registros à espera de rede e registros perdidos por fila cheia
+uint32_t telemetria_pendentes(void) { return escrita - leitura; }
+uint32_t telemetria_descartados(void) { return descartados; }
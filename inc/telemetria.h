@@ -0,0 +1,19 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef telemetria_inc_h
+#define telemetria_inc_h
+
+// Registros de um segundo guardados enquanto não há rede: 2048 (34 min)
+#define TELEMETRIA_FILA_BITS 11
+#define TELEMETRIA_FILA (1u << TELEMETRIA_FILA_BITS)
+
+extern void telemetria_iniciar(uint16_t sessao);
+extern void telemetria_janela(float db, unsigned int alertas);
+extern void telemetria_processar(void);
+extern bool telemetria_ligada(void);
+extern bool telemetria_conectada(void);
+extern uint32_t telemetria_pendentes(void);
+extern uint32_t telemetria_descartados(void);
+
+#endif
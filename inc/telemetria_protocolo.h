@@ -0,0 +1,35 @@
+#include <stdint.h>
+
+#ifndef telemetria_protocolo_inc_h
+#define telemetria_protocolo_inc_h
+
+// Datagramas UDP de telemetria (compartilhado com as ferramentas do host).
+// Cada datagrama é um telemetria_cabecalho_t seguido de `quantidade`
+// registros de um segundo, em ordem e little-endian. Os registros de um
+// datagrama são consecutivos na fila do medidor; `descartados` cresce quando
+// a fila transborda sem rede, e uma lacuna na sequência indica datagrama
+// perdido no caminho
+
+#define TELEMETRIA_MAGICA 0x4D4C4554u  // "TELM"
+#define TELEMETRIA_VERSAO 1
+#define TELEMETRIA_PORTA_PADRAO 5005
+#define TELEMETRIA_REGISTROS_MAX 64  // Por datagrama (664 bytes)
+
+typedef struct __attribute__((packed)) {
+  uint32_t magica;       // TELEMETRIA_MAGICA
+  uint8_t versao;        // TELEMETRIA_VERSAO
+  uint8_t quantidade;    // Registros após o cabeçalho
+  uint16_t sessao;       // Sessão do log (incrementada a cada boot)
+  uint64_t dispositivo;  // Número único da flash do medidor
+  uint32_t sequencia;    // Número do datagrama desde o boot
+  uint32_t descartados;  // Registros perdidos por fila cheia desde o boot
+} telemetria_cabecalho_t;
+
+typedef struct __attribute__((packed)) {
+  uint32_t segundo;    // Segundos desde o boot
+  uint16_t leq_ddb;    // Leq do segundo (décimos de dB)
+  uint16_t lmax_ddb;   // Maior leitura de janela no segundo (décimos de dB)
+  uint16_t alertas;    // Alertas disparados no segundo
+} telemetria_registro_t;
+
+#endif
@@ -0,0 +1,51 @@
+#include "aquisicao.h"  // AQ_TAXA_PADRAO_HZ
+
+#ifndef tusb_config_inc_h
+#define tusb_config_inc_h
+
+// Configuração do TinyUSB: dispositivo full-speed na porta nativa do RP2040
+
+#ifndef CFG_TUSB_MCU
+#define CFG_TUSB_MCU OPT_MCU_RP2040
+#endif
+#define CFG_TUSB_OS OPT_OS_PICO
+#define CFG_TUSB_RHPORT0_MODE OPT_MODE_DEVICE
+#define CFG_TUD_ENABLED 1
+
+#define CFG_TUD_ENDPOINT0_SIZE 64
+
+// Classes do dispositivo composto
+#define CFG_TUD_CDC 1
+#define CFG_TUD_AUDIO 1
+#define CFG_TUD_MSC 1
+#define CFG_TUD_HID 0
+#define CFG_TUD_MIDI 0
+#define CFG_TUD_VENDOR 0
+
+// CDC: o buffer de envio guarda cerca de 250 ms de áudio bruto a 16 kHz
+// (pacotes de 532 bytes), cobrindo as voltas lentas do laço principal, e cada
+// transferência leva até 8 pacotes USB de 64 bytes
+#define CFG_TUD_CDC_RX_BUFSIZE 64
+#define CFG_TUD_CDC_TX_BUFSIZE 8192
+#define CFG_TUD_CDC_EP_BUFSIZE 512
+
+// Disco somente leitura (usb_msc.c): um setor por transferência
+#define CFG_TUD_MSC_EP_BUFSIZE 512
+
+// Áudio (UAC2): microfone de um canal, 16 bits, em AQ_TAXA_PADRAO_HZ. O
+// endpoint isócrono assíncrono leva 1 amostra a mais que o nominal por
+// quadro de 1 ms, margem para o ajuste de taxa de usb_audio.c
+#define CFG_TUD_AUDIO_FUNC_1_DESC_LEN TUD_AUDIO_MIC_ONE_CH_DESC_LEN
+#define CFG_TUD_AUDIO_FUNC_1_N_AS_INT 1
+#define CFG_TUD_AUDIO_FUNC_1_CTRL_BUF_SZ 64
+#define CFG_TUD_AUDIO_ENABLE_EP_IN 1
+#define CFG_TUD_AUDIO_FUNC_1_N_BYTES_PER_SAMPLE_TX 2
+#define CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX 1
+#define CFG_TUD_AUDIO_EP_SZ_IN                                  \
+  ((AQ_TAXA_PADRAO_HZ / 1000 + 1) *                             \
+   CFG_TUD_AUDIO_FUNC_1_N_BYTES_PER_SAMPLE_TX *                 \
+   CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX)
+#define CFG_TUD_AUDIO_FUNC_1_EP_IN_SZ_MAX CFG_TUD_AUDIO_EP_SZ_IN
+#define CFG_TUD_AUDIO_FUNC_1_EP_IN_SW_BUF_SZ CFG_TUD_AUDIO_EP_SZ_IN
+
+#endif
@@ -0,0 +1,225 @@
+#include "usb_audio.h"
+
+#include "aquisicao.h"
+#include "tusb.h"
+
+// Microfone USB Audio Class 2 (um canal, 16 bits, AQ_TAXA_PADRAO_HZ). As
+// amostras são as mesmas que o medidor usa, já sem o offset DC, escaladas
+// para o fundo de escala de 16 bits. ler_decibeis chega com um bloco inteiro
+// a cada 16 ms e com atraso variável (display, FFT), enquanto o host lê um
+// pacote por quadro de 1 ms: a fila abaixo absorve essa diferença e também
+// as escritas na flash, durante as quais a pilha USB fica parada.
+//
+// O endpoint é isócrono assíncrono, então o clock de amostragem é o do ADC e
+// não o do host. Em vez de um endpoint de realimentação (que só existe para
+// OUT), o tamanho de cada pacote é ajustado pelo nível da fila: o nominal de
+// AQ_TAXA_PADRAO_HZ/1000 amostras, uma a mais quando a fila passa do alvo e
+// uma a menos quando fica abaixo. Assim a deriva entre os cristais e o atraso
+// do laço principal são compensados sem perder nem repetir amostras
+
+// Entidades de TUD_AUDIO_MIC_ONE_CH_DESCRIPTOR
+#define ENTIDADE_FUNCAO 0x02
+#define ENTIDADE_CLOCK 0x04
+
+// Pacote nominal e nível alvo da fila: 3 blocos (48 ms a 16 kHz) cobrem um
+// laço principal lento sem esvaziar a fila
+#define AMOSTRAS_QUADRO (AQ_TAXA_PADRAO_HZ / 1000)
+#define FILA_ALVO (3 * AQ_AMOSTRAS_BLOCO)
+#define FILA_FOLGA 128
+
+// A fila tem um produtor (laço principal) e um consumidor (tud_task, que
+// roda por interrupção): cada índice só é escrito por um dos lados
+static int16_t fila[USB_AUDIO_FILA];
+static volatile uint32_t escrita = 0;
+static volatile uint32_t leitura = 0;
+static volatile bool ativo = false;  // Host selecionou a alternativa 1
+static bool escorvada = false;  // Fila chegou ao alvo desde o início/falta
+static bool mudo = false;
+static int16_t volume = 0;  // 1/256 dB, só informado ao host
+static uint32_t estouros = 0;
+static uint32_t faltas = 0;
+
+// Taxa informada ao host: a de compilação, a mesma que dimensiona o endpoint
+// (CFG_TUD_AUDIO_EP_SZ_IN) e o pacote nominal. A diferença entre ela e a
+// nominal do divisor do ADC é pequena e compensada pelo ajuste de tamanho
+// dos pacotes, como a deriva dos cristais
+static uint32_t taxa_hz(void) { return AQ_TAXA_PADRAO_HZ; }
+
+// --------------------------------------------------------------------------
+// Entrada de amostras (laço principal)
+// --------------------------------------------------------------------------
+
+// Enfileira n amostras do medidor (contagens << 2). Sem host gravando nada é
+// guardado; com a fila cheia as amostras novas são descartadas e contadas
+void usb_audio_enviar(const int16_t *amostras, int n) {
+  if (!ativo) return;
+
+  uint32_t e = escrita;
+  int i;
+  for (i = 0; i < n && e - leitura < USB_AUDIO_FILA; i++) {
+    // Contagens << 2 (14 bits) para 16 bits, saturando o extremo positivo
+    int32_t x = mudo ? 0 : (int32_t)amostras[i] * 4;
+    if (x > INT16_MAX) x = INT16_MAX;
+    fila[e++ & (USB_AUDIO_FILA - 1)] = (int16_t)x;
+  }
+  estouros += n - i;
+
+  // Publica as amostras só depois de escritas na fila
+  __compiler_memory_barrier();
+  escrita = e;
+}
+
+bool usb_audio_ativo(void) { return ativo; }
+
+// Amostras descartadas por fila cheia e quadros enviados com a fila vazia
+uint32_t usb_audio_estouros(void) { return estouros; }
+uint32_t usb_audio_faltas(void) { return faltas; }
+
+// --------------------------------------------------------------------------
+// Envio isócrono (tud_task)
+// --------------------------------------------------------------------------
+
+// Chamada pela pilha antes de carregar o próximo pacote IN: coloca no FIFO do
+// endpoint o número de amostras deste quadro
+bool tud_audio_tx_done_pre_load_cb(uint8_t rhport, uint8_t itf, uint8_t ep_in,
+                                   uint8_t cur_alt_setting) {
+  (void)rhport;
+  (void)itf;
+  (void)ep_in;
+  (void)cur_alt_setting;
+
+  uint32_t nivel = escrita - leitura;
+  if (!escorvada) {
+    // Até a fila chegar ao alvo o host recebe pacotes vazios
+    if (nivel < FILA_ALVO) return true;
+    escorvada = true;
+  }
+
+  uint32_t n = AMOSTRAS_QUADRO;
+  if (nivel > FILA_ALVO + FILA_FOLGA) n++;
+  if (nivel < FILA_ALVO - FILA_FOLGA) n--;
+  if (n > nivel) {
+    // Fila esvaziou: envia o que há e volta a escorvar
+    n = nivel;
+    escorvada = false;
+    faltas++;
+  }
+
+  // Até duas cópias, por causa da volta do anel
+  uint32_t inicio = leitura & (USB_AUDIO_FILA - 1);
+  uint32_t ate_fim = USB_AUDIO_FILA - inicio;
+  uint32_t primeira = n < ate_fim ? n : ate_fim;
+  tud_audio_write(&fila[inicio], (uint16_t)(primeira * sizeof(int16_t)));
+  if (n > primeira) {
+    tud_audio_write(&fila[0], (uint16_t)((n - primeira) * sizeof(int16_t)));
+  }
+  leitura += n;
+  return true;
+}
+
+// --------------------------------------------------------------------------
+// Interface de streaming: alternativa 0 = parado, 1 = gravando
+// --------------------------------------------------------------------------
+
+bool tud_audio_set_itf_cb(uint8_t rhport,
+                          tusb_control_request_t const *p_request) {
+  (void)rhport;
+  ativo = tu_u16_low(p_request->wValue) != 0;
+  leitura = escrita;  // Esvazia a fila sem mexer no índice do produtor
+  escorvada = false;
+  return true;
+}
+
+bool tud_audio_set_itf_close_EP_cb(uint8_t rhport,
+                                   tusb_control_request_t const *p_request) {
+  (void)rhport;
+  (void)p_request;
+  ativo = false;
+  return true;
+}
+
+// --------------------------------------------------------------------------
+// Requisições de controle das entidades (clock e unidade de função)
+// --------------------------------------------------------------------------
+
+bool tud_audio_get_req_entity_cb(uint8_t rhport,
+                                 tusb_control_request_t const *p_request) {
+  const audio_control_request_t *req =
+      (const audio_control_request_t *)p_request;
+
+  if (req->bEntityID == ENTIDADE_CLOCK) {
+    // Taxa única: a do ADC
+    if (req->bControlSelector == AUDIO_CS_CTRL_SAM_FREQ) {
+      if (req->bRequest == AUDIO_CS_REQ_CUR) {
+        audio_control_cur_4_t taxa = {.bCur = taxa_hz()};
+        return tud_audio_buffer_and_schedule_control_xfer(
+            rhport, p_request, &taxa, sizeof(taxa));
+      }
+      if (req->bRequest == AUDIO_CS_REQ_RANGE) {
+        audio_control_range_4_n_t(1) faixa = {
+            .wNumSubRanges = 1,
+            .subrange[0] = {.bMin = taxa_hz(),
+                            .bMax = taxa_hz(),
+                            .bRes = 0}};
+        return tud_audio_buffer_and_schedule_control_xfer(
+            rhport, p_request, &faixa, sizeof(faixa));
+      }
+    }
+    if (req->bControlSelector == AUDIO_CS_CTRL_CLK_VALID &&
+        req->bRequest == AUDIO_CS_REQ_CUR) {
+      audio_control_cur_1_t valido = {.bCur = 1};
+      return tud_audio_buffer_and_schedule_control_xfer(
+          rhport, p_request, &valido, sizeof(valido));
+    }
+    return false;
+  }
+
+  if (req->bEntityID == ENTIDADE_FUNCAO) {
+    if (req->bControlSelector == AUDIO_FU_CTRL_MUTE &&
+        req->bRequest == AUDIO_CS_REQ_CUR) {
+      audio_control_cur_1_t atual = {.bCur = mudo};
+      return tud_audio_buffer_and_schedule_control_xfer(
+          rhport, p_request, &atual, sizeof(atual));
+    }
+    if (req->bControlSelector == AUDIO_FU_CTRL_VOLUME) {
+      if (req->bRequest == AUDIO_CS_REQ_CUR) {
+        audio_control_cur_2_t atual = {.bCur = volume};
+        return tud_audio_buffer_and_schedule_control_xfer(
+            rhport, p_request, &atual, sizeof(atual));
+      }
+      if (req->bRequest == AUDIO_CS_REQ_RANGE) {
+        // O ganho é fixo (o do medidor); a faixa nula deixa isso claro
+        audio_control_range_2_n_t(1) faixa = {
+            .wNumSubRanges = 1,
+            .subrange[0] = {.bMin = 0, .bMax = 0, .bRes = 256}};
+        return tud_audio_buffer_and_schedule_control_xfer(
+            rhport, p_request, &faixa, sizeof(faixa));
+      }
+    }
+    return false;
+  }
+
+  // Conector e demais controles do terminal de entrada não são suportados
+  return false;
+}
+
+bool tud_audio_set_req_entity_cb(uint8_t rhport,
+                                 tusb_control_request_t const *p_request,
+                                 uint8_t *buf) {
+  const audio_control_request_t *req =
+      (const audio_control_request_t *)p_request;
+  (void)rhport;
+
+  if (req->bEntityID != ENTIDADE_FUNCAO || req->bRequest != AUDIO_CS_REQ_CUR) {
+    return false;
+  }
+  if (req->bControlSelector == AUDIO_FU_CTRL_MUTE) {
+    mudo = ((const audio_control_cur_1_t *)buf)->bCur != 0;
+    return true;
+  }
+  if (req->bControlSelector == AUDIO_FU_CTRL_VOLUME) {
+    volume = ((const audio_control_cur_2_t *)buf)->bCur;
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,16 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef usb_audio_inc_h
+#define usb_audio_inc_h
+
+// Fila de áudio para o microfone USB (UAC2): 2^11 amostras, 128 ms a 16 kHz
+#define USB_AUDIO_FILA_BITS 11
+#define USB_AUDIO_FILA (1u << USB_AUDIO_FILA_BITS)
+
+extern void usb_audio_enviar(const int16_t *amostras, int n);
+extern bool usb_audio_ativo(void);
+extern uint32_t usb_audio_estouros(void);
+extern uint32_t usb_audio_faltas(void);
+
+#endif
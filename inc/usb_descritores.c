@@ -0,0 +1,118 @@
+#include <string.h>
+
+#include "pico/unique_id.h"
+#include "tusb.h"
+
+// Descritores do dispositivo USB composto (IAD). O PID reflete as classes
+// habilitadas em tusb_config.h, para o host não reaproveitar drivers de uma
+// composição anterior
+#define _PID_MAP(itf, n) ((CFG_TUD_##itf) << (n))
+#define USB_VID 0xCafe
+#define USB_PID \
+  (0x4000 | _PID_MAP(CDC, 0) | _PID_MAP(MSC, 1) | _PID_MAP(AUDIO, 2))
+
+enum {
+  ITF_NUM_CDC = 0,
+  ITF_NUM_CDC_DATA,
+  ITF_NUM_AUDIO_CONTROL,
+  ITF_NUM_AUDIO_STREAMING,
+  ITF_NUM_MSC,
+  ITF_NUM_TOTAL
+};
+
+enum {
+  STRID_LANGID = 0,
+  STRID_FABRICANTE,
+  STRID_PRODUTO,
+  STRID_SERIAL,
+  STRID_CDC,
+  STRID_AUDIO,
+  STRID_MSC,
+};
+
+#define EPNUM_CDC_NOTIF 0x81
+#define EPNUM_CDC_OUT 0x02
+#define EPNUM_CDC_IN 0x82
+#define EPNUM_AUDIO_IN 0x83
+#define EPNUM_MSC_OUT 0x04
+#define EPNUM_MSC_IN 0x84
+
+#define CONFIG_TOTAL_LEN \
+  (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_AUDIO_MIC_ONE_CH_DESC_LEN + \
+   TUD_MSC_DESC_LEN)
+
+static const tusb_desc_device_t descritor_dispositivo = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    .bDeviceClass = TUSB_CLASS_MISC,
+    .bDeviceSubClass = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = USB_VID,
+    .idProduct = USB_PID,
+    .bcdDevice = 0x0100,
+    .iManufacturer = STRID_FABRICANTE,
+    .iProduct = STRID_PRODUTO,
+    .iSerialNumber = STRID_SERIAL,
+    .bNumConfigurations = 1};
+
+static const uint8_t descritor_configuracao[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0, 100),
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, STRID_CDC, EPNUM_CDC_NOTIF, 8,
+                       EPNUM_CDC_OUT, EPNUM_CDC_IN, 64),
+    // Microfone: 16 bits por amostra, todos significativos
+    TUD_AUDIO_MIC_ONE_CH_DESCRIPTOR(
+        ITF_NUM_AUDIO_CONTROL, STRID_AUDIO,
+        CFG_TUD_AUDIO_FUNC_1_N_BYTES_PER_SAMPLE_TX,
+        CFG_TUD_AUDIO_FUNC_1_N_BYTES_PER_SAMPLE_TX * 8, EPNUM_AUDIO_IN,
+        CFG_TUD_AUDIO_EP_SZ_IN),
+    TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, STRID_MSC, EPNUM_MSC_OUT, EPNUM_MSC_IN,
+                       64),
+};
+
+static const char *textos[] = {
+    [STRID_FABRICANTE] = "BitDogLab",
+    [STRID_PRODUTO] = "Medidor de Ruido",
+    [STRID_SERIAL] = NULL,  // Número único da flash
+    [STRID_CDC] = "Fluxo de medicoes",
+    [STRID_AUDIO] = "Microfone do medidor",
+    [STRID_MSC] = "Log de medicoes",
+};
+
+const uint8_t *tud_descriptor_device_cb(void) {
+  return (const uint8_t *)&descritor_dispositivo;
+}
+
+const uint8_t *tud_descriptor_configuration_cb(uint8_t indice) {
+  (void)indice;
+  return descritor_configuracao;
+}
+
+// Converte o texto pedido para UTF-16 num buffer estático
+const uint16_t *tud_descriptor_string_cb(uint8_t indice, uint16_t idioma) {
+  static uint16_t descritor[32];
+  char serial[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+  const char *texto;
+  (void)idioma;
+
+  if (indice == STRID_LANGID) {
+    descritor[1] = 0x0409;  // Inglês (EUA)
+    descritor[0] = (TUSB_DESC_STRING << 8) | 4;
+    return descritor;
+  }
+  if (indice >= count_of(textos)) return NULL;
+
+  if (indice == STRID_SERIAL) {
+    pico_get_unique_board_id_string(serial, sizeof(serial));
+    texto = serial;
+  } else {
+    texto = textos[indice];
+  }
+
+  size_t n = strlen(texto);
+  if (n > count_of(descritor) - 1) n = count_of(descritor) - 1;
+  for (size_t i = 0; i < n; i++) descritor[1 + i] = texto[i];
+  descritor[0] = (TUSB_DESC_STRING << 8) | (2 * n + 2);
+  return descritor;
+}
@@ -0,0 +1,142 @@
+#include "usb_fluxo.h"
+
+#include "hardware/irq.h"
+#include "tusb.h"
+#include "usb_protocolo.h"
+
+// Fluxo binário de medições pela interface USB CDC. Os pacotes são montados
+// sem printf: o cabeçalho é escrito no buffer de envio do CDC e a carga vem
+// direto do bloco do anel da aquisição, antes de ele ser liberado. Se não
+// houver espaço para o pacote inteiro ele é descartado, mas consome o número
+// de sequência, para o host contar a perda.
+//
+// A pilha (tud_task) roda numa interrupção de usuário de prioridade mínima,
+// sinalizada ao fim de cada interrupção do controlador USB, como faz o
+// stdio_usb do SDK: o endpoint isócrono do microfone é rearmado a cada
+// quadro de 1 ms mesmo durante o envio do display ou a FFT. O laço principal
+// só chama a pilha com essa interrupção mascarada (usb_fluxo_pausar); o
+// pedido que chegar nesse meio tempo fica pendente e roda ao retomar. A
+// única lacuna que resta é a escrita na flash, que desliga as interrupções
+// do core0: durante um apagamento de setor (dezenas de ms) o host não recebe
+// pacotes, e as amostras esperam na fila de usb_audio.c
+
+static uint32_t sequencia = 0;
+static uint32_t descartados = 0;
+static bool conectado = false;
+static bool audio_ligado = false;  // Blocos de áudio só a pedido do host
+static bool estado_pedido = false;  // Pacote de estado pendente
+static uint irq_tarefa;  // Interrupção de usuário que executa tud_task
+static uint32_t pausas = 0;  // Aninhamento de usb_fluxo_pausar
+
+static void tarefa_usb(void) { tud_task(); }
+
+// Executa depois do tratador do TinyUSB, na mesma interrupção
+static void sinalizar_tarefa(void) { irq_set_pending(irq_tarefa); }
+
+// Inicia a pilha USB (dispositivo composto definido em usb_descritores.c) e
+// a interrupção que a atende
+void usb_fluxo_iniciar(void) {
+  tusb_init();
+
+  irq_tarefa = user_irq_claim_unused(true);
+  irq_set_exclusive_handler(irq_tarefa, tarefa_usb);
+  irq_set_priority(irq_tarefa, PICO_LOWEST_IRQ_PRIORITY);
+  irq_set_enabled(irq_tarefa, true);
+  irq_add_shared_handler(USBCTRL_IRQ, sinalizar_tarefa,
+                         PICO_SHARED_IRQ_HANDLER_LOWEST_ORDER_PRIORITY);
+  irq_set_pending(irq_tarefa);
+}
+
+// Impede que tud_task interrompa o laço principal. Necessário em volta de
+// chamadas à pilha e de alterações em dados lidos pelos callbacks USB (o log
+// de medições, lido pelo disco MSC). Pode ser aninhada
+void usb_fluxo_pausar(void) {
+  if (pausas++ == 0) irq_set_enabled(irq_tarefa, false);
+}
+
+void usb_fluxo_retomar(void) {
+  if (--pausas == 0) irq_set_enabled(irq_tarefa, true);
+}
+
+// Atende os comandos do host e detecta a conexão. A pilha em si roda por
+// interrupção; basta chamar esta função a cada quadro do laço principal
+void usb_fluxo_processar(void) {
+  usb_fluxo_pausar();
+
+  // Uma nova conexão (DTR) reinicia a sequência, desliga o áudio e pede o
+  // pacote de estado
+  bool agora_conectado = tud_cdc_connected();
+  if (agora_conectado && !conectado) {
+    sequencia = 0;
+    audio_ligado = false;
+    estado_pedido = true;
+  }
+  conectado = agora_conectado;
+
+  while (tud_cdc_available()) {
+    int32_t comando = tud_cdc_read_char();
+    if (comando == USB_COMANDO_AUDIO_LIGAR) audio_ligado = true;
+    if (comando == USB_COMANDO_AUDIO_DESLIGAR) audio_ligado = false;
+    if (comando == USB_COMANDO_ESTADO) estado_pedido = true;
+  }
+
+  usb_fluxo_retomar();
+}
+
+static void usb_fluxo_enviar(uint8_t tipo, uint8_t sobreamostragem,
+                             uint64_t instante_us, const void *carga,
+                             uint16_t tamanho) {
+  if (!conectado) return;
+
+  usb_pacote_t cabecalho = {.sincronismo = USB_PACOTE_SINCRONISMO,
+                            .tipo = tipo,
+                            .sobreamostragem = sobreamostragem,
+                            .tamanho = tamanho,
+                            .reservado = 0,
+                            .sequencia = sequencia++,
+                            .instante_us = instante_us};
+  usb_fluxo_pausar();
+  if (tud_cdc_write_available() < sizeof(cabecalho) + tamanho) {
+    descartados++;
+  } else {
+    tud_cdc_write(&cabecalho, sizeof(cabecalho));
+    tud_cdc_write(carga, tamanho);
+    tud_cdc_write_flush();
+  }
+  usb_fluxo_retomar();
+}
+
+// Envia o nível (dB) de uma janela concluída
+void usb_fluxo_nivel(float db, uint64_t instante_us) {
+  usb_fluxo_enviar(USB_PACOTE_NIVEL, 1, instante_us, &db, sizeof(db));
+}
+
+// Envia um bloco de áudio bruto, se o host pediu (USB_COMANDO_AUDIO_LIGAR)
+void usb_fluxo_audio(const aq_bloco_t *bloco) {
+  if (!audio_ligado) return;
+  usb_fluxo_enviar(USB_PACOTE_AUDIO, aquisicao_sobreamostragem(),
+                   bloco->instante_us, bloco->amostras,
+                   sizeof(bloco->amostras));
+}
+
+// Envia um evento de alerta encerrado
+void usb_fluxo_evento(const usb_evento_t *evento, uint64_t instante_us) {
+  usb_fluxo_enviar(USB_PACOTE_EVENTO, 1, instante_us, evento, sizeof(*evento));
+}
+
+// Indica (uma vez) que o host conectou ou pediu o estado: quem chama monta
+// o usb_estado_t e o entrega a usb_fluxo_estado
+bool usb_fluxo_estado_pedido(void) {
+  bool pedido = estado_pedido && conectado;
+  if (pedido) estado_pedido = false;
+  return pedido;
+}
+
+// Envia o estado do medidor (aquisição, calibração, log e display)
+void usb_fluxo_estado(const usb_estado_t *estado) {
+  usb_fluxo_enviar(USB_PACOTE_ESTADO, 1, time_us_64(), estado,
+                   sizeof(*estado));
+}
+
+// Pacotes descartados por falta de espaço no buffer de envio
+uint32_t usb_fluxo_descartados(void) { return descartados; }
@@ -0,0 +1,21 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aquisicao.h"
+#include "usb_protocolo.h"
+
+#ifndef usb_fluxo_inc_h
+#define usb_fluxo_inc_h
+
+extern void usb_fluxo_iniciar(void);
+extern void usb_fluxo_pausar(void);
+extern void usb_fluxo_retomar(void);
+extern void usb_fluxo_processar(void);
+extern void usb_fluxo_nivel(float db, uint64_t instante_us);
+extern void usb_fluxo_audio(const aq_bloco_t *bloco);
+extern void usb_fluxo_evento(const usb_evento_t *evento, uint64_t instante_us);
+extern bool usb_fluxo_estado_pedido(void);
+extern void usb_fluxo_estado(const usb_estado_t *estado);
+extern uint32_t usb_fluxo_descartados(void);
+
+#endif
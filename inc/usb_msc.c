@@ -0,0 +1,417 @@
+#include "usb_msc.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "medicoes.h"
+#include "pico/unique_id.h"
+#include "tusb.h"
+
+// Disco USB (MSC) somente leitura com o histórico de medições. Nada do disco
+// existe na memória: cada setor pedido pelo host é gerado na hora, a partir
+// da geometria fixa abaixo e dos blocos comprimidos do log na flash.
+//
+//   setor 0            setor de boot (BPB FAT12)
+//   INICIO_FAT         FAT, cadeias contíguas dos dois arquivos
+//   INICIO_RAIZ        diretório raiz: rótulo, LEIAME.TXT e MEDICOES.CSV
+//   INICIO_DADOS       cluster 2: LEIAME.TXT; cluster 3 em diante: o CSV
+//
+// Na montagem é feito um retrato do log: posição da página mais antiga,
+// quantidade de registros de cada página (1 byte por página) e uma cópia das
+// páginas que ainda estão na RAM. O tamanho do CSV fica fixo até o host
+// desmontar o disco, mesmo que o log continue crescendo. Se uma página do
+// retrato for sobrescrita pelo anel durante a leitura, as linhas dela saem em
+// branco, preservando a posição das demais
+
+#define INICIO_FAT 1
+#define SETORES_FAT 7
+#define INICIO_RAIZ (INICIO_FAT + SETORES_FAT)
+#define ENTRADAS_RAIZ (USB_MSC_SETOR / 32)
+#define INICIO_DADOS (INICIO_RAIZ + 1)
+#define CLUSTERS \
+  ((USB_MSC_SETORES - INICIO_DADOS) / USB_MSC_SETORES_POR_CLUSTER)
+#define CLUSTER_BYTES (USB_MSC_SETORES_POR_CLUSTER * USB_MSC_SETOR)
+
+#define CLUSTER_LEIAME 2
+#define CLUSTER_CSV 3
+#define FAT12_FIM 0xFFF
+
+// Páginas do retrato: as do anel e as pendentes na RAM
+#define PAGINAS_RETRATO (MEDICOES_PAGINAS_TOTAL + MEDICOES_PENDENTES_MAX)
+#define CSV_MAX \
+  ((uint32_t)USB_MSC_LINHA * (1 + PAGINAS_RETRATO * CODEC_REGISTROS_MAX))
+
+static_assert(CLUSTERS < 4085, "o disco precisa ser FAT12");
+static_assert((CLUSTERS + 2) * 3 / 2 <= SETORES_FAT * USB_MSC_SETOR,
+              "FAT12 não cabe nos setores reservados");
+static_assert(CSV_MAX <= (CLUSTERS - 1) * (uint32_t)CLUSTER_BYTES,
+              "o CSV do log inteiro não cabe no disco");
+static_assert(USB_MSC_SETOR % USB_MSC_LINHA == 0,
+              "linhas não podem cruzar setores");
+
+// O medidor não tem relógio: os arquivos levam uma data fixa (1/1/2025)
+#define DATA_FAT (((2025 - 1980) << 9) | (1 << 5) | 1)
+
+static const char cabecalho_csv[USB_MSC_LINHA + 1] =
+    "sessao,minuto,leq,lmax,alertas\r\n";
+
+// Retrato do log
+static bool preparado = false;
+static bool ejetado = false;
+static uint32_t pagina_antiga = 0;
+static uint32_t paginas = 0;          // Do anel, seguidas das pendentes
+static uint32_t paginas_anel = 0;
+static uint32_t sequencia_limite = 0;
+static uint32_t registros = 0;
+static uint8_t quantidade[PAGINAS_RETRATO];
+static uint8_t pendentes[MEDICOES_PENDENTES_MAX][CODEC_BLOCO_TAMANHO];
+static char leiame[USB_MSC_SETOR];
+static uint32_t leiame_tamanho = 0;
+
+// Cursor da leitura sequencial: página decodificada e registros anteriores
+static uint32_t cursor_pagina = 0;
+static uint32_t cursor_antes = 0;
+static int cursor_validos = -1;  // -1: página ainda não decodificada
+static medicao_t cursor_registros[CODEC_REGISTROS_MAX];
+
+// --------------------------------------------------------------------------
+// Retrato do log
+// --------------------------------------------------------------------------
+
+static const uint8_t *bloco_retrato(uint32_t pagina) {
+  if (pagina < paginas_anel) return medicoes_bloco(pagina_antiga + pagina);
+  return pendentes[pagina - paginas_anel];
+}
+
+static void tirar_retrato(void) {
+  codec_cabecalho_t cabecalho;
+  uint16_t sessao_inicial = 0, sessao_final = 0;
+  bool primeira = true;
+
+  pagina_antiga = medicoes_pagina_antiga();
+  paginas_anel = medicoes_paginas();
+  sequencia_limite = medicoes_proxima_sequencia();
+  paginas = paginas_anel + medicoes_pendentes(pendentes);
+
+  registros = 0;
+  for (uint32_t p = 0; p < paginas; p++) {
+    quantidade[p] = 0;
+    if (!codec_ler_cabecalho(bloco_retrato(p), &cabecalho)) continue;
+    quantidade[p] = cabecalho.quantidade;
+    registros += cabecalho.quantidade;
+    if (primeira) sessao_inicial = cabecalho.sessao;
+    sessao_final = cabecalho.sessao;
+    primeira = false;
+  }
+
+  char serial[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+  pico_get_unique_board_id_string(serial, sizeof(serial));
+  int n = snprintf(
+      leiame, sizeof(leiame),
+      "Medidor de ruido %s\r\n"
+      "\r\n"
+      "MEDICOES.CSV: um registro por minuto, do mais antigo ao mais recente.\r\n"
+      "  sessao   numero do boot do medidor\r\n"
+      "  minuto   minutos desde o inicio da sessao\r\n"
+      "  leq      nivel equivalente do minuto (dB)\r\n"
+      "  lmax     maior nivel de janela no minuto (dB)\r\n"
+      "  alertas  alertas disparados no minuto\r\n"
+      "\r\n"
+      "Registros: %lu (sessoes %u a %u)\r\n"
+      "Retrato tirado na conexao; reconecte para atualizar.\r\n",
+      serial, (unsigned long)registros, sessao_inicial, sessao_final);
+  leiame_tamanho = n < (int)sizeof(leiame) ? n : (int)sizeof(leiame) - 1;
+
+  cursor_pagina = 0;
+  cursor_antes = 0;
+  cursor_validos = -1;
+  preparado = true;
+}
+
+static uint32_t csv_tamanho(void) {
+  return USB_MSC_LINHA * (1 + registros);
+}
+
+static uint32_t csv_clusters(void) {
+  return (csv_tamanho() + CLUSTER_BYTES - 1) / CLUSTER_BYTES;
+}
+
+// Busca o registro de índice dado. A leitura do host é quase sempre
+// sequencial: o cursor só avança, e volta ao início quando ela recua.
+// Retorna false se a página do registro foi sobrescrita após o retrato
+static bool buscar_registro(uint32_t indice, medicao_t *medicao) {
+  if (indice < cursor_antes) {
+    cursor_pagina = 0;
+    cursor_antes = 0;
+    cursor_validos = -1;
+  }
+  while (cursor_pagina < paginas &&
+         indice >= cursor_antes + quantidade[cursor_pagina]) {
+    cursor_antes += quantidade[cursor_pagina++];
+    cursor_validos = -1;
+  }
+  if (cursor_pagina >= paginas) return false;
+
+  if (cursor_validos < 0) {
+    // A página precisa ser a mesma do retrato: sequência anterior a ele e
+    // mesma quantidade de registros
+    const uint8_t *bloco = bloco_retrato(cursor_pagina);
+    codec_cabecalho_t cabecalho;
+    cursor_validos = 0;
+    if (codec_ler_cabecalho(bloco, &cabecalho) &&
+        cabecalho.quantidade == quantidade[cursor_pagina] &&
+        (cursor_pagina >= paginas_anel ||
+         cabecalho.sequencia < sequencia_limite)) {
+      int n = codec_decodificar(bloco, cursor_registros, CODEC_REGISTROS_MAX);
+      if (n > 0) cursor_validos = n;
+    }
+  }
+
+  uint32_t posicao = indice - cursor_antes;
+  if (posicao >= (uint32_t)cursor_validos) return false;
+  *medicao = cursor_registros[posicao];
+  return true;
+}
+
+// --------------------------------------------------------------------------
+// Geração dos setores
+// --------------------------------------------------------------------------
+
+// Escreve `valor` alinhado à direita em `largura` caracteres
+static char *campo(char *p, uint32_t valor, int largura) {
+  for (int i = largura - 1; i >= 0; i--) {
+    p[i] = (valor || i == largura - 1) ? '0' + valor % 10 : ' ';
+    valor /= 10;
+  }
+  return p + largura;
+}
+
+// Décimos de dB como "ddd.d" (5 caracteres)
+static char *decibeis(char *p, uint16_t ddb) {
+  if (ddb > 9999) ddb = 9999;
+  p = campo(p, ddb / 10, 3);
+  *p++ = '.';
+  *p++ = '0' + ddb % 10;
+  return p;
+}
+
+// Uma linha de USB_MSC_LINHA bytes:
+// "sssss,mmmmmmm,lll.l,xxx.x,aaaa\r\n"
+static void gerar_linha(char *linha, uint32_t indice) {
+  medicao_t m;
+  char *p = linha;
+
+  if (!buscar_registro(indice, &m)) {
+    memset(linha, ' ', USB_MSC_LINHA - 2);
+  } else {
+    p = campo(p, m.sessao, 5);
+    *p++ = ',';
+    p = campo(p, m.minuto > 9999999 ? 9999999 : m.minuto, 7);
+    *p++ = ',';
+    p = decibeis(p, m.leq_ddb);
+    *p++ = ',';
+    p = decibeis(p, m.lmax_ddb);
+    *p++ = ',';
+    campo(p, m.alertas > 9999 ? 9999 : m.alertas, 4);
+  }
+  linha[USB_MSC_LINHA - 2] = '\r';
+  linha[USB_MSC_LINHA - 1] = '\n';
+}
+
+static void gerar_boot(uint8_t *setor) {
+  static const uint8_t bpb[] = {
+      0xEB, 0x3C, 0x90,                        // Salto
+      'M', 'S', 'D', 'O', 'S', '5', '.', '0',  // OEM
+      USB_MSC_SETOR & 0xFF, USB_MSC_SETOR >> 8,
+      USB_MSC_SETORES_POR_CLUSTER,
+      INICIO_FAT, 0,                           // Setores reservados
+      1,                                       // Uma FAT
+      ENTRADAS_RAIZ, 0,
+      USB_MSC_SETORES & 0xFF, USB_MSC_SETORES >> 8,
+      0xF8,                                    // Disco fixo
+      SETORES_FAT, 0,
+      1, 0, 1, 0,                              // Setores/trilha, cabeças
+      0, 0, 0, 0,                              // Setores ocultos
+      0, 0, 0, 0,                              // Total de 32 bits (não usado)
+      0x80, 0, 0x29,                           // Unidade, assinatura estendida
+      0x4C, 0x4F, 0x47, 0x5A,                  // Número de série do volume
+      'M', 'E', 'D', 'I', 'D', 'O', 'R', ' ', ' ', ' ', ' ',
+      'F', 'A', 'T', '1', '2', ' ', ' ', ' '};
+  memcpy(setor, bpb, sizeof(bpb));
+  setor[510] = 0x55;
+  setor[511] = 0xAA;
+}
+
+// Entrada n da FAT: LEIAME.TXT ocupa um cluster e o CSV uma cadeia contígua
+static uint16_t entrada_fat(uint32_t n) {
+  uint32_t fim_csv = CLUSTER_CSV + csv_clusters() - 1;
+  if (n == 0) return 0xFF8;  // Descritor de mídia
+  if (n == 1 || n == CLUSTER_LEIAME || n == fim_csv) return FAT12_FIM;
+  if (n >= CLUSTER_CSV && n < fim_csv) return n + 1;
+  return 0;
+}
+
+// Setor da FAT12: cada par de entradas ocupa 3 bytes
+static void gerar_fat(uint8_t *setor, uint32_t indice) {
+  uint32_t inicio = indice * USB_MSC_SETOR;
+  for (uint32_t i = 0; i < USB_MSC_SETOR; i++) {
+    uint32_t byte = inicio + i;
+    uint32_t n = byte / 3 * 2;
+    uint16_t par = entrada_fat(n), impar = entrada_fat(n + 1);
+    switch (byte % 3) {
+      case 0: setor[i] = par & 0xFF; break;
+      case 1: setor[i] = (par >> 8) | ((impar & 0x0F) << 4); break;
+      default: setor[i] = impar >> 4; break;
+    }
+  }
+}
+
+static void entrada_diretorio(uint8_t *entrada, const char nome[11],
+                              uint8_t atributos, uint16_t cluster,
+                              uint32_t tamanho) {
+  memcpy(entrada, nome, 11);
+  entrada[11] = atributos;
+  entrada[16] = entrada[24] = DATA_FAT & 0xFF;  // Criação e modificação
+  entrada[17] = entrada[25] = DATA_FAT >> 8;
+  entrada[18] = DATA_FAT & 0xFF;  // Último acesso
+  entrada[19] = DATA_FAT >> 8;
+  entrada[26] = cluster & 0xFF;
+  entrada[27] = cluster >> 8;
+  memcpy(&entrada[28], &tamanho, sizeof(tamanho));
+}
+
+static void gerar_raiz(uint8_t *setor) {
+  entrada_diretorio(&setor[0], "MEDIDOR    ", 0x08, 0, 0);  // Rótulo
+  entrada_diretorio(&setor[32], "LEIAME  TXT", 0x01, CLUSTER_LEIAME,
+                    leiame_tamanho);
+  entrada_diretorio(&setor[64], "MEDICOESCSV", 0x01, CLUSTER_CSV,
+                    csv_tamanho());
+}
+
+// Setor `indice` do CSV: cabeçalho na primeira linha, um registro por linha
+static void gerar_csv(uint8_t *setor, uint32_t indice) {
+  uint32_t linha = indice * (USB_MSC_SETOR / USB_MSC_LINHA);
+  uint32_t linhas = 1 + registros;
+
+  for (uint32_t i = 0; i < USB_MSC_SETOR / USB_MSC_LINHA; i++, linha++) {
+    char *destino = (char *)&setor[i * USB_MSC_LINHA];
+    if (linha >= linhas) break;  // Resto do último cluster zerado
+    if (linha == 0) {
+      memcpy(destino, cabecalho_csv, USB_MSC_LINHA);
+    } else {
+      gerar_linha(destino, linha - 1);
+    }
+  }
+}
+
+static void gerar_setor(uint8_t *setor, uint32_t lba) {
+  memset(setor, 0, USB_MSC_SETOR);
+  if (lba == 0) {
+    gerar_boot(setor);
+  } else if (lba < INICIO_RAIZ) {
+    gerar_fat(setor, lba - INICIO_FAT);
+  } else if (lba < INICIO_DADOS) {
+    gerar_raiz(setor);
+  } else {
+    uint32_t relativo = lba - INICIO_DADOS;
+    uint32_t cluster =
+        CLUSTER_LEIAME + relativo / USB_MSC_SETORES_POR_CLUSTER;
+    if (cluster == CLUSTER_LEIAME) {
+      if (relativo == 0) memcpy(setor, leiame, leiame_tamanho);
+    } else if (cluster < CLUSTER_CSV + csv_clusters()) {
+      gerar_csv(setor, relativo - USB_MSC_SETORES_POR_CLUSTER);
+    }
+  }
+}
+
+// --------------------------------------------------------------------------
+// Callbacks da classe MSC (tud_task)
+// --------------------------------------------------------------------------
+
+// Uma nova enumeração tira um novo retrato no primeiro acesso
+void tud_mount_cb(void) {
+  preparado = false;
+  ejetado = false;
+}
+
+void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8],
+                        uint8_t product_id[16], uint8_t product_rev[4]) {
+  (void)lun;
+  memcpy(vendor_id, "BitDog  ", 8);
+  memcpy(product_id, "Log de medicoes ", 16);
+  memcpy(product_rev, "1.0 ", 4);
+}
+
+bool tud_msc_test_unit_ready_cb(uint8_t lun) {
+  (void)lun;
+  if (ejetado) {
+    tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00);
+    return false;
+  }
+  if (!preparado) tirar_retrato();
+  return true;
+}
+
+void tud_msc_capacity_cb(uint8_t lun, uint32_t *block_count,
+                         uint16_t *block_size) {
+  (void)lun;
+  *block_count = USB_MSC_SETORES;
+  *block_size = USB_MSC_SETOR;
+}
+
+bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start,
+                           bool load_eject) {
+  (void)lun;
+  (void)power_condition;
+  if (load_eject) ejetado = !start;
+  return true;
+}
+
+bool tud_msc_is_writable_cb(uint8_t lun) {
+  (void)lun;
+  return false;
+}
+
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset,
+                          void *buffer, uint32_t bufsize) {
+  static uint8_t setor[USB_MSC_SETOR];
+  uint8_t *destino = buffer;
+  uint32_t restante = bufsize;
+  (void)lun;
+
+  if (!preparado) tirar_retrato();
+  lba += offset / USB_MSC_SETOR;
+  offset %= USB_MSC_SETOR;
+  while (restante > 0) {
+    if (lba >= USB_MSC_SETORES) return -1;
+    gerar_setor(setor, lba++);
+    uint32_t n = USB_MSC_SETOR - offset;
+    if (n > restante) n = restante;
+    memcpy(destino, &setor[offset], n);
+    destino += n;
+    restante -= n;
+    offset = 0;
+  }
+  return (int32_t)bufsize;
+}
+
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset,
+                           uint8_t *buffer, uint32_t bufsize) {
+  (void)lba;
+  (void)offset;
+  (void)buffer;
+  (void)bufsize;
+  tud_msc_set_sense(lun, SCSI_SENSE_DATA_PROTECT, 0x27, 0x00);
+  return -1;
+}
+
+// Demais comandos SCSI: aceita a trava de remoção, recusa o resto
+int32_t tud_msc_scsi_cb(uint8_t lun, uint8_t const scsi_cmd[16],
+                        void *buffer, uint16_t bufsize) {
+  (void)buffer;
+  (void)bufsize;
+  if (scsi_cmd[0] == SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL) return 0;
+  tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);
+  return -1;
+}
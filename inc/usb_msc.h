@@ -0,0 +1,14 @@
+#ifndef usb_msc_inc_h
+#define usb_msc_inc_h
+
+// Disco virtual FAT12 somente leitura: 8 MiB em setores de 512 bytes e
+// clusters de 4 KiB, suficiente para o CSV do log inteiro
+#define USB_MSC_SETOR 512
+#define USB_MSC_SETORES 16384
+#define USB_MSC_SETORES_POR_CLUSTER 8
+
+// Linhas do CSV com largura fixa: a posição de cada registro no arquivo é
+// calculada sem percorrer o texto
+#define USB_MSC_LINHA 32
+
+#endif
@@ -0,0 +1,55 @@
+#include <stdint.h>
+
+#ifndef usb_protocolo_inc_h
+#define usb_protocolo_inc_h
+
+// Protocolo binário do fluxo USB CDC (compartilhado com o receptor do host).
+// Cada pacote é um usb_pacote_t seguido de `tamanho` bytes de carga, tudo em
+// little-endian. A sequência é contínua entre todos os tipos de pacote: uma
+// lacuna indica pacotes descartados por falta de espaço no buffer de envio
+
+#define USB_PACOTE_SINCRONISMO 0x5AA5u  // Bytes A5 5A no início do pacote
+#define USB_PACOTE_NIVEL 1  // Carga: float com o nível da janela (dB)
+#define USB_PACOTE_AUDIO 2  // Carga: bloco de amostras uint16 do ADC
+#define USB_PACOTE_EVENTO 3  // Carga: usb_evento_t de um alerta encerrado
+#define USB_PACOTE_ESTADO 4  // Carga: usb_estado_t (na conexão e a pedido)
+
+// Comandos de um byte enviados pelo host
+#define USB_COMANDO_AUDIO_LIGAR 'A'
+#define USB_COMANDO_AUDIO_DESLIGAR 'a'
+#define USB_COMANDO_ESTADO 'E'  // Pede um novo pacote de estado
+
+typedef struct __attribute__((packed)) {
+  uint16_t sincronismo;   // USB_PACOTE_SINCRONISMO
+  uint8_t tipo;           // USB_PACOTE_*
+  uint8_t sobreamostragem;  // Conversões somadas em cada amostra de áudio
+  uint16_t tamanho;       // Bytes de carga após o cabeçalho
+  uint16_t reservado;
+  uint32_t sequencia;     // Número do pacote desde a conexão
+  uint64_t instante_us;   // Fim da janela ou do bloco (relógio do RP2040)
+} usb_pacote_t;
+
+typedef struct __attribute__((packed)) {
+  char regra[12];         // Nome da regra (sem terminador se ocupar os 12)
+  uint32_t inicio_ms;     // Primeira leitura acima do limite (desde o boot)
+  uint32_t duracao_ms;
+  float pico_db;
+  float exposicao_db;     // Leq do evento
+} usb_evento_t;
+
+typedef struct __attribute__((packed)) {
+  float taxa_nominal_hz;  // Taxa de amostragem do ADC
+  float taxa_medida_hz;
+  uint32_t amostras_janela;
+  uint8_t sobreamostragem;
+  uint8_t display_presente;  // 0: o painel não respondeu na inicialização
+  uint16_t sessao_log;
+  uint32_t registros_log;  // Registros de minuto na flash
+  float piso_ruido_db;     // NaN se o piso do ADC não foi caracterizado
+  float offset_dc;         // Contagens do ADC
+  uint32_t i2c_khz;        // Clock do display escolhido na calibração
+  uint32_t i2c_max_khz;    // Maior clock estável encontrado
+  float display_fps;
+} usb_estado_t;
+
+#endif